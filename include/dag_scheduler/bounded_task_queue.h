@@ -0,0 +1,176 @@
+#ifndef BOUNDED_TASK_QUEUE_H_INCLUDED
+#define BOUNDED_TASK_QUEUE_H_INCLUDED
+
+#include "dag_scheduler/event_count.h"
+#include "dag_scheduler/task.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+
+namespace com {
+  namespace dag_scheduler {
+    /**
+     * @brief A bounded, lock free, multi producer multi consumer queue of
+     *        \ref Task (s).
+     *
+     * A ring of slots, each with a sequence number that says whether it
+     * is free for the next push or holds the next pop, after Dmitry
+     * Vyukov's bounded MPMC queue. A push or a pop claims its slot with
+     * one compare and swap on its own end of the ring, so producers and
+     * consumers do not contend with each other.
+     *
+     * Consumers only sleep when the queue is empty, and producers only
+     * when it is full, each on an \ref EventCount. A push wakes one
+     * waiting consumer, and only if there is one.
+     *
+     * Unlike \ref ConcurrentTaskQueue, the order is strictly FIFO:
+     * \ref Task::priority is not looked at.
+     */
+    class BoundedTaskQueue {
+    public:
+      /**
+       * @brief The capacity a queue has, by default.
+       */
+      static constexpr std::size_t default_capacity = 1024;
+
+    public:
+      /**
+       * @brief ctor
+       *
+       * @param[in] capacity How many \ref Task (s) fit, rounded up to a
+       *                     power of two of at least 2.
+       */
+      explicit BoundedTaskQueue(std::size_t capacity = default_capacity);
+
+      /**
+       * @brief dtor. Drops the \ref Task (s) still on the queue.
+       */
+      ~BoundedTaskQueue();
+
+      BoundedTaskQueue(const BoundedTaskQueue &) = delete;
+
+      BoundedTaskQueue &operator=(const BoundedTaskQueue &) = delete;
+
+      BoundedTaskQueue(BoundedTaskQueue &&) = delete;
+
+      BoundedTaskQueue &operator=(BoundedTaskQueue &&) = delete;
+
+      /**
+       * @brief A getter for how many \ref Task (s) fit.
+       *
+       * @return The capacity, after rounding.
+       */
+      std::size_t capacity() const;
+
+      /**
+       * @brief A function to check how many items are on the queue.
+       *
+       * WARNING: Only a snapshot, which may be stale on return while
+       * other threads push or pop.
+       *
+       * @return The number of \ref Task (s) on the queue.
+       */
+      std::size_t size() const;
+
+      /**
+       * @brief A function that checks to see if the queue has data in it.
+       *
+       * WARNING: Like \ref size, only a snapshot.
+       *
+       * @return true if the queue was empty.
+       */
+      bool empty() const;
+
+      /**
+       * @brief Push \p data if there is room.
+       *
+       * @param[in,out] data The \ref Task to push. Left as it was if the
+       *                     queue is full.
+       *
+       * @return false if the queue was full.
+       */
+      bool try_push(std::unique_ptr<Task> &&data);
+
+      /**
+       * @brief Push \p data, sleeping while the queue is full.
+       *
+       * @param[in] data The \ref Task to push.
+       */
+      void push(std::unique_ptr<Task> &&data);
+
+      /**
+       * @brief Pop the oldest \ref Task if the queue is not empty.
+       *
+       * @param[out] popped_value Assigned the \ref Task popped.
+       *
+       * @return true if queue was not empty and item was removed.
+       */
+      bool try_pop(std::unique_ptr<Task> &popped_value);
+
+      /**
+       * @brief Pop the oldest \ref Task, sleeping while the queue is
+       *        empty.
+       *
+       * WARNING: Will block indefinetly if nothing is pushed.
+       *
+       * @return The \ref Task popped.
+       */
+      std::unique_ptr<Task> wait_and_pop();
+
+      /**
+       * @brief Pop the oldest \ref Task, sleeping up to \p wait_duration
+       *        while the queue is empty.
+       *
+       * @tparam Rep The type for the count of ticks.
+       * @tparam Period A compile-time rational constant representing the
+       *                number of seconds from one tick to the next.
+       * @param popped_value[out] Assigned the \ref Task popped.
+       * @param wait_duration[in] How long to wait for one.
+       *
+       * @return "true" if queue was not empty and item was removed.
+       */
+      template <typename Rep, typename Period>
+      bool wait_for_and_pop(
+        std::unique_ptr<Task> &popped_value,
+        const std::chrono::duration<Rep, Period> &wait_duration
+      ) {
+        return wait_until_and_pop(
+          popped_value,
+          std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              wait_duration
+            )
+        );
+      }
+
+      /**
+       * @brief A function that empties the contents of the queue.
+       */
+      void clear();
+
+    private:
+      struct Cell {
+        std::atomic<std::size_t> sequence;
+        Task *task;
+      };
+
+      bool wait_until_and_pop(
+        std::unique_ptr<Task> &popped_value,
+        const std::chrono::steady_clock::time_point &deadline
+      );
+
+    private:
+      // Each end on a cache line of its own, so producers and consumers
+      // do not invalidate each other's.
+      alignas(64) std::atomic<std::size_t> push_at_;
+      alignas(64) std::atomic<std::size_t> pop_at_;
+      alignas(64) const std::size_t mask_;
+      std::unique_ptr<Cell[]> cells_;
+      EventCount not_empty_;
+      EventCount not_full_;
+    };
+  } // namespace dag_scheduler
+} // namespace com
+#endif
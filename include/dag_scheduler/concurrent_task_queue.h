@@ -53,6 +53,9 @@ namespace com {
        *
        * A member function of \ref ConcurrentTaskQueue<Task> that pushes
        * a instance of \ref task onto the queue FIFO thread safe manner.
+       * A \ref task with a higher \ref Task::priority is placed ahead of
+       * those with a lower one, so it is popped first. Among equal
+       * priorities the order stays FIFO.
        *
        * @param[in] data The \ref task to push onto the queue.
        */
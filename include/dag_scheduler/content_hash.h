@@ -0,0 +1,71 @@
+#ifndef CONTENT_HASH_H_INCLUDED
+#define CONTENT_HASH_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+
+#include <rapidjson/document.h>
+
+namespace com {
+  namespace dag_scheduler {
+    /**
+     * @brief A 64 bit FNV-1a hash built up one field at a time.
+     *
+     * Unlike std::hash the value is the same in every process and on
+     * every platform, so it can be stored and compared across runs. Each
+     * field is prefixed by its size so that the boundaries between fields
+     * are part of the hash.
+     */
+    class ContentHash {
+    public:
+      typedef std::uint64_t Value_t;
+
+    public:
+      /**
+       * @brief Add raw bytes, without a size prefix.
+       *
+       * @param[in] data The first byte to add.
+       * @param[in] size How many bytes to add.
+       */
+      void add(const char *data, std::size_t size);
+
+      /**
+       * @brief Add a string field.
+       *
+       * @param[in] field The string to add.
+       */
+      void add(const std::string &field);
+
+      /**
+       * @brief Add an integer field, least significant byte first.
+       *
+       * @param[in] field The integer to add.
+       */
+      void add(std::uint64_t field);
+
+      /**
+       * @brief A getter for the hash of everything added so far.
+       *
+       * @return The hash.
+       */
+      Value_t value() const;
+
+      /**
+       * @brief Write \p v as json with the members of every object sorted
+       *        by name.
+       *
+       * Documents that only differ in the order of their members give
+       * the same string.
+       *
+       * @param[in] v The json value to write.
+       *
+       * @return \p v as a string.
+       */
+      static std::string canonical_json(const rapidjson::Value &v);
+
+    private:
+      Value_t hash_ = 0xcbf29ce484222325ull;
+    };
+  } // namespace dag_scheduler
+} // namespace com
+#endif
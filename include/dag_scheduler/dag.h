@@ -1,16 +1,23 @@
 #ifndef DAG_H_INCLUDED
 #define DAG_H_INCLUDED
 
+#include "dag_scheduler/dag_edge.h"
+#include "dag_scheduler/dag_memory_pool.h"
 #include "dag_scheduler/dag_vertex.h"
+#include "dag_scheduler/label_pool.h"
 #include "dag_scheduler/logged_class.hpp"
 #include "dag_scheduler/uuid.h"
 
 #include <rapidjson/document.h>
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <gtest/gtest_prod.h>
@@ -31,6 +38,8 @@ namespace com {
   namespace dag_scheduler {
     class DAGEdge;
     class DAGVertex;
+    class FrozenDAG;
+    class ReachabilityIndex;
 
     /**
      * @brief A \class DAG that represents a directed acyclic graph.
@@ -40,7 +49,9 @@ namespace com {
      * \ref DAGVertex. Additionally you can connect two \ref DAGVertex.
      * Every connection checks to preserve that acyclic portion of the graph.
      * If any connection would make the graph acyclic then an exception is
-     * thrown and the connection is not made.
+     * thrown and the connection is not made. The check is done against a
+     * topological order that is maintained as edges are added, so only the
+     * vertices ordered between the two ends of a new edge are visited.
      */
     class DAG : public LoggedClass<DAG> {
     public:
@@ -165,6 +176,34 @@ namespace com {
        */
       bool add_vertex(DAGVertex &&v);
 
+      /**
+       * @brief Adds many \ref DAGVertex (s) and \ref DAGEdge (s) at once.
+       *
+       * A member function of \ref DAG that moves every \ref DAGVertex in
+       * \p vertices into the graph and then draws every edge in \p edges.
+       * Unlike calling \ref add_vertex and \ref connect in a loop, all of
+       * the input is validated with a single pass of Kahn's algorithm over
+       * the combined graph, so the cost is linear in the size of the result.
+       * Edges may reference vertices already in \ref this. A vertex whose
+       * \ref UUID is already in the graph is skipped, as are edges with an
+       * end that cannot be found and edges given twice or already drawn.
+       *
+       * @param[in] vertices The \ref DAGVertex (s) to add.
+       * @param[in] edges Pairs of \ref UUID (s), each a directed edge from
+       *                  first to second.
+       *
+       * @throws DAGException If the edges would make \ref this cyclic. The
+       *                      message lists every vertex that could not be
+       *                      ordered and \ref this is left unchanged.
+       *
+       * @return true if every vertex was added and every edge drawn, false
+       *         if any were skipped.
+       */
+      bool bulk_load(
+        std::vector<DAGVertex> &&vertices,
+        const std::vector<std::pair<UUID, UUID>> &edges
+      );
+
       /**
        * @brief Finds a \ref DAGVertex in the graph.
        *
@@ -186,7 +225,8 @@ namespace com {
        * A member function of \ref DAG that finds a \ref v in the graph
        * data structure and returns a \ref std::weak_ptr<DAGVertex> to
        * the original \ref DAGVertex stored in the graph based on its
-       * \ref UUID..
+       * \ref UUID.. The lookup goes through a hash index so its cost does
+       * not grow with the number of vertices in the graph.
        *
        * @param[in] u A \ref UUID used to find the the \ref DAG.
        *
@@ -263,7 +303,8 @@ namespace com {
        *
        * A member function of \ref DAG that checks if adding a \ref DAGEdge
        * between \ref DAGVertex \ref v1 and \ref DAGVertex \ref v2 would
-       * make \ref this a cylical grph.
+       * make \ref this a cylical grph. Neither the graph nor any
+       * \ref Task is copied to answer this.
        *
        * @param[in] v1 A \ref DAGVertex where the edge begins.
        * @param[in] v2 A \ref DAGVertex where the edge ends.
@@ -326,6 +367,29 @@ namespace com {
        */
       bool connect(const DAGVertex &v1, const DAGVertex &v2);
 
+      /**
+       * @brief A function to make a conditional directed connection between
+       *        two \ref DAGVertex.
+       *
+       * As \ref connect, but the \ref DAGEdge is only taken when
+       * \p condition accepts what the \ref Task of \p v1 did. A
+       * \ref DAGVertex none of whose incoming \ref DAGEdge (s) is taken is
+       * pruned by \ref DAGExecution along with what only it leads to.
+       * Conditions are kept by copies of \ref this but not serialized.
+       *
+       * @param[in] v1 The start \ref DAGVertex from where the \ref DAGEdge
+       *               begins.
+       * @param[in] v2 The end \ref DAGVertex from where the \ref DAGEdge
+       *               ends.
+       * @param[in] condition See \ref DAGEdge::Condition_t.
+       *
+       * @return true if the \ref DAGVertex were found and connected.
+       */
+      bool connect(
+        const DAGVertex &v1, const DAGVertex &v2,
+        DAGEdge::Condition_t condition
+      );
+
       /**
        * @brief A function to make a directed connection between to \ref
        *        DAGVertex
@@ -436,6 +500,46 @@ namespace com {
       bool
       all_are_connected_by_label(const std::string l1, const std::string l2);
 
+      /**
+       * @brief A function that checks if there is a path from \p v1 to
+       *        \p v2.
+       *
+       * A member function of \ref DAG that checks if following
+       * \ref DAGEdge (s) from \p v1 can lead to \p v2. The first query
+       * after \ref this changes builds a \ref ReachabilityIndex; later
+       * ones are answered from it in near constant time until the next
+       * change.
+       *
+       * @param[in] v1 The \ref DAGVertex the path starts from.
+       * @param[in] v2 The \ref DAGVertex the path ends at.
+       *
+       * @return true if \p v2 is downstream of \p v1. False if not, or if
+       *         either is not in \ref this.
+       */
+      bool is_reachable(const DAGVertex &v1, const DAGVertex &v2);
+
+      /**
+       * @brief Finds every \ref DAGVertex a path from \p v leads to.
+       *
+       * @param[in] v The \ref DAGVertex to start from.
+       *
+       * @return The \ref DAGVertex (s) downstream of \p v in the order
+       *         \ref linear_traversal visits them. Empty if \p v is not in
+       *         \ref this.
+       */
+      std::vector<std::weak_ptr<DAGVertex>> downstream_of(const DAGVertex &v);
+
+      /**
+       * @brief Finds every \ref DAGVertex with a path that leads to \p v.
+       *
+       * @param[in] v The \ref DAGVertex to end at.
+       *
+       * @return The \ref DAGVertex (s) upstream of \p v in the order
+       *         \ref linear_traversal visits them. Empty if \p v is not in
+       *         \ref this.
+       */
+      std::vector<std::weak_ptr<DAGVertex>> upstream_of(const DAGVertex &v);
+
       /**
        * @brief A function that calls user function with each \ref DAGVertex
        *
@@ -488,7 +592,9 @@ namespace com {
        *        \ref DAGEdges.
        *
        * A member function of \ref DAG that removes a \ref DAGVertex \ref v
-       * and all its \ref DAGEdge from an instance of \ref dag.
+       * and all its \ref DAGEdge from an instance of \ref dag. Edges that
+       * point at \ref v from its predecessors are removed as well, so the
+       * cost is proportional to the degree of \ref v.
        *
        * @param[in] v The \ref DAGVertex to find and remove.
        *
@@ -502,7 +608,8 @@ namespace com {
        *
        * A member function of \ref DAG that removes a \ref DAGVertex \ref v
        * based on its \ref UUID and all its \ref DAGEdge from an instance of
-       * \ref dag.
+       * \ref dag. Edges that point at \ref v from its predecessors are
+       * removed as well.
        *
        * @param[in] id The \ref UUID of a \ref DAGVertex to find and remove.
        *
@@ -530,10 +637,25 @@ namespace com {
        * @brief A function that clears a instance of \ref dag.
        *
        * A member function of \ref DAG that removes all \ref DAGEdge
-       * between all \ref DAGVertex in \ref this.
+       * between all \ref DAGVertex in \ref this. The memory they were
+       * allocated from is released in bulk once no \ref DAGVertex from
+       * \ref this is referenced elsewhere.
        */
       void reset();
 
+      /**
+       * @brief A getter for the memory held for the \ref DAGVertex (s) and
+       *        \ref DAGEdge (s) of \ref this.
+       *
+       * A member function of \ref DAG that reports on the
+       * \ref DAGMemoryPool that \ref DAGVertex (s) added to \ref this, and
+       * the \ref DAGEdge (s) drawn from them, are allocated from. The pool
+       * is replaced on \ref reset, so the report starts over then.
+       *
+       * @return The \ref DAGMemoryPool::Stats of the current pool.
+       */
+      DAGMemoryPool::Stats memory_stats() const;
+
       /**
        * @brief A getter for the json configuration passed into the \ref ctor.
        *
@@ -561,34 +683,149 @@ namespace com {
        * initial inputs of a task. To enable flexibility this member method
        * allows users to override any initial config specified at
        * construction.
+       *
+       * The \ref DAGVertex is marked dirty, see \ref mark_dirty.
        */
       void override_initial_input_for_vertex_task(
         const UUID &vertex_uuid, const rapidjson::Document &initial_input
       );
 
+      /**
+       * @brief Mark a \ref DAGVertex as changed since the last run.
+       *
+       * A member function of \ref DAG that records that the \ref Task of
+       * the \ref DAGVertex with \ref UUID \p vertex_uuid has to run again.
+       * \ref execute_dag_incremental re-runs the \ref DAGVertex (s) marked
+       * and everything downstream of them, and nothing else.
+       *
+       * @param[in] vertex_uuid The \ref UUID of the \ref DAGVertex.
+       *
+       * @return true if the \ref DAGVertex is in \ref this.
+       */
+      bool mark_dirty(const UUID &vertex_uuid);
+
+      /**
+       * @brief A getter for the \ref DAGVertex (s) marked dirty.
+       *
+       * @return The \ref DAGVertex (s) marked with \ref mark_dirty since
+       *         the last \ref clear_dirty that are still in \ref this.
+       */
+      std::vector<std::weak_ptr<DAGVertex>> dirty_vertices() const;
+
+      /**
+       * @brief Forget every \ref DAGVertex marked dirty.
+       */
+      void clear_dirty();
+
+      /**
+       * @brief A hash of the structure of \ref this.
+       *
+       * Covers the json configuration of \ref this and the
+       * \ref DAGVertex::structural_hash of each \ref DAGVertex without
+       * predecessors, which in turn cover every \ref DAGVertex below
+       * them. The title and the \ref UUID (s) are not covered, so two
+       * \ref DAG (s) built separately from the same description hash the
+       * same, which is what finding a duplicate submission needs.
+       *
+       * The hash is cached until a \ref DAGVertex or edge is added or
+       * removed, or a \ref DAGVertex is given new inputs. Only the
+       * \ref DAGVertex (s) upstream of a change are hashed again. A
+       * \ref Task changed through \ref DAGVertex::get_task directly is
+       * only seen once \ref mark_dirty is called for its \ref DAGVertex.
+       *
+       * @return A hash that is the same across processes for the same
+       *         structure.
+       */
+      std::uint64_t structural_hash() const;
+
     public:
       friend std::ostream &operator<<(std::ostream &out, const DAG &g);
+
+      /**
+       * @brief Compare two \ref DAG (s) by structure.
+       *
+       * Two \ref DAG (s) are equivalent if they have the same title, as
+       * many \ref DAGVertex (s) and \ref DAGEdge (s) and the same
+       * \ref structural_hash, which rules most out in O(1) once both
+       * hashes are cached. A match is then confirmed vertex by vertex,
+       * without hashes. \ref UUID (s) are not compared.
+       *
+       * @param[in] lhs The \ref DAG on the left hand side of the '=='.
+       * @param[in] rhs The \ref DAG on the right hand side of the '=='.
+       *
+       * @return true if \p lhs == \p rhs.
+       */
       friend bool operator==(const DAG &lhs, const DAG &rhs);
       friend bool operator!=(const DAG &lhs, const DAG &rhs);
 
     protected:
       std::shared_ptr<DAGVertex> get_vertex_at(std::size_t i);
       void clone_connections(DAGVertex &from, DAGVertex &to);
+      bool order_for_edge(
+        const DAGVertex &from, const DAGVertex &to, bool reorder
+      );
+      void place_in_topological_order(DAGVertex *v, std::size_t position);
+      void drop_from_topological_order(const DAGVertex *v);
+      void rebuild_topological_order();
+      void detach_vertex(const std::shared_ptr<DAGVertex> &v);
+      void unlink_vertex(const std::shared_ptr<DAGVertex> &v);
+      void index_label(const std::shared_ptr<DAGVertex> &v);
+      const ReachabilityIndex &reachability_index();
+      void topology_changed();
+      void unindex_label(const DAGVertex *v);
+      std::shared_ptr<DAGVertex> make_vertex(DAGVertex &&v);
+      void set_json_config(const rapidjson::Document &json_config);
+      void copy_from(const DAG &other);
 
       DAG(const DAG &other);
       DAG &operator=(const DAG &rhs);
 
     private:
       typedef std::vector<std::shared_ptr<DAGVertex>> DAG_t;
+      // Keys are clones of the vertex's UUID rather than references to it,
+      // since assigning to a DAGVertex rewrites its UUID in place.
+      typedef std::unordered_map<UUID, std::shared_ptr<DAGVertex>>
+        UUIDIndex_t;
+      typedef std::unordered_map<const DAGVertex *, std::size_t>
+        TopologicalIndex_t;
+      // Backs every vertex in graph_ and their edges. Each vertex holds a
+      // reference too, so vertices handed out can outlive this.
+      std::shared_ptr<DAGMemoryPool> memory_pool_;
       DAG_t graph_;
+      UUIDIndex_t uuid_index_;
+      // A topological order of graph_ that connect keeps valid one edge at
+      // a time. Removed vertices leave a nullptr hole until compacted.
+      std::vector<DAGVertex *> topological_order_;
+      TopologicalIndex_t topological_index_;
+      // Each distinct label of graph_ is kept once; label_index_[id] holds
+      // the vertices labelled id, in the order they appear in graph_.
+      LabelPool labels_;
+      std::vector<DAG_t> label_index_;
+      // Built on demand for path queries over a snapshot of graph_ and
+      // dropped whenever a vertex or edge is added or removed.
+      std::shared_ptr<const FrozenDAG> frozen_;
+      std::shared_ptr<const ReachabilityIndex> reachability_;
+      // The vertices to run again on the next incremental run.
+      std::unordered_set<UUID> dirty_;
       std::string title_;
-      std::unique_ptr<rapidjson::Document> json_config_;
+      // Replaced, never modified, once set, so copies can share it.
+      std::shared_ptr<const rapidjson::Document> json_config_;
+      // Dropped along with frozen_, and whenever a vertex gets new inputs.
+      mutable std::uint64_t structural_hash_ = 0;
+      mutable bool structural_hash_valid_ = false;
 
     private:
       FRIEND_TEST(TestDag, get_vertex_at);
       FRIEND_TEST(TestDag, clone_connections);
       FRIEND_TEST(TestDag, copy_ctor);
       FRIEND_TEST(TestDag, assignment_operator);
+      FRIEND_TEST(TestDag, connect_maintains_topological_order);
+      FRIEND_TEST(TestDag, bulk_load);
+      FRIEND_TEST(TestDag, memory_per_vertex_report);
+      FRIEND_TEST(TestDag, clone_shares_tasks);
+      FRIEND_TEST(TestDag, label_index);
+      FRIEND_TEST(TestDag, structural_hash_is_cached);
+      FRIEND_TEST(TestDag, remove_all_vertex_with_label_clears_dirty);
     };
   } // namespace dag_scheduler
 } // namespace com
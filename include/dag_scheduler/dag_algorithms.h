@@ -2,9 +2,13 @@
 #define DAG_ALGORITHMS_H_INCLUDED
 
 #include "dag_scheduler/dag.h"
+#include "dag_scheduler/dag_execution.h"
+#include "dag_scheduler/frozen_dag.h"
 #include "dag_scheduler/task_scheduler.h"
 
 #include <list>
+#include <memory>
+#include <vector>
 
 namespace com {
   namespace dag_scheduler {
@@ -31,7 +35,7 @@ namespace com {
      * A function that takes in a dag and returns a ordering of a directed
      * graph is a linear ordering of its vertices such that for every directed
      * \ref dag_edge uv from \ref DAGVertex u to \ref DAGVertex v, u comes
-     * before v in the ordering
+     * before v in the ordering. \p g is left as it was.
      *
      * @param[in] g The \ref dag to sort.
      * @param[out] sorted_vertices The topological sorted \ref DAGVertex
@@ -41,6 +45,145 @@ namespace com {
      */
     bool dag_topological_sort(DAG &g, std::list<DAGVertex> &sorted_vertices);
 
+    /**
+     * @brief Sorts the \ref DAGVertex (s) of a graph topologically without
+     *        copying or changing them.
+     *
+     * Runs Kahn's algorithm over a \ref FrozenDAG with a scratch copy of
+     * its in-degrees. The output doubles as the FIFO queue, so vertices
+     * come out level by level, each level in \ref DAG::linear_traversal
+     * order for its roots and \ref DAGEdge order after that. The scratch
+     * space is kept between calls, so sorting the same or a smaller graph
+     * again allocates nothing. A \ref TopologicalSorter must not be used
+     * by more than one thread at a time.
+     */
+    class TopologicalSorter {
+    public:
+      TopologicalSorter() = default;
+
+      /**
+       * @brief Sort the indices of \p plan.
+       *
+       * @param[in] plan The snapshot to sort.
+       * @param[out] order The indices of \p plan, each before every index
+       *                   it has a \ref DAGEdge to. If \p plan has a
+       *                   cycle only the vertices that could be ordered are
+       *                   in it.
+       *
+       * @return true if every vertex was ordered, false if \p plan has a
+       *         cycle.
+       */
+      bool sort(const FrozenDAG &plan, std::vector<FrozenDAG::Index> &order);
+
+      /**
+       * @brief Sort the \ref DAGVertex (s) of \p g.
+       *
+       * @param[in] g The \ref DAG to sort. It is not changed.
+       * @param[out] order Handles to the \ref DAGVertex (s) in \p g in a
+       *                   topological order, as for the other overload.
+       *
+       * @return true if every vertex was ordered, false if \p g has a
+       *         cycle.
+       */
+      bool sort(DAG &g, std::vector<std::shared_ptr<DAGVertex>> &order);
+
+    private:
+      std::vector<FrozenDAG::Index> in_degree_;
+      std::vector<FrozenDAG::Index> order_;
+    };
+
+    /**
+     * @brief The vertex count from which \ref dag_levels and
+     *        \ref upward_ranks use more than one thread by default.
+     *
+     * Below it, starting threads costs more than the sweep itself.
+     */
+    constexpr std::size_t parallel_vertex_threshold = 64 * 1024;
+
+    /**
+     * @brief Compute the level of every vertex of \p plan.
+     *
+     * The level of a vertex is the number of \ref DAGEdge (s) on the
+     * longest path to it from a vertex with no incomming \ref DAGEdge
+     * (s), so every vertex of a level can run once all lower levels have.
+     * The levels are found by sweeping frontiers from the roots: each
+     * vertex of a frontier is split between \p threads workers, which
+     * count down the in-degrees of its successors, and a successor joins
+     * the next frontier when its count reaches zero. That is O(V + E) in
+     * total, whatever the depth of \p plan.
+     *
+     * @param[in] plan The snapshot to level.
+     * @param[out] levels The level of each vertex, indexed like \p plan.
+     * @param[in] threads The number of threads to use. 0 picks one below
+     *                    \ref parallel_vertex_threshold vertices and
+     *                    \ref std::thread::hardware_concurrency above.
+     *
+     * @return false if \p plan has a cycle, in which case \p levels is
+     *         left empty.
+     */
+    bool dag_levels(
+      const FrozenDAG &plan, std::vector<FrozenDAG::Index> &levels,
+      std::size_t threads = 0
+    );
+
+    /**
+     * @brief Compute the upward rank of every vertex of \p plan.
+     *
+     * The upward rank of a vertex is its own cost plus the largest upward
+     * rank among its successors, that is the cost of the most expensive
+     * path from it to a sink. Running ready vertices highest rank first
+     * keeps the critical path moving, which shortens the makespan when
+     * there are more ready vertices than workers. Ranks are found by
+     * sweeping frontiers up from the sinks, as \ref dag_levels does down
+     * from the roots.
+     *
+     * @param[in] plan The snapshot to rank.
+     * @param[in] costs The cost of each vertex, indexed like \p plan.
+     * @param[out] ranks The upward rank of each vertex, indexed like
+     *                   \p plan.
+     * @param[in] threads The number of threads to use, as for
+     *                    \ref dag_levels.
+     *
+     * @return false if \p plan has a cycle, in which case \p ranks is
+     *         left empty.
+     */
+    bool upward_ranks(
+      const FrozenDAG &plan, const std::vector<double> &costs,
+      std::vector<double> &ranks, std::size_t threads = 0
+    );
+
+    /**
+     * @brief Find every vertex of \p plan reachable from \p seeds.
+     *
+     * @param[in] plan The snapshot to search.
+     * @param[in] seeds The indices to start from. They are part of the
+     *                  closure.
+     * @param[out] closure For each index of \p plan, true if it is in
+     *                     \p seeds or downstream of one.
+     *
+     * @return The number of vertices in the closure.
+     */
+    std::size_t downstream_closure(
+      const FrozenDAG &plan, const std::vector<FrozenDAG::Index> &seeds,
+      std::vector<bool> &closure
+    );
+
+    /**
+     * @brief Find the links of the maximal linear chains of \p plan.
+     *
+     * A vertex with exactly one successor is linked to it if it is also
+     * the only predecessor of that successor. Following the links from a
+     * vertex walks the rest of the chain it is on.
+     *
+     * @param[in] plan The snapshot to search.
+     * @param[out] next For each index of \p plan, the next vertex of its
+     *                  chain or \ref FrozenDAG::npos if it ends one.
+     *
+     * @return The number of links.
+     */
+    std::size_t
+    chain_links(const FrozenDAG &plan, std::vector<FrozenDAG::Index> &next);
+
     /**
      * @brief Takes a dag and processes in parallel all \ref DAGVertex that
      *        can be grouped by checking for all \ref DAGVertex with no
@@ -52,17 +195,85 @@ namespace com {
      * \ref dag_edge (s). Subsequently it removes them and continues on
      * until not \ref DAGVertex (s) are left in \ref g.
      *
+     * The batches are reported in \p out only. The \ref Task (s) are run
+     * by a \ref DAGExecution, which queues each one on \p scheduler once
+     * all of its predecessors have completed rather than a batch at a
+     * time.
+     *
      * @param[in] g The \ref dag to sort.
      * @param[out] out A \ref std::vector<\ref std::vector<\ref DAGVertex>>
      *                 which is an orderd set of collections that contain
      *                 a set of \ref DAGVertex which represents batches
      *                 of \ref DAGVertex (s) processed.
+     * @param[in] scheduler The \ref TaskScheduler to run the \ref Task (s)
+     *                      on.
      *
      * @return False if \ref g could not have all \ref DAGVertex (s)
      *         visited.
      */
     bool
     process_dag(DAG &g, processed_order_type &out, TaskScheduler &scheduler);
+
+    /**
+     * @brief Run the \ref Task (s) of \p g on \p scheduler in dependency
+     *        order.
+     *
+     * Each \ref Task is queued as soon as the \ref Task (s) of all of its
+     * predecessors have completed, see \ref DAGExecution.
+     *
+     * @param[in] g The \ref DAG to run. It must not be edited until the
+     *              run is finished.
+     * @param[in] scheduler The \ref TaskScheduler to run the \ref Task (s)
+     *                      on.
+     * @param[in] costs An optional \ref TaskCostModel. With one, ready
+     *                  \ref Task (s) on the critical path run first.
+     * @param[in] cache An optional \ref TaskResultCache. With one,
+     *                  \ref Task (s) that already succeeded with the same
+     *                  code and inputs are not run again.
+     * @param[in] fuse_chains If true, each linear chain of \p g goes
+     *                        through \p scheduler once and runs on one
+     *                        worker, see \ref DAGExecution.
+     *
+     * @return A handle to wait on the run, or nullptr if \p g is cyclic.
+     */
+    std::shared_ptr<DAGExecution> execute_dag(
+      DAG &g, TaskScheduler &scheduler,
+      std::shared_ptr<TaskCostModel> costs = nullptr,
+      std::shared_ptr<TaskResultCache> cache = nullptr,
+      bool fuse_chains = false
+    );
+
+    /**
+     * @brief Run again only the part of \p g that changed since
+     *        \p previous.
+     *
+     * The \ref DAGVertex (s) marked with \ref DAG::mark_dirty, or given
+     * new inputs with \ref DAG::override_initial_input_for_vertex_task,
+     * are run again together with everything downstream of them, see
+     * \ref DAGExecution::restart. The results of the rest of \p previous
+     * are reused. If vertices or edges were added to or removed from
+     * \p g since \p previous started all of \p g is run instead. Either
+     * way the dirty marks of \p g are cleared.
+     *
+     * @param[in] g The \ref DAG that \p previous ran. It must not be
+     *              edited until the run is finished.
+     * @param[in] scheduler The \ref TaskScheduler to run the \ref Task (s)
+     *                      on.
+     * @param[in] previous A finished run of \p g.
+     * @param[in] costs An optional \ref TaskCostModel, as for
+     *                  \ref execute_dag.
+     * @param[in] cache An optional \ref TaskResultCache, as for
+     *                  \ref execute_dag.
+     * @param[in] fuse_chains As for \ref execute_dag.
+     *
+     * @return A handle to wait on the run, or nullptr if \p g is cyclic.
+     */
+    std::shared_ptr<DAGExecution> execute_dag_incremental(
+      DAG &g, TaskScheduler &scheduler, const DAGExecution &previous,
+      std::shared_ptr<TaskCostModel> costs = nullptr,
+      std::shared_ptr<TaskResultCache> cache = nullptr,
+      bool fuse_chains = false
+    );
   } // namespace dag_scheduler
 } // namespace com
 
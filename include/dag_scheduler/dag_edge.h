@@ -4,7 +4,7 @@
 #include "dag_scheduler/dag_vertex.h"
 #include "dag_scheduler/uuid.h"
 
-#include <list>
+#include <functional>
 #include <memory>
 #include <ostream>
 #include <string>
@@ -20,19 +20,28 @@ namespace com {
      * A class that represents a directed edge in a acyclic graph (dag) and
      * operations that can be performed on it. Users can check for connected
      * \ref DAGVertex and get access to the connected \ref DAGVertex.
+     *
+     * An edge may have a \ref Condition_t, in which case it is only
+     * taken if the \ref Task of the \ref DAGVertex it leaves succeeds
+     * with a result the condition accepts, see \ref DAGExecution.
      */
     class DAGEdge {
     private:
       friend class DAG;
       friend class DAGVertex;
+      friend class FrozenDAG;
       friend struct DAGVertex::DAGVertex_connection;
-      friend bool
-      dag_topological_sort(DAG &g, std::list<DAGVertex> &sorted_vertices);
 
     public:
       // TODO: Use DAG class to manage status.
       enum class Status { initialized, traversed, non_traverable };
 
+      /**
+       * @brief Decides if an edge is taken, given the \ref Task that ran
+       *        for the \ref DAGVertex the edge leaves.
+       */
+      typedef std::function<bool(const Task &upstream)> Condition_t;
+
     public:
       /**
        * @brief A constructor for a \ref DAGEdge
@@ -120,6 +129,16 @@ namespace com {
       //! TODO (mhoggan): Add doc string once implemented.
       std::string current_status_as_string() const;
 
+      /**
+       * @brief A getter for the condition of \ref this.
+       *
+       * Clones of \ref this share it.
+       *
+       * @return The \ref Condition_t given to \ref DAG::connect, or nullptr
+       *         if \ref this is always taken.
+       */
+      std::shared_ptr<const Condition_t> condition() const;
+
     public:
       /**
        * @brief A stream operator for writting a \ref dag_egde to a stream.
@@ -165,6 +184,8 @@ namespace com {
 
     protected:
       bool connect_to(std::shared_ptr<DAGVertex> v);
+      void link();
+      void unlink();
       DAGEdge(const DAGEdge &other);
       DAGEdge &operator=(const DAGEdge &rhs);
 
@@ -172,6 +193,12 @@ namespace com {
       class UUID uuid_;
       Status current_status_;
       std::weak_ptr<DAGVertex> connection_;
+      // The vertex that owns this edge and the vertex it points to. Only
+      // set for edges owned by a DAGVertex; they keep the owner's
+      // successors_ and the target's predecessors_ in sync.
+      DAGVertex *source_;
+      DAGVertex *target_;
+      std::shared_ptr<const Condition_t> condition_;
 
     private:
       FRIEND_TEST(TestDagEdge, copy_ctor);
@@ -0,0 +1,325 @@
+#ifndef DAG_EXECUTION_H_INCLUDED
+#define DAG_EXECUTION_H_INCLUDED
+
+#include "dag_scheduler/frozen_dag.h"
+#include "dag_scheduler/task_cost_model.h"
+#include "dag_scheduler/task_result_cache.h"
+#include "dag_scheduler/task_scheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace com {
+  namespace dag_scheduler {
+    /**
+     * @brief One run of the \ref Task (s) of a \ref DAG through a
+     *        \ref TaskScheduler, in dependency order.
+     *
+     * Every vertex keeps an atomic count of the predecessors it is still
+     * waiting on. Only the roots are queued at the start. When a
+     * \ref Task completes, \ref Task::complete calls back into the
+     * execution, which counts down each successor and queues the ones
+     * whose last predecessor this was. There is no barrier between levels:
+     * a vertex runs as soon as its own inputs are done, however far behind
+     * other branches are.
+     *
+     * A \ref Task that fails does not release its successors. They, and
+     * everything downstream of them, are skipped and counted as finished
+     * so \ref wait still returns. A \ref Task killed through
+     * \ref TaskScheduler::kill_task before it ran, or dropped by
+     * \ref TaskScheduler::shutdown, fails the same way. Vertices without
+     * a \ref Task complete successfully as soon as they are released.
+     *
+     * Given a \ref TaskCostModel, every vertex is ranked by the estimated
+     * cost of the longest path from it to a sink, see \ref upward_ranks,
+     * and its \ref Task is queued with that rank as its
+     * \ref Task::priority. The \ref TaskScheduler then runs the critical
+     * path first whenever more \ref Task (s) are ready than it has
+     * workers. The run time of each successful \ref Task is recorded back
+     * into the model. Without a model every \ref Task has the same
+     * priority and is run in the order it became ready.
+     *
+     * Given a \ref TaskResultCache, a vertex whose \ref Task succeeded
+     * before with the same \ref TaskResultCache::Key is marked
+     * \ref Status::cached instead of being queued, and every \ref Task
+     * that succeeds is recorded in the cache.
+     *
+     * With chain fusion, a released vertex that starts a linear chain,
+     * see \ref chain_links, is queued together with the rest of the chain
+     * as one \ref Task. Its one stage runs the \ref Task of each member
+     * back to back on one worker, so the chain goes through the
+     * \ref TaskScheduler and a worker once rather than once per vertex,
+     * at the cost of not being interruptible between members. Each member
+     * still completes on its own, with its own callbacks, status, run
+     * time and cache entry. A member that fails skips the rest of the
+     * chain as it would without fusion.
+     *
+     * A vertex whose \ref Task has a \ref FanOutTaskStage can add child
+     * \ref Task (s) to the run while it runs. Each child is queued at once,
+     * with the rank of its vertex, and may fan out further. The run is
+     * only finished once every child has finished. A joined child also
+     * holds back the successors of its vertex, through a count of what
+     * the vertex still waits on beside its own \ref Task, and a joined
+     * child that fails skips them as the vertex failing would. Such a
+     * vertex is recorded in a \ref TaskResultCache only once its joined
+     * children succeeded, and is never fused into a chain.
+     *
+     * A \ref DAGEdge with a \ref DAGEdge::Condition_t is decided when
+     * the \ref Task it leaves succeeds, by calling the condition with that
+     * \ref Task, and is \ref DAGEdge::Status::traversed or
+     * \ref DAGEdge::Status::non_traverable from then on, see
+     * \ref edge_status. A vertex none of whose incoming edges is taken is
+     * \ref Status::pruned once its predecessors are done, and so is
+     * everything downstream of it that has no other live path. Pruned
+     * vertices are settled where their last predecessor finishes, so
+     * nothing is queued for them. A vertex without a \ref Task takes all
+     * of its edges. A vertex with a condition on an edge out of it is
+     * never taken from a \ref TaskResultCache, since its conditions need
+     * the \ref Task that ran, and never fused with its successor.
+     *
+     * The handle returned by \ref start is only needed to wait on or
+     * inspect the run. Dropping it does not stop the run; the queued
+     * \ref Task (s) keep it alive until they complete.
+     */
+    class DAGExecution : public std::enable_shared_from_this<DAGExecution> {
+    public:
+      typedef FrozenDAG::Index Index;
+
+      /**
+       * @brief The state of one vertex of the run.
+       */
+      enum class Status {
+        pending,   ///< Waiting on a predecessor.
+        queued,    ///< Handed to the \ref TaskScheduler.
+        succeeded, ///< Its \ref Task completed successfully.
+        failed,    ///< Its \ref Task completed unsuccessfully.
+        skipped,   ///< Never run since a predecessor did not succeed.
+        reused,    ///< Not run again, it succeeded in the previous run.
+        cached,    ///< Not run, the same \ref Task succeeded before.
+        pruned     ///< Not run, no \ref DAGEdge into it was taken.
+      };
+
+    public:
+      ~DAGExecution();
+
+      /**
+       * @brief Start running \p plan on \p scheduler.
+       *
+       * Queues a clone of the \ref Task of every root of \p plan. The
+       * rest are cloned and queued as they are released, so the
+       * \ref DAGVertex (s) must not be edited until the run is finished.
+       *
+       * @param[in] plan The snapshot of the \ref DAG to run.
+       * @param[in] scheduler The \ref TaskScheduler to queue the
+       *                      \ref Task (s) on. It must outlive the run.
+       * @param[in] costs An optional \ref TaskCostModel to prioritize the
+       *                  \ref Task (s) by and to record their run times
+       *                  in.
+       * @param[in] cache An optional \ref TaskResultCache to skip
+       *                  \ref Task (s) that succeeded before.
+       * @param[in] fuse_chains If true, run each linear chain as one
+       *                        \ref Task.
+       *
+       * @return A handle to the run or nullptr if \p plan has a cycle.
+       */
+      static std::shared_ptr<DAGExecution> start(
+        std::shared_ptr<const FrozenDAG> plan, TaskScheduler &scheduler,
+        std::shared_ptr<TaskCostModel> costs = nullptr,
+        std::shared_ptr<TaskResultCache> cache = nullptr,
+        bool fuse_chains = false
+      );
+
+      /**
+       * @brief Run again only what \p dirty affects of a finished run.
+       *
+       * The vertices in \p dirty, those that did not succeed in
+       * \p previous, and everything downstream of either are run again on
+       * the same plan. Every other vertex succeeded in \p previous and
+       * none of its inputs changed since, so it is marked
+       * \ref Status::reused and counts as finished without being queued.
+       * The \ref DAGVertex (s) are shared with the \ref DAG, so changes to
+       * their \ref Task (s), like new initial inputs, are picked up; new
+       * vertices and edges are not.
+       *
+       * @param[in] previous A finished run.
+       * @param[in] dirty Indices into the plan of \p previous whose
+       *                  \ref Task (s) changed.
+       * @param[in] scheduler The \ref TaskScheduler to queue the
+       *                      \ref Task (s) on. It must outlive the run.
+       * @param[in] costs An optional \ref TaskCostModel, as for
+       *                  \ref start.
+       * @param[in] cache An optional \ref TaskResultCache, as for
+       *                  \ref start.
+       * @param[in] fuse_chains As for \ref start.
+       *
+       * @return A handle to the new run.
+       */
+      static std::shared_ptr<DAGExecution> restart(
+        const DAGExecution &previous, const std::vector<Index> &dirty,
+        TaskScheduler &scheduler,
+        std::shared_ptr<TaskCostModel> costs = nullptr,
+        std::shared_ptr<TaskResultCache> cache = nullptr,
+        bool fuse_chains = false
+      );
+
+      /**
+       * @brief Block until every vertex has finished.
+       *
+       * @return true if every \ref Task completed successfully.
+       */
+      bool wait();
+
+      /**
+       * @brief Block until every vertex has finished or \p timeout passes.
+       *
+       * @param[in] timeout The longest time to wait.
+       *
+       * @return true if the run finished in time.
+       */
+      bool wait_for(const std::chrono::milliseconds &timeout);
+
+      /**
+       * @brief Check if every vertex has finished.
+       *
+       * @return true if nothing is pending or queued any more.
+       */
+      bool is_finished() const;
+
+      /**
+       * @brief Check if every \ref Task so far completed successfully.
+       *
+       * @return false once any \ref Task failed.
+       */
+      bool succeeded() const;
+
+      /**
+       * @brief Get the number of vertices that have finished, whether they
+       *        ran, were skipped, reused or cached, and of child
+       *        \ref Task (s) that have finished.
+       *
+       * @return A number from 0 to the vertex count of \ref plan plus
+       *         \ref expanded_count.
+       */
+      std::size_t finished_count() const;
+
+      /**
+       * @brief Get the number of child \ref Task (s) added to the run by
+       *        \ref FanOutTaskStage (s) so far.
+       *
+       * @return 0 unless a \ref Task fans out.
+       */
+      std::size_t expanded_count() const;
+
+      /**
+       * @brief Get the state of vertex \p i.
+       *
+       * @param[in] i An index into \ref plan.
+       *
+       * @return The \ref Status of \p i.
+       */
+      Status status(Index i) const;
+
+      /**
+       * @brief Get the upward rank \p i is dispatched with.
+       *
+       * @param[in] i An index into \ref plan.
+       *
+       * @return The estimated cost of the longest path from \p i to a
+       *         sink, or 0 if the run has no \ref TaskCostModel.
+       */
+      double rank(Index i) const;
+
+      /**
+       * @brief Get whether the \ref DAGEdge from \p from to \p to was
+       *        taken.
+       *
+       * @param[in] from An index into \ref plan.
+       * @param[in] to A successor of \p from.
+       *
+       * @return \ref DAGEdge::Status::initialized until \p from succeeded
+       *         or was pruned, then whether the edge was taken.
+       */
+      DAGEdge::Status edge_status(Index from, Index to) const;
+
+      /**
+       * @brief The snapshot being run.
+       *
+       * @return The \ref FrozenDAG passed to \ref start.
+       */
+      const FrozenDAG &plan() const;
+
+    private:
+      DAGExecution(
+        std::shared_ptr<const FrozenDAG> plan, TaskScheduler &scheduler,
+        std::shared_ptr<TaskCostModel> costs,
+        std::shared_ptr<TaskResultCache> cache, bool fuse_chains
+      );
+
+      static bool is_success(Status status);
+
+      bool has_conditions(Index i) const;
+      void decide(Index i, const Task &ran);
+      Status shortcut(Index i);
+      Status dispatch(Index i);
+      std::unique_ptr<Task> prepare(Index i);
+      void release(Index i);
+      void release_chain(Index head);
+      bool expand(Index parent, std::unique_ptr<Task> &&child, bool join);
+      void finish(Index i, Status result);
+      void finish_child(Index parent, bool join, bool status);
+
+    private:
+      typedef std::vector<std::pair<Index, Status>> Finished_t;
+
+      void release_successors(Index i, Finished_t &finished);
+      void drain(Finished_t &finished, std::size_t count);
+
+    private:
+      std::shared_ptr<const FrozenDAG> plan_;
+      TaskScheduler &scheduler_;
+      std::shared_ptr<TaskCostModel> costs_;
+      // Empty without a cost model.
+      std::vector<double> ranks_;
+      std::shared_ptr<TaskResultCache> cache_;
+      // Empty without a cache.
+      std::vector<TaskResultCache::Key> keys_;
+      // Empty without chain fusion, see chain_links.
+      std::vector<Index> chain_next_;
+      // Predecessors each vertex still waits on. Counted down by whichever
+      // thread completes a predecessor; the one that reaches zero
+      // releases the vertex.
+      std::unique_ptr<std::atomic<Index>[]> remaining_;
+      // Set on a vertex before its counter is decremented by a
+      // predecessor that did not succeed.
+      std::unique_ptr<std::atomic_bool[]> blocked_;
+      // Set on a vertex before its counter is decremented by a
+      // predecessor whose edge to it was taken.
+      std::unique_ptr<std::atomic_bool[]> reached_;
+      // Indexed by FrozenDAG::edge_index. Decided edges are set before
+      // their source releases its successors.
+      std::unique_ptr<std::atomic<DAGEdge::Status>[]> edge_status_;
+      std::unique_ptr<std::atomic<Status>[]> status_;
+      // What else a vertex waits on before it releases its successors: 1
+      // for its own Task plus 1 for each joined child still running.
+      std::unique_ptr<std::atomic<Index>[]> holds_;
+      // Set on a vertex before a joined child that failed lets go of it.
+      std::unique_ptr<std::atomic_bool[]> child_failed_;
+      std::atomic<std::size_t> finished_;
+      // The vertex count plus every child added so far. A child is counted
+      // while its vertex still runs, so finished_ only catches up at the
+      // end.
+      std::atomic<std::size_t> expected_;
+      std::atomic<std::size_t> expanded_;
+      std::atomic_bool failed_;
+      std::mutex finished_lock_;
+      std::condition_variable finished_cond_;
+    };
+  } // namespace dag_scheduler
+} // namespace com
+#endif
@@ -0,0 +1,162 @@
+#ifndef DAG_MEMORY_POOL_H_INCLUDED
+#define DAG_MEMORY_POOL_H_INCLUDED
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace com {
+  namespace dag_scheduler {
+    class DAGEdge;
+
+    /**
+     * @brief A slab allocator for the \ref DAGVertex (s) and \ref DAGEdge (s)
+     *        owned by a \ref DAG.
+     *
+     * A \ref DAGMemoryPool hands out fixed size blocks carved from large
+     * slabs. Blocks of the same size share a free list, so freeing and
+     * reusing a block never goes back to the system allocator. The slabs
+     * themselves are only released, all at once, when the pool is
+     * destroyed. Requests too large to share a slab fall through to
+     * \ref ::operator new.
+     *
+     * A pool is shared through a \ref std::shared_ptr by everything it
+     * allocated, so it outlives any \ref DAGVertex handed out of a
+     * \ref DAG. It may be used from more than one thread.
+     */
+    class DAGMemoryPool {
+    public:
+      /**
+       * @brief A snapshot of how much memory a \ref DAGMemoryPool holds.
+       */
+      struct Stats {
+        std::size_t slab_count;
+        std::size_t bytes_reserved;
+        std::size_t bytes_in_use;
+        std::size_t blocks_in_use;
+      };
+
+    public:
+      /**
+       * @brief ctor
+       *
+       * No memory is reserved until the first allocation.
+       *
+       * @param[in] slab_size The number of bytes reserved at a time.
+       */
+      explicit DAGMemoryPool(std::size_t slab_size = 64 * 1024);
+
+      /**
+       * @brief dtor
+       *
+       * Releases every slab. Blocks still handed out become invalid.
+       */
+      ~DAGMemoryPool();
+
+      /**
+       * @brief Get a block of at least \p bytes bytes.
+       *
+       * @param[in] bytes The size of the block.
+       *
+       * @return A block aligned for any scalar type.
+       */
+      void *allocate(std::size_t bytes);
+
+      /**
+       * @brief Return a block to the pool.
+       *
+       * @param[in] p A block returned by \ref allocate.
+       * @param[in] bytes The size \p p was allocated with.
+       */
+      void deallocate(void *p, std::size_t bytes);
+
+      /**
+       * @brief Get the amount of memory held by \ref this.
+       *
+       * @return A \ref Stats for \ref this.
+       */
+      Stats stats() const;
+
+    private:
+      struct FreeBlock {
+        FreeBlock *next;
+      };
+
+      struct SizeClass {
+        std::size_t block_size;
+        FreeBlock *free_list;
+        char *cursor;
+        char *end;
+      };
+
+      static std::size_t round_up(std::size_t bytes);
+      SizeClass &size_class_for(std::size_t block_size);
+
+      DAGMemoryPool(const DAGMemoryPool &other) = delete;
+      DAGMemoryPool &operator=(const DAGMemoryPool &rhs) = delete;
+
+    private:
+      mutable std::mutex mutex_;
+      const std::size_t slab_size_;
+      // Only a handful of sizes are ever asked for, so a linear search is
+      // cheaper than hashing.
+      std::vector<SizeClass> size_classes_;
+      std::vector<std::unique_ptr<char[]>> slabs_;
+      Stats stats_;
+    };
+
+    /**
+     * @brief A standard allocator that draws from a \ref DAGMemoryPool.
+     *
+     * Meant for \ref std::allocate_shared, which keeps a copy of the
+     * allocator, and with it the pool, alive next to the object.
+     */
+    template <typename T> class DAGPoolAllocator {
+    public:
+      typedef T value_type;
+
+      explicit DAGPoolAllocator(std::shared_ptr<DAGMemoryPool> pool) :
+        pool_(std::move(pool)) {}
+
+      template <typename U>
+      DAGPoolAllocator(const DAGPoolAllocator<U> &other) :
+        pool_(other.pool_) {}
+
+      T *allocate(std::size_t n) {
+        return static_cast<T *>(pool_->allocate(n * sizeof(T)));
+      }
+
+      void deallocate(T *p, std::size_t n) {
+        pool_->deallocate(p, n * sizeof(T));
+      }
+
+      template <typename U>
+      bool operator==(const DAGPoolAllocator<U> &rhs) const {
+        return pool_ == rhs.pool_;
+      }
+
+      template <typename U>
+      bool operator!=(const DAGPoolAllocator<U> &rhs) const {
+        return pool_ != rhs.pool_;
+      }
+
+    private:
+      template <typename U> friend class DAGPoolAllocator;
+
+      std::shared_ptr<DAGMemoryPool> pool_;
+    };
+
+    /**
+     * @brief Destroys a \ref DAGEdge and returns its memory to the
+     *        \ref DAGMemoryPool it came from, or to the heap if \ref pool
+     *        is nullptr.
+     */
+    struct DAGEdgeDeleter {
+      DAGMemoryPool *pool = nullptr;
+
+      void operator()(DAGEdge *e) const;
+    };
+  } // namespace dag_scheduler
+} // namespace com
+#endif
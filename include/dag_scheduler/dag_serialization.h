@@ -86,6 +86,7 @@ namespace com {
       const static std::string STAGES_KEY;
       const static std::string CONFIGURATION_KEY;
       const static std::string INITIAL_INPUTS_KEY;
+      const static std::string COST_KEY;
 
       const static std::string TITLE_KEY;
       const static std::string NAME_KEY;
@@ -1,14 +1,17 @@
 #ifndef DAG_VERTEX_H_INCLUDED
 #define DAG_VERTEX_H_INCLUDED
 
+#include "dag_scheduler/dag_memory_pool.h"
 #include "dag_scheduler/task.h"
 #include "dag_scheduler/uuid.h"
 
 #include <atomic>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include <gtest/gtest_prod.h>
@@ -33,6 +36,7 @@ namespace com {
     private:
       friend class DAGEdge;
       friend class DAG;
+      friend class FrozenDAG;
       friend struct DAGVertex_connection;
 
     public:
@@ -201,7 +205,9 @@ namespace com {
        * @brief Checks for the existance of a \ref DAGEdge to \ref other.
        *
        * A member fucntion of \ref DAGVertex that checks if \ref this
-       * contains a \ref DAGEdge to \ref other.
+       * contains a \ref DAGEdge to \ref other. Only \p other itself counts,
+       * not a copy of it, so the check takes constant time however many
+       * \ref DAGEdge (s) leave \ref this.
        *
        * @param[in] other The \ref DAGVertex which we are checking for a
        *                  \ref DAGEdge that is drawn to it.
@@ -298,6 +304,30 @@ namespace com {
        */
       std::size_t incomming_edge_count() const;
 
+      /**
+       * @brief A getter for the \ref DAGVertex (s) this points to.
+       *
+       * A member function of \ref DAGVertex that returns the targets of the
+       * \ref DAGEdge (s) owned by \ref this, in the order the
+       * \ref DAGEdge (s) were connected. No \ref std::weak_ptr is locked so
+       * this is safe to call on hot paths.
+       *
+       * @return A const reference to the successors of \ref this.
+       */
+      const std::vector<DAGVertex *> &successors() const;
+
+      /**
+       * @brief A getter for the \ref DAGVertex (s) that point at this.
+       *
+       * A member function of \ref DAGVertex that returns the owners of the
+       * \ref DAGEdge (s) that point at \ref this, one entry per
+       * \ref DAGEdge. Only \ref DAGEdge (s) created through \ref connect
+       * or \ref restablish_connections are tracked.
+       *
+       * @return A const reference to the predecessors of \ref this.
+       */
+      const std::vector<DAGVertex *> &predecessors() const;
+
       /**
        * @brief A getter for the unique id owned by a instance of
        *        \ref DAGEdge.
@@ -329,10 +359,43 @@ namespace com {
       /**
        * @brief A getter for the Task assigned to this \ref DAGVertex.
        *
+       * Copies of a \ref DAGVertex share one Task until one of them calls
+       * this, at which point the caller gets a clone of its own, since the
+       * reference returned can be used to change or take the Task.
+       *
        * @return The Task held by this vertex.
        */
       std::unique_ptr<Task> &get_task();
 
+      /**
+       * @brief A read only getter for the Task assigned to this
+       *        \ref DAGVertex.
+       *
+       * Unlike \ref get_task this never copies a shared Task.
+       *
+       * @return The Task held by this vertex or nullptr if there is none.
+       */
+      const Task *task() const;
+
+      /**
+       * @brief A hash of \ref this and everything downstream of it.
+       *
+       * Covers the label of \ref this, the \ref Task::content_hash of its
+       * Task and the structural hashes of its successors, in sorted order
+       * so the order of connection does not matter. \ref UUID (s) are not
+       * covered, so equal descriptions hash the same however they were
+       * built.
+       *
+       * The hash is cached. Connecting, dropping an edge or calling
+       * \ref get_task drops the cached hash of \ref this and of every
+       * \ref DAGVertex upstream of it, so a later call only recomputes
+       * what changed.
+       *
+       * @return A hash that is the same across processes for the same
+       *         structure.
+       */
+      std::uint64_t structural_hash() const;
+
     public:
       /**
        * @brief A stream operator for writting a \ref DAGVertex to a stream.
@@ -386,19 +449,53 @@ namespace com {
       void add_incomming_edge();
       void sub_incomming_edge();
       void clear_edges();
+      void clear_incomming_edges();
       void reset_incomming_edge_count();
       const DAGEdge &get_edge_at(std::size_t i) const;
 
       DAGVertex(const DAGVertex &other);
       DAGVertex &operator=(const DAGVertex &rhs);
 
+    private:
+      typedef std::unique_ptr<DAGEdge, DAGEdgeDeleter> Edge_t;
+
+      Edge_t make_edge(DAGEdge &&e);
+      void detach_from_predecessors();
+      void adopt_links_of(DAGVertex &other);
+      bool has_successor(const DAGVertex *s) const;
+      void add_successor(DAGVertex *s);
+      void remove_successor(const DAGVertex *s);
+      void remove_all_successor(const DAGVertex *s);
+      void replace_successor(DAGVertex *from, DAGVertex *to);
+      void structure_changed();
+
+      // Past this many successors a hash set answers has_successor rather
+      // than a scan of successors_.
+      static constexpr std::size_t successor_scan_limit = 16;
+
     private:
       class UUID uuid_;
       Status current_status_;
       std::string label_;
-      std::vector<std::unique_ptr<DAGEdge>> edges_;
+      // Where new edges are allocated, set once a DAG takes ownership of
+      // this. Declared before edges_ so it outlives them.
+      std::shared_ptr<DAGMemoryPool> pool_;
+      std::vector<Edge_t> edges_;
+      // Raw adjacency kept in sync by DAGEdge::connect_to, so neighbours can
+      // be walked in either direction without locking weak_ptrs.
+      std::vector<DAGVertex *> successors_;
+      std::vector<DAGVertex *> predecessors_;
+      // Mirrors successors_ once it grows past successor_scan_limit.
+      std::unique_ptr<std::unordered_multiset<const DAGVertex *>>
+        successor_set_;
       std::atomic<std::size_t> incomming_edge_count_;
-      std::unique_ptr<Task> task_;
+      // Shared by copies of this until get_task() hands out a reference
+      // that could be used to change it.
+      std::shared_ptr<std::unique_ptr<Task>> task_;
+      // A vertex with a valid hash only has successors with valid hashes,
+      // so structure_changed() can stop at the first stale predecessor.
+      mutable std::uint64_t structural_hash_ = 0;
+      mutable bool structural_hash_valid_ = false;
 
     private:
       FRIEND_TEST(TestDagVertex, connect_and_contains_connection);
@@ -417,6 +514,7 @@ namespace com {
       );
       FRIEND_TEST(TestDagVertex, copy_ctor_no_edges_with_task);
       FRIEND_TEST(TestDagVertex, assignment_operator_no_edges_with_task);
+      FRIEND_TEST(TestDagVertex, copies_share_task_until_get_task);
       FRIEND_TEST(TestDagVertex, clone_all_edges_with_task);
       FRIEND_TEST(TestDagVertex, copy_ctor_with_edges_with_task);
       FRIEND_TEST(TestDagVertex, assignment_operator_with_edges_with_task);
@@ -425,6 +523,10 @@ namespace com {
       FRIEND_TEST(TestDagVertex, clear_edges);
       FRIEND_TEST(TestDagVertex, reset_incomming_edge_count);
       FRIEND_TEST(TestDagVertex, get_edge_at);
+      FRIEND_TEST(TestDagVertex, successors_and_predecessors);
+      FRIEND_TEST(TestDagVertex, connect_many_successors);
+      FRIEND_TEST(TestDagVertex, clear_incomming_edges);
+      FRIEND_TEST(TestDagVertex, structural_hash_is_invalidated_upstream);
     };
   } // namespace dag_scheduler
 } // namespace com
@@ -0,0 +1,98 @@
+#ifndef EVENT_COUNT_H_INCLUDED
+#define EVENT_COUNT_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace com {
+  namespace dag_scheduler {
+    /**
+     * @brief Lets threads sleep until a condition, checked without a lock,
+     *        may have changed.
+     *
+     * A waiter calls \ref prepare_wait, checks its condition again and
+     * then either \ref cancel_wait or waits with the key it was given. A
+     * notifier changes the condition and then calls \ref notify_one or
+     * \ref notify_all, which return at once if no thread is waiting.
+     * Nothing is missed between the check and the wait.
+     *
+     * Waiters park on a futex on Linux, and on a condition variable
+     * elsewhere.
+     */
+    class EventCount {
+    public:
+      typedef std::uint32_t Key_t;
+
+    public:
+      /**
+       * @brief Default ctor.
+       */
+      EventCount();
+
+      EventCount(const EventCount &) = delete;
+
+      EventCount &operator=(const EventCount &) = delete;
+
+      /**
+       * @brief Announce a wait, before the last check of the condition.
+       *
+       * @return The key to pass to \ref wait or \ref wait_until.
+       */
+      Key_t prepare_wait();
+
+      /**
+       * @brief Withdraw a \ref prepare_wait as the condition held.
+       */
+      void cancel_wait();
+
+      /**
+       * @brief Sleep until notified after \ref prepare_wait returned
+       *        \p key.
+       *
+       * May return spuriously, so the condition is to be checked again.
+       *
+       * @param[in] key The key from \ref prepare_wait.
+       */
+      void wait(Key_t key);
+
+      /**
+       * @brief Like \ref wait, but gives up at \p deadline.
+       *
+       * @param[in] key The key from \ref prepare_wait.
+       * @param[in] deadline When to give up.
+       *
+       * @return false if \p deadline passed first.
+       */
+      bool wait_until(
+        Key_t key, const std::chrono::steady_clock::time_point &deadline
+      );
+
+      /**
+       * @brief Wake one waiter, if any.
+       */
+      void notify_one();
+
+      /**
+       * @brief Wake every waiter, if any.
+       */
+      void notify_all();
+
+    private:
+      void notify(bool all);
+      void finish_wait();
+
+    private:
+      // Bumped by each notify that finds a waiter. The futex word.
+      std::atomic<Key_t> epoch_;
+      std::atomic<std::uint32_t> waiters_;
+#if !defined(__linux__)
+      std::mutex mutex_;
+      std::condition_variable cond_;
+#endif
+    };
+  } // namespace dag_scheduler
+} // namespace com
+#endif
@@ -0,0 +1,91 @@
+#ifndef FAN_OUT_TASK_STAGE_H_INCLUDED
+#define FAN_OUT_TASK_STAGE_H_INCLUDED
+
+#include "dag_scheduler/task_stage.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace com {
+  namespace dag_scheduler {
+    class Task;
+
+    /**
+     * @brief A \ref TaskStage that adds \ref Task (s) to the running
+     *        \ref DAG while it runs.
+     *
+     * Derived stages call \ref emit from \ref run once they know how wide
+     * their work is, e.g. with a \ref Task per input file found. A
+     * \ref DAGExecution queues each emitted \ref Task as a child vertex of
+     * the vertex the stage belongs to at once, without planning again.
+     * A joined child has to finish before the successors of that vertex
+     * are released; a child that is not joined only has to finish before
+     * the run does.
+     */
+    class FanOutTaskStage : public TaskStage {
+    public:
+      /**
+       * @brief What \ref emit hands a child \ref Task to. Returns false if
+       *        the child could not be queued.
+       */
+      typedef std::function<bool(std::unique_ptr<Task> &&child, bool join)>
+        Emit_t;
+
+    public:
+      /**
+       * @brief default ctor
+       */
+      FanOutTaskStage();
+
+      /**
+       * @brief A constructor for a FanOutTaskStage that assigns a user
+       *        defined label.
+       *
+       * @param[in] label The user defined label.
+       */
+      explicit FanOutTaskStage(const std::string &label);
+
+      /**
+       * @brief dtor
+       */
+      virtual ~FanOutTaskStage();
+
+      /**
+       * @brief Setter for where \ref emit sends child \ref Task (s).
+       *
+       * Set by whatever runs the \ref Task before \ref run is called.
+       *
+       * @param[in] emit See \ref Emit_t.
+       */
+      void set_emit(Emit_t emit);
+
+      /**
+       * @brief Check if \ref emit has somewhere to send child
+       *        \ref Task (s).
+       *
+       * @return true if \ref set_emit was given a callable.
+       */
+      bool can_emit() const;
+
+    protected:
+      /**
+       * @brief Add \p child to the running \ref DAG.
+       *
+       * May only be called from \ref run.
+       *
+       * @param[in] child The \ref Task to run as a child vertex.
+       * @param[in] join If true, the successors of the vertex of
+       *                 (this) wait for \p child to finish.
+       *
+       * @return true if \p child was queued. false if nothing runs (this)
+       *         as part of a \ref DAG, in which case \p child is dropped.
+       */
+      bool emit(std::unique_ptr<Task> &&child, bool join = true);
+
+    private:
+      Emit_t emit_;
+    };
+  } // namespace dag_scheduler
+} // namespace com
+#endif
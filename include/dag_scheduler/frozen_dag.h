@@ -0,0 +1,188 @@
+#ifndef FROZEN_DAG_H_INCLUDED
+#define FROZEN_DAG_H_INCLUDED
+
+#include "dag_scheduler/dag.h"
+#include "dag_scheduler/dag_edge.h"
+#include "dag_scheduler/dag_vertex.h"
+#include "dag_scheduler/uuid.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace com {
+  namespace dag_scheduler {
+    /**
+     * @brief An immutable, index based snapshot of the topology of a
+     *        \ref DAG.
+     *
+     * A \ref FrozenDAG stores the \ref DAGVertex (s) of a \ref DAG in a
+     * dense array and refers to them by an int32 index. Successors and
+     * predecessors are kept in compressed sparse row (CSR) form: an offset
+     * array with one entry per vertex plus one, and a target array with one
+     * entry per \ref DAGEdge. The in-degree of each vertex is kept in its
+     * own array. Walking a snapshot needs no \ref std::weak_ptr::lock and no
+     * hash lookups, which makes it the structure to run algorithms over
+     * once a \ref DAG is done being edited.
+     *
+     * Indices follow the order in which \ref DAG::linear_traversal visits
+     * the vertices. The snapshot shares the \ref DAGVertex (s) with the
+     * \ref DAG it was built from but does not see later edits to it.
+     */
+    class FrozenDAG {
+    public:
+      typedef std::int32_t Index;
+
+      static constexpr Index npos = -1;
+
+      /**
+       * @brief A read only view of a contiguous run of \ref Index (s).
+       */
+      class IndexRange {
+      public:
+        IndexRange(const Index *begin, const Index *end);
+
+        const Index *begin() const;
+
+        const Index *end() const;
+
+        std::size_t size() const;
+
+        bool empty() const;
+
+        Index operator[](std::size_t i) const;
+
+      private:
+        const Index *begin_;
+        const Index *end_;
+      };
+
+    public:
+      /**
+       * @brief ctor
+       *
+       * Builds a snapshot of \p g in O(V + E). \ref DAGEdge (s) whose
+       * \ref DAGVertex is no longer in \p g are left out.
+       *
+       * @param[in] g The \ref DAG to take a snapshot of.
+       */
+      explicit FrozenDAG(DAG &g);
+
+      /**
+       * @brief Get the number of \ref DAGVertex (s) in the snapshot.
+       *
+       * @return The number of \ref DAGVertex (s) in the snapshot.
+       */
+      std::size_t vertex_count() const;
+
+      /**
+       * @brief Get the number of \ref DAGEdge (s) in the snapshot.
+       *
+       * @return The number of \ref DAGEdge (s) in the snapshot.
+       */
+      std::size_t edge_count() const;
+
+      /**
+       * @brief Get the \ref DAGVertex stored at \p i.
+       *
+       * @param[in] i The index of the \ref DAGVertex.
+       *
+       * @return A ref counted handle to the \ref DAGVertex.
+       */
+      const std::shared_ptr<DAGVertex> &vertex(Index i) const;
+
+      /**
+       * @brief Get the indices that \p i has a \ref DAGEdge to.
+       *
+       * @param[in] i The index of the \ref DAGVertex.
+       *
+       * @return The successors of \p i in the order the \ref DAGEdge (s)
+       *         were added.
+       */
+      IndexRange successors(Index i) const;
+
+      /**
+       * @brief Get the indices that have a \ref DAGEdge to \p i.
+       *
+       * @param[in] i The index of the \ref DAGVertex.
+       *
+       * @return The predecessors of \p i in ascending index order.
+       */
+      IndexRange predecessors(Index i) const;
+
+      /**
+       * @brief Get the number of \ref DAGEdge (s) that point at \p i.
+       *
+       * @param[in] i The index of the \ref DAGVertex.
+       *
+       * @return The in-degree of \p i within the snapshot.
+       */
+      Index in_degree(Index i) const;
+
+      /**
+       * @brief Get the in-degree of every \ref DAGVertex.
+       *
+       * Algorithms that consume in-degrees, like Kahn's algorithm, can copy
+       * this array as their scratch space.
+       *
+       * @return The in-degree array indexed by \ref Index.
+       */
+      const std::vector<Index> &in_degrees() const;
+
+      /**
+       * @brief Find the index of the \ref DAGVertex with \ref UUID \p u.
+       *
+       * @param[in] u The \ref UUID of the \ref DAGVertex.
+       *
+       * @return The index of the \ref DAGVertex or \ref npos if it is not
+       *         in the snapshot.
+       */
+      Index index_of(const UUID &u) const;
+
+      /**
+       * @brief Get the index of the \p k th \ref DAGEdge leaving \p i.
+       *
+       * Edges are numbered from 0 to \ref edge_count in the order of
+       * \ref successors, so per edge state can live in a flat array.
+       *
+       * @param[in] i The index of the \ref DAGVertex.
+       * @param[in] k A position in \ref successors of \p i.
+       *
+       * @return The index of the \ref DAGEdge to successors(i)[k].
+       */
+      Index edge_index(Index i, std::size_t k) const;
+
+      /**
+       * @brief Get the \ref DAGEdge::Condition_t of edge \p e.
+       *
+       * @param[in] e An index from \ref edge_index.
+       *
+       * @return The condition or nullptr if \p e is always taken.
+       */
+      const DAGEdge::Condition_t *condition(Index e) const;
+
+      /**
+       * @brief Get the number of \ref DAGEdge (s) with a condition.
+       *
+       * @return 0 unless some edge was connected with a condition.
+       */
+      std::size_t condition_count() const;
+
+    private:
+      typedef std::unordered_map<UUID, Index> UUIDIndex_t;
+
+      std::vector<std::shared_ptr<DAGVertex>> vertices_;
+      std::vector<Index> successor_offsets_;
+      std::vector<Index> successor_targets_;
+      std::vector<Index> predecessor_offsets_;
+      std::vector<Index> predecessor_targets_;
+      std::vector<Index> in_degree_;
+      // Few edges have one, so they are kept by edge index on the side.
+      std::unordered_map<Index, std::shared_ptr<const DAGEdge::Condition_t>>
+        conditions_;
+      UUIDIndex_t uuid_index_;
+    };
+  } // namespace dag_scheduler
+} // namespace com
+#endif
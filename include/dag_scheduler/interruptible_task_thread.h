@@ -5,9 +5,23 @@
 #include "dag_scheduler/task.h"
 
 #include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 namespace com {
   namespace dag_scheduler {
+    /**
+     * @brief A worker that runs one \ref Task at a time, stage by stage,
+     *        and can be interrupted between stages.
+     *
+     * The worker thread is started with the first \ref Task and then
+     * kept, waiting on its slot for the next one, so \ref Task (s) run
+     * back to back without a thread being created for each. It is joined
+     * by \ref shutdown, and started again by the next \ref Task.
+     */
     class InterruptibleTaskThread {
     public:
       /**
@@ -49,16 +63,25 @@ namespace com {
       InterruptibleTaskThread &operator=(InterruptibleTaskThread &&rhs);
 
       /**
-       * @brief
+       * @brief Hand \p task to the worker, which runs it at once.
        *
-       * @param[out] task
-       * @param[in] complete_callback
-       * @param[in] delay_between_stages
+       * @param[out] task The \ref Task to run. Left as is if refused.
        *
-       * @return
+       * @return false if a \ref Task is still in the slot.
        */
       bool set_task_and_run(std::unique_ptr<Task> &&task);
 
+      /**
+       * @brief Setter for what the worker calls each time a \ref Task
+       *        completed and it is ready for the next one.
+       *
+       * Called on the worker, after \ref Task::complete returned. Set it
+       * before the first \ref Task is handed over.
+       *
+       * @param[in] idle_callback The function to call.
+       */
+      void set_idle_callback(std::function<void()> idle_callback);
+
       /**
        * @brief
        *
@@ -95,11 +118,21 @@ namespace com {
       void shutdown();
 
     private:
+      void work();
+
+    private:
+      // The slot the worker takes its next Task from. It is emptied, under
+      // task_lock_, only once the Task has run.
       std::unique_ptr<Task> task_;
       mutable std::mutex task_lock_;
+      // Signalled when task_ is filled or the worker should stop.
+      std::condition_variable task_cond_;
       LogTag LOG_TAG;
       volatile std::atomic_bool interrupt_;
       volatile std::atomic_bool running_;
+      // Guarded by task_lock_.
+      bool stop_;
+      std::function<void()> idle_callback_;
       std::thread thread_;
     };
   } // namespace dag_scheduler
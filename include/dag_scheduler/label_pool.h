@@ -0,0 +1,86 @@
+#ifndef LABEL_POOL_H_INCLUDED
+#define LABEL_POOL_H_INCLUDED
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace com {
+  namespace dag_scheduler {
+    /**
+     * @brief Interns the labels of the \ref DAGVertex (s) in a \ref DAG.
+     *
+     * Each distinct label is stored once and handed a small dense id, so
+     * labels can be compared and used as indices without touching the
+     * string again. Ids are never reused; a \ref LabelPool only grows
+     * until it is cleared.
+     */
+    class LabelPool {
+    public:
+      typedef std::size_t Id;
+
+      /**
+       * @brief The id \ref find returns for a label that was never
+       *        interned.
+       */
+      static constexpr Id npos = static_cast<Id>(-1);
+
+    public:
+      LabelPool() = default;
+      LabelPool(LabelPool &&other) = default;
+      LabelPool &operator=(LabelPool &&rhs) = default;
+
+      /**
+       * @brief Get the id of \p label, adding it if it is not yet known.
+       *
+       * @param[in] label The label to intern.
+       *
+       * @return The id of \p label, which is less than \ref size.
+       */
+      Id intern(const std::string &label);
+
+      /**
+       * @brief Get the id of \p label without adding it.
+       *
+       * @param[in] label The label to look up.
+       *
+       * @return The id of \p label or \ref npos if it was never interned.
+       */
+      Id find(const std::string &label) const;
+
+      /**
+       * @brief Get the label interned as \p id.
+       *
+       * @param[in] id An id returned by \ref intern.
+       *
+       * @return The label, which stays valid until \ref clear is called.
+       */
+      const std::string &label(Id id) const;
+
+      /**
+       * @brief The number of distinct labels interned.
+       *
+       * @return One more than the largest id handed out.
+       */
+      std::size_t size() const;
+
+      /**
+       * @brief Forget every label, invalidating every id handed out.
+       */
+      void clear();
+
+    private:
+      LabelPool(const LabelPool &other) = delete;
+      LabelPool &operator=(const LabelPool &rhs) = delete;
+
+    private:
+      // A deque never moves its elements, not even when it is moved
+      // itself, so the keys of ids_ can view the strings in place.
+      std::deque<std::string> labels_;
+      std::unordered_map<std::string_view, Id> ids_;
+    };
+  } // namespace dag_scheduler
+} // namespace com
+#endif
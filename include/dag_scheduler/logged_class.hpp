@@ -35,8 +35,12 @@ namespace com {
 
       /**
        * @brief dtor
+       *
+       * The tag is made from the address of (this), so its sink would
+       * otherwise outlive it and every later log would be filtered through
+       * it.
        */
-      virtual ~LoggedClass() {}
+      virtual ~LoggedClass() { Logging::remove_logger(LOG_TAG); }
 
     protected:
       LogTag LOG_TAG;
@@ -363,6 +363,18 @@ namespace com {
         write_severity_log(tag, DAG_SCHEDULER_FATAL, ss.str());
       }
 
+      /**
+       * @brief Removes the sink tied to \p tag.
+       *
+       * Logs for \p tag are dropped after, until a sink is added for it
+       * again.
+       *
+       * @param[in] tag The \ref LogTag to remove the sink of.
+       *
+       * @return true if \p tag had a sink, false otherwise.
+       */
+      static bool remove_logger(const LogTag &tag);
+
       /**
        * @brief Removes all sinks and clears the tags.
        *
@@ -0,0 +1,135 @@
+#ifndef REACHABILITY_INDEX_H_INCLUDED
+#define REACHABILITY_INDEX_H_INCLUDED
+
+#include "dag_scheduler/frozen_dag.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace com {
+  namespace dag_scheduler {
+    /**
+     * @brief Answers "is there a path from u to v" over a \ref FrozenDAG.
+     *
+     * Up to \ref default_dense_limit vertices the full transitive closure
+     * is kept as one bitset row per vertex, built in reverse topological
+     * order by OR-ing successor rows a word at a time, so
+     * \ref is_reachable is a single bit test.
+     *
+     * Larger snapshots would need too much memory for that. They keep a
+     * topological rank and a depth first interval per vertex instead. A
+     * rank that is not smaller rules a path out and an interval that
+     * contains the target proves one, both in constant time. Only the
+     * queries neither settles fall back to a search, which is pruned by
+     * the same two labels.
+     *
+     * A path needs at least one \ref DAGEdge, so in an acyclic snapshot no
+     * vertex reaches itself. The index sees the snapshot only, not later edits to
+     * the \ref DAG it came from.
+     */
+    class ReachabilityIndex {
+    public:
+      typedef FrozenDAG::Index Index;
+
+      /**
+       * @brief The largest snapshot that gets a full bitset closure, which
+       *        at this size takes 32MiB.
+       */
+      static constexpr std::size_t default_dense_limit = 16 * 1024;
+
+    public:
+      /**
+       * @brief ctor
+       *
+       * Builds the index in O(V * V / 64 + E * V / 64) for a dense closure
+       * and O(V + E) otherwise.
+       *
+       * @param[in] plan The snapshot to index. Only used while building.
+       * @param[in] dense_limit The largest vertex count for which a full
+       *                        closure is kept.
+       */
+      explicit ReachabilityIndex(
+        const FrozenDAG &plan, std::size_t dense_limit = default_dense_limit
+      );
+
+      /**
+       * @brief Check if there is a path from \p from to \p to.
+       *
+       * @param[in] from The index of the first \ref DAGVertex.
+       * @param[in] to The index of the last \ref DAGVertex.
+       *
+       * @return true if following \ref DAGEdge (s) from \p from can lead to
+       *         \p to.
+       */
+      bool is_reachable(Index from, Index to) const;
+
+      /**
+       * @brief Get every vertex reachable from \p from.
+       *
+       * @param[in] from The index of a \ref DAGVertex.
+       *
+       * @return The indices downstream of \p from in ascending order.
+       */
+      std::vector<Index> downstream_of(Index from) const;
+
+      /**
+       * @brief Get every vertex that can reach \p to.
+       *
+       * @param[in] to The index of a \ref DAGVertex.
+       *
+       * @return The indices upstream of \p to in ascending order.
+       */
+      std::vector<Index> upstream_of(Index to) const;
+
+      /**
+       * @brief Check if the full closure is kept.
+       *
+       * @return true if \ref is_reachable is a single bit test.
+       */
+      bool is_dense() const;
+
+      /**
+       * @brief The number of vertices indexed.
+       *
+       * @return The vertex count of the snapshot the index was built from.
+       */
+      std::size_t vertex_count() const;
+
+    private:
+      void build_topological_rank(const FrozenDAG &plan);
+      void build_closure(const FrozenDAG &plan);
+      void build_intervals(const FrozenDAG &plan);
+      bool search(Index from, Index to) const;
+      std::vector<Index> walk(
+        Index start, const std::vector<Index> &offsets,
+        const std::vector<Index> &targets
+      ) const;
+      const std::uint64_t *row(Index i) const;
+
+    private:
+      std::size_t vertex_count_;
+      // A copy of the snapshot's adjacency, in the same CSR form, for the
+      // searches that the labels cannot settle.
+      std::vector<Index> successor_offsets_;
+      std::vector<Index> successor_targets_;
+      std::vector<Index> predecessor_offsets_;
+      std::vector<Index> predecessor_targets_;
+      // Position of each vertex in a topological order. Edges only ever go
+      // from a lower rank to a higher one. Empty if the snapshot has a
+      // cycle, which turns off every shortcut that relies on it.
+      std::vector<Index> topological_rank_;
+      // Row i holds a bit for every vertex reachable from i. Empty unless
+      // the snapshot is small enough.
+      std::size_t words_per_row_;
+      std::vector<std::uint64_t> closure_;
+      // From a depth first walk: each vertex's pre-order number and the
+      // last pre-order number handed out within its subtree. v is a tree
+      // descendant of u, and so reachable from it, when pre_order_[v]
+      // falls in (pre_order_[u], post_order_[u]].
+      std::vector<Index> pre_order_;
+      std::vector<Index> post_order_;
+    };
+  } // namespace dag_scheduler
+} // namespace com
+#endif
@@ -1,6 +1,7 @@
 #ifndef TASK_H_INCLUDED
 #define TASK_H_INCLUDED
 
+#include "dag_scheduler/fan_out_task_stage.h"
 #include "dag_scheduler/logged_class.hpp"
 #include "dag_scheduler/task_stage.h"
 #include "dag_scheduler/uuid.h"
@@ -10,6 +11,8 @@
 #include <boost/config.hpp>
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <ostream>
@@ -330,6 +333,51 @@ namespace com {
        */
       const UUID &get_uuid() const;
 
+      /**
+       * @brief Getter for the estimated time it takes to run this
+       *        \ref Task.
+       *
+       * Set by users, for example from the Cost key of a YAML Task, and
+       * used by a \ref TaskCostModel when it has no history for the
+       * \ref Task.
+       *
+       * @return The estimate in seconds or 0 if there is none.
+       */
+      double cost_estimate() const;
+
+      /**
+       * @brief Setter for the estimated time it takes to run this
+       *        \ref Task.
+       *
+       * @param[in] seconds The estimate in seconds, 0 for none.
+       */
+      void set_cost_estimate(double seconds);
+
+      /**
+       * @brief Getter for the priority a \ref TaskScheduler dispatches
+       *        this \ref Task with.
+       *
+       * @return The priority, higher goes first. 0 unless set.
+       */
+      double priority() const;
+
+      /**
+       * @brief Setter for the priority a \ref TaskScheduler dispatches this
+       *        \ref Task with.
+       *
+       * Must be set before the \ref Task is queued.
+       *
+       * @param[in] priority The priority, higher goes first.
+       */
+      void set_priority(double priority);
+
+      /**
+       * @brief Getter for how long the last \ref iterate_stages took.
+       *
+       * @return The wall time of the last run or 0 if there was none.
+       */
+      std::chrono::nanoseconds run_time() const;
+
       /**
        * @brief The interface for iterating over the stages stored in a
        *        \ref Task.
@@ -364,6 +412,40 @@ namespace com {
        */
       virtual void complete(bool status);
 
+      /**
+       * @brief Set a function for \ref complete to call after the user's
+       *        callback and \ref TaskCallbackPlugin.
+       *
+       * This is how a \ref DAGExecution learns that the \ref Task of a
+       * \ref DAGVertex is done, without taking the callback users set at
+       * construction time. It is neither moved nor cloned with the
+       * \ref Task.
+       *
+       * @param[in] callback The function to call with the status passed to
+       *                     \ref complete.
+       */
+      void set_dependency_callback(std::function<void(bool)> callback);
+
+      /**
+       * @brief Set where the \ref FanOutTaskStage (s) of a \ref Task send
+       *        the child \ref Task (s) they emit.
+       *
+       * This is how a \ref DAGExecution schedules what a vertex adds to
+       * the running \ref DAG. Like the dependency callback, it is set on
+       * each clone that is run rather than cloned.
+       *
+       * @param[in] emit See \ref FanOutTaskStage::Emit_t.
+       */
+      void set_fan_out_callback(FanOutTaskStage::Emit_t emit);
+
+      /**
+       * @brief Check if the \ref Task may add child \ref Task (s) while it
+       *        runs.
+       *
+       * @return true if any stage is a \ref FanOutTaskStage.
+       */
+      bool fans_out() const;
+
       /**
        * @brief Function used by user of class of a \ref Task to check if
        * a callback was set at construction time.
@@ -414,10 +496,55 @@ namespace com {
        */
       virtual void json_initial_inputs_str(std::string &out_str) const;
 
+      /**
+       * @brief A getter for the initial inputs passed into the \ref ctor.
+       *
+       * @return A const reference to the member \ref json_initial_inputs_.
+       */
+      const rapidjson::Document &json_initial_inputs() const;
+
+      /**
+       * @brief Call \p visit on each \ref TaskStage in the order they run.
+       *
+       * @param[in] visit The function to call with each \ref TaskStage.
+       */
+      void
+      visit_stages(const std::function<void(const TaskStage &)> &visit) const;
+
+      /**
+       * @brief Hash what \ref this computes.
+       *
+       * Covers the origin, or failing that the type, and the label of
+       * each \ref TaskStage in order, and the json configuration and
+       * initial inputs with object members in sorted order. The label and
+       * \ref UUID of \ref this are not covered, so clones and
+       * \ref Task (s) built separately from the same description hash
+       * the same. See \ref ContentHash.
+       *
+       * @return A hash that is the same across processes for the same
+       *         content.
+       */
+      std::uint64_t content_hash() const;
+
+      /**
+       * @brief Replace the initial inputs passed in at construction time.
+       *
+       * Clones made before the call keep the inputs they were made with.
+       * This may not be called while \ref iterate_stages is running.
+       *
+       * @param[in] json_initial_inputs A json body that replaces the
+       *                                initial inputs of (this).
+       */
+      void override_initial_inputs(
+        const rapidjson::Document &json_initial_inputs
+      );
+
       /**
        * @brief A clone method to acquire a copy of the internal task.
        *
-       * A clone method to acquire a copy of the internal task.
+       * A clone method to acquire a copy of the internal task. The
+       * \ref TaskStage (s) are copied, the json configuration and initial
+       * inputs are never modified once set so the clone shares them.
        *
        * @return A \ref std::unique_ptr<Task> that is a clone of the \ref
        * (*this).
@@ -482,9 +609,14 @@ namespace com {
       std::string label_;
       std::function<void(bool)> complete_callback_;
       std::unique_ptr<TaskCallbackPlugin> complete_callback_plugin_;
+      std::function<void(bool)> dependency_callback_;
+      double cost_estimate_ = 0.0;
+      double priority_ = 0.0;
+      std::chrono::nanoseconds run_time_ = std::chrono::nanoseconds(0);
       UUID uuid_;
-      std::unique_ptr<rapidjson::Document> json_config_;
-      std::unique_ptr<rapidjson::Document> json_initial_inputs_;
+      // Replaced, never modified, once set, so clones can share them.
+      std::shared_ptr<const rapidjson::Document> json_config_;
+      std::shared_ptr<const rapidjson::Document> json_initial_inputs_;
     };
   } // namespace dag_scheduler
 } // namespace com
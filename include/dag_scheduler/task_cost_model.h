@@ -0,0 +1,78 @@
+#ifndef TASK_COST_MODEL_H_INCLUDED
+#define TASK_COST_MODEL_H_INCLUDED
+
+#include "dag_scheduler/task.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace com {
+  namespace dag_scheduler {
+    /**
+     * @brief Estimates how long a \ref Task will take to run.
+     *
+     * Run times observed for a \ref Task label are kept as an exponentially
+     * weighted moving average and win over anything else. A \ref Task that
+     * has not run yet is estimated by its \ref Task::cost_estimate, and one
+     * without that by the default cost, so every \ref Task gets a positive
+     * estimate. A \ref TaskCostModel may be shared by any number of
+     * \ref DAGExecution (s) at once, so history carries over between runs
+     * of the same workflow.
+     */
+    class TaskCostModel {
+    public:
+      /**
+       * @brief The weight of the newest run time in the moving average.
+       */
+      static constexpr double default_smoothing = 0.3;
+
+    public:
+      /**
+       * @brief ctor
+       *
+       * @param[in] default_cost The estimate in seconds for a \ref Task
+       *                         with neither history nor an estimate of
+       *                         its own.
+       * @param[in] smoothing The weight in (0, 1] of the newest run time.
+       */
+      explicit TaskCostModel(
+        double default_cost = 1.0, double smoothing = default_smoothing
+      );
+
+      /**
+       * @brief Get the estimated run time of \p t.
+       *
+       * @param[in] t The \ref Task to estimate.
+       *
+       * @return The estimate in seconds.
+       */
+      double estimate(const Task &t) const;
+
+      /**
+       * @brief Fold an observed run time of \p t into its history.
+       *
+       * @param[in] t The \ref Task that ran.
+       * @param[in] run_time How long it took.
+       */
+      void record(const Task &t, const std::chrono::nanoseconds &run_time);
+
+      /**
+       * @brief Check if a \ref Task labeled \p label was ever recorded.
+       *
+       * @param[in] label The \ref Task::label to look up.
+       *
+       * @return true if \ref estimate comes from history for that label.
+       */
+      bool has_history(const std::string &label) const;
+
+    private:
+      double default_cost_;
+      double smoothing_;
+      mutable std::mutex history_lock_;
+      std::unordered_map<std::string, double> history_;
+    };
+  } // namespace dag_scheduler
+} // namespace com
+#endif
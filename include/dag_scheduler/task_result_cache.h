@@ -0,0 +1,141 @@
+#ifndef TASK_RESULT_CACHE_H_INCLUDED
+#define TASK_RESULT_CACHE_H_INCLUDED
+
+#include "dag_scheduler/logged_class.hpp"
+#include "dag_scheduler/task.h"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+namespace com {
+  namespace dag_scheduler {
+    /**
+     * @brief Remembers which \ref Task (s) already ran successfully, by
+     *        what they would compute.
+     *
+     * A \ref Task is addressed by a \ref Key hashed from its
+     * \ref Task::content_hash and the \ref Key (s) of the \ref Task (s)
+     * it depends on. Two \ref Task (s) with the same \ref Key run the
+     * same code on the same inputs, so a \ref DAGExecution skips a
+     * \ref Task whose \ref Key is found.
+     *
+     * Found \ref Key (s) are kept in memory, least recently used first
+     * out, and, given a directory, as one file each on disk so they
+     * survive the process. Only success is recorded; a \ref Task has no
+     * outputs besides it.
+     */
+    class TaskResultCache : public LoggedClass<TaskResultCache> {
+    public:
+      typedef std::uint64_t Key;
+
+      /**
+       * @brief Counters of the lookups into a \ref TaskResultCache.
+       */
+      struct Stats {
+        std::size_t hits;
+        std::size_t misses;
+        std::size_t disk_hits;
+        std::size_t memory_entries;
+      };
+
+      /**
+       * @brief The number of \ref Key (s) kept in memory by default.
+       */
+      static constexpr std::size_t default_memory_capacity = 4096;
+
+    public:
+      /**
+       * @brief ctor
+       *
+       * @param[in] memory_capacity The most \ref Key (s) to keep in memory.
+       * @param[in] directory Where to keep \ref Key (s) on disk. It is
+       *                      created if missing. Empty for memory only.
+       */
+      explicit TaskResultCache(
+        std::size_t memory_capacity = default_memory_capacity,
+        const boost::filesystem::path &directory = boost::filesystem::path()
+      );
+
+      /**
+       * @brief Compute the \ref Key of \p t.
+       *
+       * @param[in] t The \ref Task to address.
+       * @param[in] upstream The \ref Key (s) of the \ref Task (s) \p t
+       *                     depends on, in a stable order.
+       *
+       * @return A hash that is the same across processes for the same
+       *         content.
+       */
+      static Key key(const Task &t, const std::vector<Key> &upstream);
+
+      /**
+       * @brief Compute the \ref Key of a vertex without a \ref Task.
+       *
+       * Such a vertex only passes on what it depends on.
+       *
+       * @param[in] upstream As for the other overload.
+       *
+       * @return A hash of \p upstream.
+       */
+      static Key key(const std::vector<Key> &upstream);
+
+      /**
+       * @brief Check if a \ref Task with \p key succeeded before.
+       *
+       * Counts a hit or a miss. A hit on disk is kept in memory after.
+       *
+       * @param[in] key The \ref Key to look up.
+       *
+       * @return true on a hit.
+       */
+      bool contains(Key key);
+
+      /**
+       * @brief Record that a \ref Task with \p key succeeded.
+       *
+       * Only a \p key not recorded yet is written to disk.
+       *
+       * @param[in] key The \ref Key to record.
+       */
+      void insert(Key key);
+
+      /**
+       * @brief Forget every \ref Key kept in memory.
+       *
+       * The counters and what is on disk are kept.
+       */
+      void clear_memory();
+
+      /**
+       * @brief A getter for the counters of \ref this.
+       *
+       * @return A \ref Stats for \ref this.
+       */
+      Stats stats() const;
+
+    private:
+      void remember(Key key);
+      boost::filesystem::path path_of(Key key) const;
+
+    private:
+      typedef std::list<Key> LRU_t;
+
+      std::size_t memory_capacity_;
+      boost::filesystem::path directory_;
+      mutable std::mutex lock_;
+      // Most recently used at the front.
+      LRU_t lru_;
+      std::unordered_map<Key, LRU_t::iterator> index_;
+      std::size_t hits_ = 0;
+      std::size_t misses_ = 0;
+      std::size_t disk_hits_ = 0;
+    };
+  } // namespace dag_scheduler
+} // namespace com
+#endif
@@ -1,29 +1,149 @@
 #ifndef TASK_SCHEDULER_H_INCLUDED
 #define TASK_SCHEDULER_H_INCLUDED
 
+#include "dag_scheduler/bounded_task_queue.h"
 #include "dag_scheduler/concurrent_task_queue.h"
+#include "dag_scheduler/event_count.h"
 #include "dag_scheduler/interruptible_task_thread.h"
 #include "dag_scheduler/logged_class.hpp"
 #include "dag_scheduler/task.h"
+#include "dag_scheduler/work_stealing_deque.h"
 
 #include <gtest/gtest_prod.h>
 
-#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <unordered_set>
 #include <tuple>
+#include <vector>
 
 namespace com {
   namespace dag_scheduler {
+    /**
+     * @brief Hands queued \ref Task (s) to a pool of
+     *        \ref InterruptibleTaskThread (s).
+     *
+     * \ref startup blocks until there is both a queued \ref Task and an
+     * idle thread, rather than polling for either: \ref queue_task and a
+     * thread that went idle each wake it. Idle threads are kept on a
+     * free-list, so one is found in O(1).
+     *
+     * Given \ref PoolLimits, the pool is elastic: a thread is added when
+     * queued work waited for one for \ref PoolLimits::grow_after, and the
+     * longest idle thread is removed once idle for
+     * \ref PoolLimits::shrink_after.
+     *
+     * In \ref Mode::work_stealing, each thread also owns a
+     * \ref WorkStealingDeque. A \ref Task queued by a \ref Task running on
+     * the pool, such as the successors a \ref DAGExecution releases, goes
+     * on the deque of that thread, which runs it next. A thread out of
+     * work steals from a random other one before it goes idle, and
+     * \ref startup steals on behalf of idle threads.
+     *
+     * With \ref Queue::lock_free, the rest is queued on a
+     * \ref BoundedTaskQueue, and only overflows onto the
+     * \ref ConcurrentTaskQueue once that is full.
+     *
+     * A \ref Task that is killed before it runs, or still queued at
+     * \ref shutdown, is completed unsuccessfully rather than dropped, so
+     * its callbacks, and a \ref DAGExecution waiting on it, see it fail.
+     */
     class TaskScheduler :
       public LoggedClass<TaskScheduler>,
       public boost::noncopyable {
     public:
       /**
-       * @brief
+       * @brief Where a queued \ref Task waits for a thread.
+       */
+      enum class Mode {
+        // On one queue, by priority.
+        central_queue,
+        // On the deque of the thread that queued it, if one of the pool
+        // did. Priorities are only kept on the queue.
+        work_stealing
+      };
+
+      /**
+       * @brief What the \ref Task (s) not on a \ref WorkStealingDeque are
+       *        queued on.
+       */
+      enum class Queue {
+        // A ConcurrentTaskQueue, by priority.
+        locked,
+        // A BoundedTaskQueue, first in first out, then a
+        // ConcurrentTaskQueue while that is full.
+        lock_free
+      };
+
+      /**
+       * @brief The bounds an elastic pool is resized within, and when.
+       */
+      struct PoolLimits {
+        std::size_t min_size;
+        std::size_t max_size;
+        // How long queued work waits on a full pool before it grows.
+        std::chrono::microseconds grow_after = std::chrono::milliseconds(1);
+        // How long a thread is idle before the pool shrinks.
+        std::chrono::milliseconds shrink_after = std::chrono::seconds(1);
+      };
+
+      /**
+       * @brief Called with the old and the new size each time an elastic
+       *        pool is resized.
+       */
+      typedef std::function<void(std::size_t from, std::size_t to)>
+        ResizeCallback_t;
+
+    public:
+      /**
+       * @brief ctor for a pool of \ref default_pool_size threads.
        */
       TaskScheduler();
 
+      /**
+       * @brief ctor for a pool of a fixed size.
+       *
+       * @param[in] pool_size The number of threads, at least 1.
+       * @param[in] mode See \ref Mode.
+       * @param[in] queue See \ref Queue.
+       */
+      explicit TaskScheduler(
+        std::size_t pool_size, Mode mode = Mode::central_queue,
+        Queue queue = Queue::locked
+      );
+
+      /**
+       * @brief ctor for an elastic pool.
+       *
+       * @param[in] pool_size The number of threads to start with. It is
+       *                      clamped to \p limits.
+       * @param[in] limits See \ref PoolLimits. min_size is at least 1
+       *                   and max_size at least min_size.
+       * @param[in] mode See \ref Mode.
+       * @param[in] queue See \ref Queue.
+       */
+      TaskScheduler(
+        std::size_t pool_size, const PoolLimits &limits,
+        Mode mode = Mode::central_queue, Queue queue = Queue::locked
+      );
+
+      /**
+       * @brief The size of the pool if none is given.
+       *
+       * @return std::thread::hardware_concurrency, or 1 if unknown.
+       */
+      static std::size_t default_pool_size();
+
+      /**
+       * @brief dtor. Shuts down, joins the pool and completes what is
+       *        still queued unsuccessfully.
+       */
+      ~TaskScheduler();
+
       /**
        * @brief
        *
@@ -85,15 +205,97 @@ namespace com {
        */
       bool is_shutdown();
 
+      /**
+       * @brief A getter for the number of threads in the pool now.
+       *
+       * @return The current size of the pool.
+       */
+      std::size_t pool_size() const;
+
+      /**
+       * @brief A getter for the bounds of the pool.
+       *
+       * @return The \ref PoolLimits given, or both bounds at the fixed
+       *         size.
+       */
+      const PoolLimits &pool_limits() const;
+
+      /**
+       * @brief A getter for where queued \ref Task (s) wait.
+       *
+       * @return The \ref Mode given.
+       */
+      Mode mode() const;
+
+      /**
+       * @brief A getter for what queued \ref Task (s) wait on.
+       *
+       * @return The \ref Queue given.
+       */
+      Queue queue() const;
+
+      /**
+       * @brief Setter for what to call when the pool is resized.
+       *
+       * Called on the thread running \ref startup, without locks held.
+       *
+       * @param[in] resize_callback See \ref ResizeCallback_t.
+       */
+      void set_resize_callback(ResizeCallback_t resize_callback);
+
     private:
-      std::size_t first_unused_thread();
+      typedef std::chrono::steady_clock Clock_t;
+
+      bool has_work() const;
+      bool ring_and_deques_empty() const;
+      bool can_dispatch() const;
+      bool is_starved() const;
+      bool take_task(std::size_t id, std::unique_ptr<Task> &task);
+      bool take_killed(const Task &task);
+      void drop_queued();
+      Clock_t::time_point next_resize();
+      bool resize(std::unique_ptr<InterruptibleTaskThread> &retired);
+      void add_thread();
+      void thread_idle(std::size_t id);
+      void wake_dispatcher();
 
     private:
       ConcurrentTaskQueue queue_;
+      // In Queue::lock_free only, ahead of queue_.
+      std::unique_ptr<BoundedTaskQueue> ring_;
+      // What kill_task could not take off queue_ while ring_ or deques_
+      // held Tasks, to drop once popped off them. Cleared once both are
+      // empty and no take_task is between a pop and its take_killed.
+      std::mutex killed_lock_;
+      std::unordered_set<UUID> killed_;
+      std::atomic<std::size_t> killed_size_;
+      std::atomic<std::size_t> taking_;
       volatile std::atomic_bool pause_;
       volatile std::atomic_bool kill_;
-      std::array<std::unique_ptr<InterruptibleTaskThread>, 10> thread_pool_;
+      PoolLimits limits_;
+      bool elastic_;
+      Mode mode_;
+      // One per index the pool can grow to, in Mode::work_stealing, and
+      // never reallocated, so thieves need no lock.
+      std::vector<std::unique_ptr<WorkStealingDeque>> deques_;
+      // At least the number of Tasks on deques_.
+      std::atomic<std::size_t> stealable_;
+      std::atomic<std::size_t> pool_size_;
+      // Declared before thread_pool_ so they outlive the threads that
+      // signal them. The rest is guarded by thread_pool_lock_.
       std::mutex thread_pool_lock_;
+      // Signalled on new work, an idle thread, pause, resume and shutdown.
+      EventCount dispatcher_event_;
+      // Indices into thread_pool_ of the idle threads, the longest idle at
+      // the front. The back is handed the next Task.
+      std::deque<std::size_t> idle_;
+      // When each thread last went idle, by index.
+      std::vector<Clock_t::time_point> idle_since_;
+      // When queued work started waiting on a full pool, if it is.
+      Clock_t::time_point starved_since_;
+      ResizeCallback_t resize_callback_;
+      // A removed thread leaves a nullptr, reused by the next one added.
+      std::vector<std::unique_ptr<InterruptibleTaskThread>> thread_pool_;
     };
   } // namespace dag_scheduler
 } // namespace com
@@ -84,6 +84,24 @@ namespace com {
        */
       const UUID &get_uuid() const;
 
+      /**
+       * @brief Getter for where the code of a \ref TaskStage came from.
+       *
+       * For a \ref TaskStage loaded from a shared library this is
+       * "<library name>:<symbol name>". It tells apart stages that run
+       * different code, which a \ref TaskResultCache relies on.
+       *
+       * @return The origin or an empty string if it was never set.
+       */
+      const std::string &origin() const;
+
+      /**
+       * @brief Setter for where the code of a \ref TaskStage came from.
+       *
+       * @param[in] origin See \ref origin.
+       */
+      void set_origin(const std::string &origin);
+
     public:
       /**
        * @brief A pure virtual function used to run a \ref TaskStage.
@@ -192,6 +210,7 @@ namespace com {
     protected:
       std::string label_;
       UUID uuid_;
+      std::string origin_;
     };
   } // namespace dag_scheduler
 } // namespace com
@@ -3,6 +3,8 @@
 
 #include <uuid/uuid.h>
 
+#include <cstddef>
+#include <functional>
 #include <ostream>
 #include <sstream>
 #include <string>
@@ -59,7 +61,7 @@ namespace com {
        *
        * @return A \ref UUID that is an identical copy of this.
        */
-      UUID clone();
+      UUID clone() const;
 
       /**
        * @brief Used to ensure a UUID is in a valid state.
@@ -79,6 +81,16 @@ namespace com {
        */
       std::string as_string() const;
 
+      /**
+       * @brief Get a hash of the underlying bytes of a \ref UUID.
+       *
+       * Unlike \ref UUID::as_string this does not allocate, which makes it
+       * suitable for use as a key in hashed containers.
+       *
+       * @return A hash value of the 16 bytes that make up (this).
+       */
+      std::size_t hash_value() const;
+
       /**
        * @brief A utility function used to write a \ref UUID to a stream.
        *
@@ -113,22 +125,13 @@ namespace com {
        * @param[in] rhs The \ref UUID to the right hand side of the ==.
        *
        * @return true if \p lhs and \p rhs are not initialized, or
-       *         if the string representation of \p rhs equals that of
-       *         \p rhs, false otherwise.
+       *         if the bytes of \p lhs equal those of \p rhs, false
+       *         otherwise.
        */
       friend bool operator==(const UUID &lhs, const UUID &rhs) {
-        bool ret = true;
-
-        if (!lhs.is_initialized() && !rhs.is_initialized()) {
-          ret = true;
-        } else if (!lhs.is_initialized() || !rhs.is_initialized()) {
-          ret = false;
-        } else {
-          // Returns 0 on true.
-          ret = (lhs.as_string() == rhs.as_string());
-        }
-
-        return ret;
+        // Returns 0 on true. Two null uuids compare equal and a null uuid
+        // never equals an initialized one.
+        return (uuid_compare(lhs.uuid_, rhs.uuid_) == 0);
       }
 
       /**
@@ -153,4 +156,12 @@ namespace com {
     };
   } // namespace dag_scheduler
 } // namespace com
+
+namespace std {
+  template <> struct hash<com::dag_scheduler::UUID> {
+    std::size_t operator()(const com::dag_scheduler::UUID &obj) const {
+      return obj.hash_value();
+    }
+  };
+} // namespace std
 #endif
@@ -0,0 +1,108 @@
+#ifndef WORK_STEALING_DEQUE_H_INCLUDED
+#define WORK_STEALING_DEQUE_H_INCLUDED
+
+#include "dag_scheduler/task.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace com {
+  namespace dag_scheduler {
+    /**
+     * @brief A Chase-Lev deque of \ref Task (s) owned by one thread and
+     *        stolen from by the others.
+     *
+     * The owner pushes and pops at the bottom, last in first out, so it
+     * runs what it released last while that is still in its cache. Any
+     * thread may steal from the top, oldest first. Neither takes a lock;
+     * the owner only contends with thieves on the last \ref Task.
+     *
+     * Grows by doubling when full. A replaced buffer is kept until the
+     * deque is destroyed, as a thief may still be reading from it.
+     */
+    class WorkStealingDeque {
+    public:
+      /**
+       * @brief The capacity a deque starts with, by default.
+       */
+      static constexpr std::size_t default_capacity = 64;
+
+    public:
+      /**
+       * @brief ctor
+       *
+       * @param[in] capacity How many \ref Task (s) fit before growing,
+       *                     rounded up to a power of two.
+       */
+      explicit WorkStealingDeque(std::size_t capacity = default_capacity);
+
+      /**
+       * @brief dtor. Drops the \ref Task (s) still in the deque.
+       */
+      ~WorkStealingDeque();
+
+      WorkStealingDeque(const WorkStealingDeque &) = delete;
+
+      WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+      /**
+       * @brief Push \p task at the bottom. Owner only.
+       *
+       * @param[in] task The \ref Task to push.
+       */
+      void push(std::unique_ptr<Task> &&task);
+
+      /**
+       * @brief Pop the \ref Task pushed last. Owner only.
+       *
+       * @param[out] task Assigned the \ref Task popped.
+       *
+       * @return false if the deque was empty, or a thief took the last
+       *         \ref Task.
+       */
+      bool pop(std::unique_ptr<Task> &task);
+
+      /**
+       * @brief Take the oldest \ref Task. Any thread.
+       *
+       * @param[out] task Assigned the \ref Task taken.
+       *
+       * @return false if the deque was empty, or another thread took the
+       *         \ref Task first.
+       */
+      bool steal(std::unique_ptr<Task> &task);
+
+      /**
+       * @brief Check if the deque looks empty.
+       *
+       * WARNING: Only exact on the owner while no thief is stealing.
+       *
+       * @return true if there was nothing to take.
+       */
+      bool empty() const;
+
+    private:
+      struct Buffer {
+        explicit Buffer(std::size_t capacity);
+
+        Task *get(std::int64_t i) const;
+        void put(std::int64_t i, Task *task);
+
+        std::size_t capacity;
+        std::unique_ptr<std::atomic<Task *>[]> slots;
+      };
+
+      Buffer *grow(Buffer *buffer, std::int64_t bottom, std::int64_t top);
+
+    private:
+      std::atomic<std::int64_t> top_;
+      std::atomic<std::int64_t> bottom_;
+      std::atomic<Buffer *> buffer_;
+      // Every buffer used, the current one last. Owner only.
+      std::vector<std::unique_ptr<Buffer>> buffers_;
+    };
+  } // namespace dag_scheduler
+} // namespace com
+#endif
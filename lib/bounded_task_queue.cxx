@@ -0,0 +1,170 @@
+#include "dag_scheduler/bounded_task_queue.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace com {
+  namespace dag_scheduler {
+    namespace detail {
+      std::size_t ring_capacity(std::size_t capacity) {
+        std::size_t ret = 2;
+        while (ret < capacity) {
+          ret <<= 1;
+        }
+        return ret;
+      }
+
+      // How far a cell's sequence is ahead of what a position expects,
+      // with wrap around.
+      std::intptr_t lag(std::size_t sequence, std::size_t expected) {
+        return static_cast<std::intptr_t>(sequence - expected);
+      }
+    } // namespace detail
+
+    BoundedTaskQueue::BoundedTaskQueue(std::size_t capacity) :
+      push_at_(0), pop_at_(0), mask_(detail::ring_capacity(capacity) - 1),
+      cells_(new Cell[mask_ + 1]) {
+      // A cell is free for the push at the position equal to its sequence,
+      // and holds the pop at one past it.
+      for (std::size_t i = 0; i <= mask_; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+        cells_[i].task = nullptr;
+      }
+    }
+
+    BoundedTaskQueue::~BoundedTaskQueue() { clear(); }
+
+    std::size_t BoundedTaskQueue::capacity() const { return mask_ + 1; }
+
+    std::size_t BoundedTaskQueue::size() const {
+      // pop_at_ never passes push_at_, so reading it first keeps this
+      // from going negative.
+      const std::size_t popped = pop_at_.load(std::memory_order_acquire);
+      const std::size_t pushed = push_at_.load(std::memory_order_acquire);
+      return std::min(pushed - popped, capacity());
+    }
+
+    bool BoundedTaskQueue::empty() const { return size() == 0; }
+
+    bool BoundedTaskQueue::try_push(std::unique_ptr<Task> &&data) {
+      bool ret = false;
+
+      bool full = false;
+      std::size_t at = push_at_.load(std::memory_order_relaxed);
+      Cell *cell = nullptr;
+      while (!(ret || full)) {
+        cell = &cells_[at & mask_];
+        const std::intptr_t lag = detail::lag(
+          cell->sequence.load(std::memory_order_acquire), at
+        );
+        if (lag == 0) {
+          ret = push_at_.compare_exchange_weak(
+            at, at + 1, std::memory_order_relaxed
+          );
+        } else if (lag < 0) {
+          // Not popped since the last lap.
+          full = true;
+        } else {
+          at = push_at_.load(std::memory_order_relaxed);
+        }
+      }
+      if (ret) {
+        cell->task = data.release();
+        cell->sequence.store(at + 1, std::memory_order_release);
+        not_empty_.notify_one();
+      }
+
+      return ret;
+    }
+
+    void BoundedTaskQueue::push(std::unique_ptr<Task> &&data) {
+      bool pushed = try_push(std::move(data));
+      while (!pushed) {
+        const EventCount::Key_t key = not_full_.prepare_wait();
+        pushed = try_push(std::move(data));
+        if (pushed) {
+          not_full_.cancel_wait();
+        } else {
+          not_full_.wait(key);
+        }
+      }
+    }
+
+    bool BoundedTaskQueue::try_pop(std::unique_ptr<Task> &popped_value) {
+      bool ret = false;
+
+      bool empty = false;
+      std::size_t at = pop_at_.load(std::memory_order_relaxed);
+      Cell *cell = nullptr;
+      while (!(ret || empty)) {
+        cell = &cells_[at & mask_];
+        const std::intptr_t lag = detail::lag(
+          cell->sequence.load(std::memory_order_acquire), at + 1
+        );
+        if (lag == 0) {
+          ret = pop_at_.compare_exchange_weak(
+            at, at + 1, std::memory_order_relaxed
+          );
+        } else if (lag < 0) {
+          // Not pushed yet, or still being pushed.
+          empty = true;
+        } else {
+          at = pop_at_.load(std::memory_order_relaxed);
+        }
+      }
+      if (ret) {
+        Task *task = cell->task;
+        cell->task = nullptr;
+        // Free for the push one lap on.
+        cell->sequence.store(at + mask_ + 1, std::memory_order_release);
+        not_full_.notify_one();
+        popped_value.reset(task);
+      }
+
+      return ret;
+    }
+
+    std::unique_ptr<Task> BoundedTaskQueue::wait_and_pop() {
+      std::unique_ptr<Task> popped_value;
+      bool popped = try_pop(popped_value);
+      while (!popped) {
+        const EventCount::Key_t key = not_empty_.prepare_wait();
+        popped = try_pop(popped_value);
+        if (popped) {
+          not_empty_.cancel_wait();
+        } else {
+          not_empty_.wait(key);
+        }
+      }
+      return popped_value;
+    }
+
+    void BoundedTaskQueue::clear() {
+      std::unique_ptr<Task> task;
+      while (try_pop(task)) {
+        task.reset(nullptr);
+      }
+    }
+
+    bool BoundedTaskQueue::wait_until_and_pop(
+      std::unique_ptr<Task> &popped_value,
+      const std::chrono::steady_clock::time_point &deadline
+    ) {
+      bool ret = try_pop(popped_value);
+
+      bool timed_out = false;
+      while (!(ret || timed_out)) {
+        const EventCount::Key_t key = not_empty_.prepare_wait();
+        ret = try_pop(popped_value);
+        if (ret) {
+          not_empty_.cancel_wait();
+        } else {
+          timed_out = !not_empty_.wait_until(key, deadline);
+        }
+      }
+
+      return ret;
+    }
+  } // namespace dag_scheduler
+} // namespace com
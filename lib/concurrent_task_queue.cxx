@@ -1,6 +1,7 @@
 #include <dag_scheduler/concurrent_task_queue.h>
 #include <dag_scheduler/logging.h>
 
+#include <algorithm>
 #include <cassert>
 #include <utility>
 
@@ -23,7 +24,18 @@ namespace com {
 
     void ConcurrentTaskQueue::push(std::unique_ptr<Task> &&data) {
       std::lock_guard<std::mutex> lock(mutex_);
-      queue_.push_back(std::move(data));
+      // The queue is kept sorted by descending priority. With equal
+      // priorities, the common case, this lands at the back in O(log n).
+      auto priority_of = [](const std::unique_ptr<Task> &t) {
+        return (t != nullptr) ? t->priority() : 0.0;
+      };
+      auto at = std::upper_bound(
+        queue_.begin(), queue_.end(), priority_of(data),
+        [&](double p, const std::unique_ptr<Task> &t) {
+          return p > priority_of(t);
+        }
+      );
+      queue_.insert(at, std::move(data));
       condition_variable_.notify_all();
     }
 
@@ -71,8 +83,7 @@ namespace com {
         auto iterator = std::remove_if(
           queue_.begin(), queue_.end(),
           [&](std::unique_ptr<Task> &task) {
-            auto ret =
-              task.get()->get_uuid().as_string() == to_remove.as_string();
+            auto ret = task.get()->get_uuid() == to_remove;
             if (ret) {
               ret_ptr = std::move(task);
             }
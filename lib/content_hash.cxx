@@ -0,0 +1,77 @@
+#include "dag_scheduler/content_hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+namespace com {
+  namespace dag_scheduler {
+    namespace {
+      typedef rapidjson::Writer<rapidjson::StringBuffer> Writer_t;
+
+      void write_canonical(const rapidjson::Value &v, Writer_t &writer) {
+        if (v.IsObject()) {
+          std::vector<rapidjson::Value::ConstMemberIterator> members;
+          for (auto it = v.MemberBegin(); it != v.MemberEnd(); ++it) {
+            members.push_back(it);
+          }
+          std::sort(
+            members.begin(), members.end(),
+            [](rapidjson::Value::ConstMemberIterator lhs,
+               rapidjson::Value::ConstMemberIterator rhs) {
+              return std::strcmp(
+                       lhs->name.GetString(), rhs->name.GetString()
+                     ) < 0;
+            }
+          );
+          writer.StartObject();
+          for (rapidjson::Value::ConstMemberIterator m : members) {
+            writer.Key(m->name.GetString(), m->name.GetStringLength());
+            write_canonical(m->value, writer);
+          }
+          writer.EndObject();
+        } else if (v.IsArray()) {
+          writer.StartArray();
+          for (auto it = v.Begin(); it != v.End(); ++it) {
+            write_canonical(*it, writer);
+          }
+          writer.EndArray();
+        } else {
+          v.Accept(writer);
+        }
+      }
+    } // namespace
+
+    void ContentHash::add(const char *data, std::size_t size) {
+      for (std::size_t i = 0; i < size; ++i) {
+        hash_ ^= static_cast<unsigned char>(data[i]);
+        hash_ *= 0x100000001b3ull;
+      }
+    }
+
+    void ContentHash::add(const std::string &field) {
+      add(static_cast<std::uint64_t>(field.size()));
+      add(field.data(), field.size());
+    }
+
+    void ContentHash::add(std::uint64_t field) {
+      unsigned char bytes[sizeof(field)];
+      for (std::size_t i = 0; i < sizeof(field); ++i) {
+        bytes[i] = static_cast<unsigned char>(field >> (8 * i));
+      }
+      add(reinterpret_cast<const char *>(bytes), sizeof(bytes));
+    }
+
+    ContentHash::Value_t ContentHash::value() const { return hash_; }
+
+    std::string ContentHash::canonical_json(const rapidjson::Value &v) {
+      rapidjson::StringBuffer buffer;
+      Writer_t writer(buffer);
+      write_canonical(v, writer);
+      return buffer.GetString();
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -1,7 +1,9 @@
 #include "dag_scheduler/dag.h"
 
-#include "dag_scheduler/dag_algorithms.h"
+#include "dag_scheduler/content_hash.h"
 #include "dag_scheduler/dag_edge.h"
+#include "dag_scheduler/frozen_dag.h"
+#include "dag_scheduler/reachability_index.h"
 
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
@@ -9,10 +11,13 @@
 #include <algorithm>
 #include <cassert>
 #include <iostream>
-#include <list>
 #include <memory>
+#include <set>
 #include <sstream>
 #include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 namespace com {
@@ -27,39 +32,65 @@ namespace com {
     DAG::DAG() : DAG("") {}
 
     DAG::DAG(const std::string &title) :
-      LoggedClass(*this), title_(title),
-      json_config_(std::make_unique<rapidjson::Document>()) {
+      LoggedClass(*this), memory_pool_(std::make_shared<DAGMemoryPool>()),
+      title_(title), json_config_(std::make_shared<rapidjson::Document>()) {
       Logging::info(LOG_TAG, "Created DAG with title=--", title_, "--");
     }
 
     DAG::DAG(
       const std::string &title, const rapidjson::Document &json_config
     ) :
-      LoggedClass(*this), title_(title),
-      json_config_(std::make_unique<rapidjson::Document>()) {
+      LoggedClass(*this), memory_pool_(std::make_shared<DAGMemoryPool>()),
+      title_(title) {
       Logging::info(LOG_TAG, "Created DAG with title=--", title_, "--");
-      json_config_->CopyFrom(json_config, json_config_->GetAllocator());
+      set_json_config(json_config);
     }
 
     DAG::DAG(const rapidjson::Document &json_config) :
-      LoggedClass(*this),
-      json_config_(std::make_unique<rapidjson::Document>()) {
+      LoggedClass(*this), memory_pool_(std::make_shared<DAGMemoryPool>()) {
       Logging::info(LOG_TAG, "Created DAG with title=--", title_, "--");
-      json_config_->CopyFrom(json_config, json_config_->GetAllocator());
+      set_json_config(json_config);
     }
 
     DAG::~DAG() {}
 
     DAG::DAG(DAG &&other) :
-      LoggedClass(*this), graph_(std::move(other.graph_)),
-      title_(other.title_), json_config_(std::move(other.json_config_)) {
+      LoggedClass(*this), memory_pool_(std::make_shared<DAGMemoryPool>()),
+      graph_(std::move(other.graph_)),
+      uuid_index_(std::move(other.uuid_index_)),
+      topological_order_(std::move(other.topological_order_)),
+      topological_index_(std::move(other.topological_index_)),
+      labels_(std::move(other.labels_)),
+      label_index_(std::move(other.label_index_)),
+      frozen_(std::move(other.frozen_)),
+      reachability_(std::move(other.reachability_)),
+      dirty_(std::move(other.dirty_)), title_(other.title_),
+      json_config_(std::move(other.json_config_)),
+      structural_hash_(other.structural_hash_),
+      structural_hash_valid_(other.structural_hash_valid_) {
+      other.structural_hash_valid_ = false;
+      // The vertices keep their own pool alive, so the pools only need to
+      // change hands to keep other usable.
+      std::swap(memory_pool_, other.memory_pool_);
       Logging::info(LOG_TAG, "Moved DAG with title=", title_);
     }
 
     DAG &DAG::operator=(DAG &&other) {
+      std::swap(memory_pool_, other.memory_pool_);
       graph_ = std::move(other.graph_);
+      uuid_index_ = std::move(other.uuid_index_);
+      topological_order_ = std::move(other.topological_order_);
+      topological_index_ = std::move(other.topological_index_);
+      labels_ = std::move(other.labels_);
+      label_index_ = std::move(other.label_index_);
+      frozen_ = std::move(other.frozen_);
+      reachability_ = std::move(other.reachability_);
+      dirty_ = std::move(other.dirty_);
       title_ = other.title_;
       json_config_ = std::move(other.json_config_);
+      structural_hash_ = other.structural_hash_;
+      structural_hash_valid_ = other.structural_hash_valid_;
+      other.structural_hash_valid_ = false;
       Logging::info(LOG_TAG, "Moved Assigned DAG with title=", title_);
       return (*this);
     }
@@ -69,15 +100,24 @@ namespace com {
     bool DAG::add_vertex(DAGVertex &&v) {
       bool ret = false;
 
-      if (v.get_task() == nullptr) {
+      if (v.task() == nullptr) {
         Logging::warn(LOG_TAG, "Adding vertex with no task!!!");
       }
 
       if (!contains_vertex(v)) {
-        auto graph_vertex = std::make_shared<DAGVertex>(std::move(v));
+        std::shared_ptr<DAGVertex> graph_vertex = make_vertex(std::move(v));
         graph_.push_back(graph_vertex);
+        uuid_index_.emplace(graph_vertex->get_uuid().clone(), graph_vertex);
+        index_label(graph_vertex);
+        topology_changed();
+        // A vertex with no edges can go anywhere in the order; the end is
+        // the cheapest place to put it.
+        topological_order_.push_back(nullptr);
+        place_in_topological_order(
+          graph_vertex.get(), topological_order_.size() - 1
+        );
 
-        if (graph_.back()->get_task() == nullptr) {
+        if (graph_.back()->task() == nullptr) {
           Logging::warn(LOG_TAG, "Vertex at end of vertices has no task!!!");
         }
 
@@ -87,6 +127,151 @@ namespace com {
       return ret;
     }
 
+    bool DAG::bulk_load(
+      std::vector<DAGVertex> &&vertices,
+      const std::vector<std::pair<UUID, UUID>> &edges
+    ) {
+      bool ret = true;
+
+      DAG_t staged;
+      UUIDIndex_t staged_index;
+      staged.reserve(vertices.size());
+      for (DAGVertex &v : vertices) {
+        if (uuid_index_.count(v.get_uuid()) != 0 ||
+            staged_index.count(v.get_uuid()) != 0) {
+          ret = false;
+          continue;
+        }
+        std::shared_ptr<DAGVertex> graph_vertex = make_vertex(std::move(v));
+        staged_index.emplace(graph_vertex->get_uuid().clone(), graph_vertex);
+        staged.push_back(std::move(graph_vertex));
+      }
+      vertices.clear();
+
+      auto resolve = [&](const UUID &u) -> std::shared_ptr<DAGVertex> {
+        auto it = staged_index.find(u);
+        if (it == staged_index.end()) {
+          it = uuid_index_.find(u);
+          if (it == uuid_index_.end()) {
+            return nullptr;
+          }
+        }
+        return it->second;
+      };
+
+      std::vector<
+        std::pair<std::shared_ptr<DAGVertex>, std::shared_ptr<DAGVertex>>>
+        resolved;
+      resolved.reserve(edges.size());
+      std::set<std::pair<const DAGVertex *, const DAGVertex *>> drawn;
+      for (const std::pair<UUID, UUID> &e : edges) {
+        std::shared_ptr<DAGVertex> from = resolve(e.first);
+        std::shared_ptr<DAGVertex> to = resolve(e.second);
+        if (from == nullptr || to == nullptr) {
+          ret = false;
+          continue;
+        }
+        // A duplicate, of another input edge or of one already drawn.
+        if (!drawn.emplace(from.get(), to.get()).second ||
+            from->contains_connection_to(*to)) {
+          ret = false;
+          continue;
+        }
+        resolved.emplace_back(std::move(from), std::move(to));
+      }
+
+      // Give every vertex, old and new, a dense id so Kahn's algorithm can
+      // run over plain arrays.
+      std::vector<DAGVertex *> all;
+      std::unordered_map<const DAGVertex *, std::size_t> ids;
+      all.reserve(graph_.size() + staged.size());
+      ids.reserve(graph_.size() + staged.size());
+      for (const DAG_t *vs : {&graph_, &staged}) {
+        for (const std::shared_ptr<DAGVertex> &v : *vs) {
+          ids.emplace(v.get(), all.size());
+          all.push_back(v.get());
+        }
+      }
+
+      std::vector<std::size_t> in_degree(all.size(), 0);
+      std::vector<std::vector<std::size_t>> added_out(all.size());
+      for (const std::shared_ptr<DAGVertex> &v : graph_) {
+        for (const DAGVertex::Edge_t &e : v->edges_) {
+          auto it = ids.find(e->connection_.lock().get());
+          if (it != ids.end()) {
+            ++in_degree[it->second];
+          }
+        }
+      }
+      for (const auto &e : resolved) {
+        std::size_t to = ids[e.second.get()];
+        added_out[ids[e.first.get()]].push_back(to);
+        ++in_degree[to];
+      }
+
+      std::vector<std::size_t> order;
+      order.reserve(all.size());
+      for (std::size_t i = 0; i < all.size(); ++i) {
+        if (in_degree[i] == 0) {
+          order.push_back(i);
+        }
+      }
+      auto release = [&](std::size_t i) {
+        if (--in_degree[i] == 0) {
+          order.push_back(i);
+        }
+      };
+      for (std::size_t head = 0; head < order.size(); ++head) {
+        const std::size_t curr = order[head];
+        for (const DAGVertex::Edge_t &e : all[curr]->edges_) {
+          auto it = ids.find(e->connection_.lock().get());
+          if (it != ids.end()) {
+            release(it->second);
+          }
+        }
+        for (std::size_t next : added_out[curr]) {
+          release(next);
+        }
+      }
+
+      if (order.size() != all.size()) {
+        std::stringstream error_str;
+        error_str << "Loading " << staged.size() << " vertices and "
+                  << resolved.size() << " edges would cause a cycle. "
+                  << (all.size() - order.size())
+                  << " vertices could not be ordered:";
+        for (std::size_t i = 0; i < all.size(); ++i) {
+          if (in_degree[i] != 0) {
+            error_str << std::endl << (*all[i]);
+          }
+        }
+        Logging::error(LOG_TAG, error_str.str());
+        throw DAGException(error_str.str().c_str());
+      }
+
+      for (std::shared_ptr<DAGVertex> &v : staged) {
+        uuid_index_.emplace(v->get_uuid().clone(), v);
+        index_label(v);
+        graph_.push_back(std::move(v));
+      }
+      topological_order_.resize(order.size());
+      topological_index_.clear();
+      topological_index_.reserve(order.size());
+      for (std::size_t position = 0; position < order.size(); ++position) {
+        place_in_topological_order(all[order[position]], position);
+      }
+      for (const auto &e : resolved) {
+        e.first->connect(e.second);
+      }
+      topology_changed();
+      Logging::info(
+        LOG_TAG, "Bulk loaded", staged.size(), "vertices and",
+        resolved.size(), "edges into", title_
+      );
+
+      return ret;
+    }
+
     std::weak_ptr<DAGVertex> DAG::find_vertex(const DAGVertex &v) {
       std::weak_ptr<DAGVertex> ret = find_vertex_by_uuid(v.get_uuid());
       return ret;
@@ -95,22 +280,9 @@ namespace com {
     std::weak_ptr<DAGVertex> DAG::find_vertex_by_uuid(const UUID &u) {
       std::weak_ptr<DAGVertex> ret;
 
-      auto it = std::find_if(
-        graph_.begin(), graph_.end(),
-        [&](std::shared_ptr<DAGVertex> vi) {
-          const DAGVertex &rhs = (*(vi.get()));
-
-          std::string u_str = u.as_string();
-          std::string rhs_str = rhs.get_uuid().as_string();
-          (void)u_str;
-          (void)rhs_str;
-
-          return (u == rhs.get_uuid());
-        }
-      );
-
-      if (it != graph_.end()) {
-        ret = (*it);
+      auto it = uuid_index_.find(u);
+      if (it != uuid_index_.end()) {
+        ret = it->second;
       }
 
       return ret;
@@ -120,11 +292,9 @@ namespace com {
     DAG::find_all_verticies_with_label(const std::string &l) {
       std::vector<std::weak_ptr<DAGVertex>> ret;
 
-      for (auto it = graph_.begin(); it != graph_.end(); ++it) {
-        if ((*it)->label() == l) {
-          std::weak_ptr<DAGVertex> tmp = (*it);
-          ret.push_back(tmp);
-        }
+      const LabelPool::Id id = labels_.find(l);
+      if (id != LabelPool::npos) {
+        ret.assign(label_index_[id].begin(), label_index_[id].end());
       }
 
       return ret;
@@ -153,7 +323,8 @@ namespace com {
     bool DAG::contains_vertex_by_label(const std::string &l) {
       bool ret = false;
 
-      if (!find_all_verticies_with_label(l).empty()) {
+      const LabelPool::Id id = labels_.find(l);
+      if (id != LabelPool::npos && !label_index_[id].empty()) {
         ret = true;
       }
 
@@ -165,24 +336,23 @@ namespace com {
     ) {
       bool ret = false;
 
-      std::list<DAGVertex> sorted_vertices;
-      DAG graph_clone = clone();
-
-      DAGVertex v1_clone = *const_cast<DAGVertex *>(&v1);
-      DAGVertex v2_clone = *const_cast<DAGVertex *>(&v2);
-      graph_clone.add_vertex(std::move(v1_clone));
-      graph_clone.add_vertex(std::move(v2_clone));
-      std::weak_ptr<DAGVertex> v1_found = graph_clone.find_vertex(v1_clone);
-      std::weak_ptr<DAGVertex> v2_found = graph_clone.find_vertex(v2_clone);
-      // Bypass DAG interface to prevent infinite recursion.
-      v1_found.lock()->connect(v2_found.lock());
-
-      assert(
-        (!v1_found.expired() && !v2_found.expired()) &&
-        "There must be a regression in add_vertex."
-      );
+      std::weak_ptr<DAGVertex> v1_found = find_vertex(v1);
+      std::weak_ptr<DAGVertex> v2_found = find_vertex(v2);
 
-      ret = dag_topological_sort(graph_clone, sorted_vertices);
+      if (v1.get_uuid() == v2.get_uuid()) {
+        ret = true;
+      } else if (!v1_found.expired() && !v2_found.expired()) {
+        if (reachability_) {
+          // A path back from v2 to v1 is exactly what the edge would close.
+          ret = is_reachable(*(v2_found.lock()), *(v1_found.lock()));
+        } else {
+          ret = !order_for_edge(
+            *(v1_found.lock()), *(v2_found.lock()), false
+          );
+        }
+      }
+      // Otherwise at least one end is not in the graph yet. It would be
+      // added with no edges, so it cannot close a cycle.
 
       return ret;
     }
@@ -209,6 +379,10 @@ namespace com {
       v1 = find_all_verticies_with_label(l1);
       std::vector<std::weak_ptr<DAGVertex>> v2;
       v2 = find_all_verticies_with_label(l2);
+      // Nothing changes between the checks, so they can share one index.
+      if (v1.size() * v2.size() > 1) {
+        reachability_index();
+      }
 
       for (auto v : v1) {
         bool good = true;
@@ -228,30 +402,41 @@ namespace com {
     }
 
     bool DAG::connect(const DAGVertex &v1, const DAGVertex &v2) {
+      return connect(v1, v2, DAGEdge::Condition_t());
+    }
+
+    bool DAG::connect(
+      const DAGVertex &v1, const DAGVertex &v2,
+      DAGEdge::Condition_t condition
+    ) {
       bool ret = false;
 
       std::weak_ptr<DAGVertex> v1_tmp = find_vertex(v1);
       std::weak_ptr<DAGVertex> v2_tmp = find_vertex(v2);
 
+      // Both vertices come out of the index, so they are known to be in
+      // graph_ without scanning it.
       if (!v1_tmp.expired() && !v2_tmp.expired()) {
-        auto v1_it = std::find(graph_.begin(), graph_.end(), v1_tmp.lock());
-        auto v2_it = std::find(graph_.begin(), graph_.end(), v2_tmp.lock());
-
-        if (v1_it != graph_.end() && v2_it != graph_.end()) {
-          if (!connection_would_make_cyclic(
-                *(v1_it->get()), *(v2_it->get())
-              )) {
-            v1_it->get()->connect(*v2_it);
-            ret = true;
-          } else {
-            std::stringstream error_str;
-            error_str << "Connecting " << std::endl
-                      << (*(v1_tmp.lock())) << std::endl
-                      << "to " << std::endl
-                      << (*(v2_tmp.lock())) << std::endl
-                      << "would cause a cycle.";
-            throw DAGException(error_str.str().c_str());
+        std::shared_ptr<DAGVertex> v1_ptr = v1_tmp.lock();
+        std::shared_ptr<DAGVertex> v2_ptr = v2_tmp.lock();
+
+        if (order_for_edge(*v1_ptr, *v2_ptr, true)) {
+          if (v1_ptr->connect(v2_ptr) && condition) {
+            v1_ptr->edges_.back()->condition_ =
+              std::make_shared<const DAGEdge::Condition_t>(
+                std::move(condition)
+              );
           }
+          topology_changed();
+          ret = true;
+        } else {
+          std::stringstream error_str;
+          error_str << "Connecting " << std::endl
+                    << (*v1_ptr) << std::endl
+                    << "to " << std::endl
+                    << (*v2_ptr) << std::endl
+                    << "would cause a cycle.";
+          throw DAGException(error_str.str().c_str());
         }
       }
 
@@ -307,19 +492,12 @@ namespace com {
     bool DAG::are_connected(const DAGVertex &v1, const DAGVertex &v2) {
       bool ret = false;
 
-      std::weak_ptr<DAGVertex> v1_tmp = find_vertex(v1);
-      std::weak_ptr<DAGVertex> v2_tmp = find_vertex(v2);
+      std::shared_ptr<DAGVertex> v1_ptr = find_vertex(v1).lock();
+      std::shared_ptr<DAGVertex> v2_ptr = find_vertex(v2).lock();
 
-      DAGVertex &v2_ref = *(v2_tmp.lock().get());
-      std::uintptr_t v2_addr = reinterpret_cast<std::uintptr_t>(&v2_ref);
-      v1_tmp.lock()->visit_all_edges([&](const DAGEdge &e) {
-        DAGEdge &e_tmp = *const_cast<DAGEdge *>(&e);
-        DAGVertex &c_ref = *(e_tmp.get_connection().lock().get());
-        std::uintptr_t c_addr = reinterpret_cast<std::uintptr_t>(&c_ref);
-        if (c_addr == v2_addr) {
-          ret = true;
-        }
-      });
+      if (v1_ptr != nullptr && v2_ptr != nullptr) {
+        ret = v1_ptr->contains_connection_to(*v2_ptr);
+      }
 
       return ret;
     }
@@ -356,6 +534,49 @@ namespace com {
       return ret;
     }
 
+    bool DAG::is_reachable(const DAGVertex &v1, const DAGVertex &v2) {
+      bool ret = false;
+
+      const ReachabilityIndex &index = reachability_index();
+      const FrozenDAG::Index from = frozen_->index_of(v1.get_uuid());
+      const FrozenDAG::Index to = frozen_->index_of(v2.get_uuid());
+      if (from != FrozenDAG::npos && to != FrozenDAG::npos) {
+        ret = index.is_reachable(from, to);
+      }
+
+      return ret;
+    }
+
+    std::vector<std::weak_ptr<DAGVertex>>
+    DAG::downstream_of(const DAGVertex &v) {
+      std::vector<std::weak_ptr<DAGVertex>> ret;
+
+      const ReachabilityIndex &index = reachability_index();
+      const FrozenDAG::Index from = frozen_->index_of(v.get_uuid());
+      if (from != FrozenDAG::npos) {
+        for (FrozenDAG::Index i : index.downstream_of(from)) {
+          ret.push_back(frozen_->vertex(i));
+        }
+      }
+
+      return ret;
+    }
+
+    std::vector<std::weak_ptr<DAGVertex>>
+    DAG::upstream_of(const DAGVertex &v) {
+      std::vector<std::weak_ptr<DAGVertex>> ret;
+
+      const ReachabilityIndex &index = reachability_index();
+      const FrozenDAG::Index to = frozen_->index_of(v.get_uuid());
+      if (to != FrozenDAG::npos) {
+        for (FrozenDAG::Index i : index.upstream_of(to)) {
+          ret.push_back(frozen_->vertex(i));
+        }
+      }
+
+      return ret;
+    }
+
     void
     DAG::linear_traversal(std::function<void(std::shared_ptr<DAGVertex>)> cb
     ) {
@@ -380,25 +601,13 @@ namespace com {
     bool DAG::remove_vertex(const DAGVertex &v) {
       bool ret = false;
 
-      graph_.erase(
-        std::remove_if(
-          graph_.begin(), graph_.end(),
-          [&](std::shared_ptr<DAGVertex> o) {
-            bool found = ((o.get() != nullptr) && (*(o.get()) == v));
-            if (found) {
-              o->visit_all_edges([&](const DAGEdge &e) {
-                if (e.connection_.lock() != nullptr) {
-                  e.connection_.lock()->sub_incomming_edge();
-                }
-              });
-              o->clear_edges();
-              ret = true;
-            }
-            return found;
-          }
-        ),
-        graph_.end()
-      );
+      auto index_it = uuid_index_.find(v.get_uuid());
+      if (index_it != uuid_index_.end() && *(index_it->second) == v) {
+        std::shared_ptr<DAGVertex> o = index_it->second;
+        uuid_index_.erase(index_it);
+        detach_vertex(o);
+        ret = true;
+      }
 
       return ret;
     }
@@ -406,24 +615,13 @@ namespace com {
     bool DAG::remove_vertex_by_uuid(const UUID &id) {
       bool ret = false;
 
-      std::vector<std::shared_ptr<DAGVertex>>::iterator remove_it =
-        std::remove_if(
-          graph_.begin(), graph_.end(),
-          [&](std::shared_ptr<DAGVertex> o) {
-            bool found = ((o.get() != nullptr) && (o->get_uuid() == id));
-            if (found) {
-              o->visit_all_edges([&](const DAGEdge &e) {
-                if (e.connection_.lock() != nullptr) {
-                  e.connection_.lock()->sub_incomming_edge();
-                }
-              });
-              o->clear_edges();
-              ret = true;
-            }
-            return found;
-          }
-        );
-      graph_.erase(remove_it, graph_.end());
+      auto index_it = uuid_index_.find(id);
+      if (index_it != uuid_index_.end()) {
+        std::shared_ptr<DAGVertex> o = index_it->second;
+        uuid_index_.erase(index_it);
+        detach_vertex(o);
+        ret = true;
+      }
 
       return ret;
     }
@@ -431,32 +629,51 @@ namespace com {
     bool DAG::remove_all_vertex_with_label(const std::string &label) {
       bool ret = false;
 
-      std::vector<std::shared_ptr<DAGVertex>> found_with_label;
-
-      std::copy_if(
-        graph_.begin(), graph_.end(), std::back_inserter(found_with_label),
-        [&](std::shared_ptr<DAGVertex> v) {
-          return (v.get() && (v->label() == label));
+      const LabelPool::Id id = labels_.find(label);
+      if (id != LabelPool::npos && !label_index_[id].empty()) {
+        DAG_t found_with_label;
+        found_with_label.swap(label_index_[id]);
+        std::unordered_set<const DAGVertex *> removed;
+        removed.reserve(found_with_label.size());
+        for (const std::shared_ptr<DAGVertex> &v : found_with_label) {
+          uuid_index_.erase(v->get_uuid());
+          dirty_.erase(v->get_uuid());
+          unlink_vertex(v);
+          removed.insert(v.get());
         }
-      );
-
-      ret = !(found_with_label.empty());
-
-      if (ret) {
-        std::for_each(
-          found_with_label.begin(), found_with_label.end(),
-          [&](std::shared_ptr<DAGVertex> v) {
-            if (v != nullptr) {
-              remove_vertex(*v);
+        // One pass over graph_ for the lot, rather than one per vertex.
+        graph_.erase(
+          std::remove_if(
+            graph_.begin(), graph_.end(),
+            [&](const std::shared_ptr<DAGVertex> &v) {
+              return removed.count(v.get()) != 0;
             }
-          }
+          ),
+          graph_.end()
         );
+        ret = true;
       }
 
       return ret;
     }
 
-    void DAG::reset() { graph_.clear(); }
+    void DAG::reset() {
+      topology_changed();
+      uuid_index_.clear();
+      topological_order_.clear();
+      topological_index_.clear();
+      label_index_.clear();
+      labels_.clear();
+      graph_.clear();
+      dirty_.clear();
+      // Unless a vertex is still held elsewhere this drops the last
+      // reference to the old pool, which frees its slabs in one go.
+      memory_pool_ = std::make_shared<DAGMemoryPool>();
+    }
+
+    DAGMemoryPool::Stats DAG::memory_stats() const {
+      return memory_pool_->stats();
+    }
 
     const rapidjson::Document &DAG::json_config() const {
       return (*json_config_);
@@ -479,26 +696,69 @@ namespace com {
     ) {
       std::shared_ptr<DAGVertex> vertex_to_update =
         find_vertex_by_uuid(vertex_uuid).lock();
-      if (vertex_to_update->get_task()) {
+      if (vertex_to_update && vertex_to_update->task()) {
         Logging::info(
-          LOG_TAG, "Going to update inputs for",
-          *(vertex_to_update->get_task().get()), "..."
+          LOG_TAG, "Going to update inputs for", *(vertex_to_update->task()),
+          "..."
         );
-        const UUID &task_uuid = vertex_to_update->get_task()->get_uuid();
-        UUID clone(task_uuid.as_string());
-        auto uuid_ptr = std::make_unique<UUID>(task_uuid.as_string());
+        // get_task gives this vertex its own Task first if a copy of the
+        // DAG still shares it.
+        vertex_to_update->get_task()->override_initial_inputs(initial_input);
+        mark_dirty(vertex_uuid);
+      }
+    }
 
-        rapidjson::Document json_input;
-        json_input.CopyFrom(initial_input, json_input.GetAllocator());
+    bool DAG::mark_dirty(const UUID &vertex_uuid) {
+      bool ret = false;
 
-        if (vertex_to_update->get_task()) {
-          // TODO (mehoggan): Implement this method in task.h/cxx
-          throw std::logic_error(
-            __FUNCTION__ + std::string(" not implemented.")
-          );
-          // vertex_to_update->override_inputs();
+      if (uuid_index_.find(vertex_uuid) != uuid_index_.end()) {
+        dirty_.emplace(vertex_uuid.clone());
+        structural_hash_valid_ = false;
+        ret = true;
+      }
+
+      return ret;
+    }
+
+    std::vector<std::weak_ptr<DAGVertex>> DAG::dirty_vertices() const {
+      std::vector<std::weak_ptr<DAGVertex>> ret;
+
+      for (const UUID &u : dirty_) {
+        auto found = uuid_index_.find(u);
+        if (found != uuid_index_.end()) {
+          ret.push_back(found->second);
         }
       }
+
+      return ret;
+    }
+
+    void DAG::clear_dirty() { dirty_.clear(); }
+
+    std::uint64_t DAG::structural_hash() const {
+      if (!structural_hash_valid_) {
+        std::vector<std::uint64_t> root_hashes;
+        for (const std::shared_ptr<DAGVertex> &v : graph_) {
+          if (v->predecessors().empty()) {
+            root_hashes.push_back(v->structural_hash());
+          }
+        }
+        std::sort(root_hashes.begin(), root_hashes.end());
+
+        ContentHash hash;
+        hash.add(
+          json_config_ ? ContentHash::canonical_json(*json_config_)
+                       : std::string()
+        );
+        hash.add(static_cast<std::uint64_t>(root_hashes.size()));
+        for (std::uint64_t h : root_hashes) {
+          hash.add(h);
+        }
+        structural_hash_ = hash.value();
+        structural_hash_valid_ = true;
+      }
+
+      return structural_hash_;
     }
 
     std::ostream &operator<<(std::ostream &out, const DAG &g) {
@@ -518,41 +778,41 @@ namespace com {
     }
 
     bool operator==(const DAG &lhs, const DAG &rhs) {
-      bool ret = true;
+      bool ret = lhs.title_ == rhs.title_ &&
+                 lhs.vertex_count() == rhs.vertex_count() &&
+                 lhs.edge_count() == rhs.edge_count() &&
+                 lhs.structural_hash() == rhs.structural_hash();
 
-      ret &= (lhs.graph_.size() == rhs.graph_.size());
-
-      DAG lhs_clone = (*const_cast<DAG *>(&lhs)).clone();
-      DAG rhs_clone = (*const_cast<DAG *>(&rhs)).clone();
-
-      std::sort(
-        lhs_clone.graph_.begin(), lhs_clone.graph_.end(),
-        [](std::shared_ptr<DAGVertex> a, std::shared_ptr<DAGVertex> b) {
-          return a->label() < b->label();
-        }
-      );
-      std::sort(
-        rhs_clone.graph_.begin(), rhs_clone.graph_.end(),
-        [](std::shared_ptr<DAGVertex> a, std::shared_ptr<DAGVertex> b) {
-          return a->label() < b->label();
-        }
-      );
-
-      std::size_t index = 0;
-      for (auto v : lhs.graph_) {
-        ret &= ((*v) == (*(rhs.graph_[index])));
-        auto o = rhs.graph_[index]; // Force use count up.
-        ret &= (v.use_count() == o.use_count());
-
-        if (!ret) {
-          break;
-        }
-
-        ++index;
+      if (ret) {
+        // The hashes could collide, so confirm without them: each vertex
+        // by its label, task, degree and the labels it leads to, which
+        // UUIDs and insertion order do not change.
+        typedef std::tuple<
+          std::string, bool, std::uint64_t, std::size_t,
+          std::vector<std::string>>
+          Shape_t;
+        auto shapes = [](const DAG &g) {
+          std::vector<Shape_t> all;
+          all.reserve(g.graph_.size());
+          for (const std::shared_ptr<DAGVertex> &v : g.graph_) {
+            const Task *t = v->task();
+            std::vector<std::string> successors;
+            successors.reserve(v->successors().size());
+            for (const DAGVertex *next : v->successors()) {
+              successors.push_back(next->label());
+            }
+            std::sort(successors.begin(), successors.end());
+            all.emplace_back(
+              v->label(), t != nullptr,
+              (t != nullptr) ? t->content_hash() : 0,
+              v->incomming_edge_count(), std::move(successors)
+            );
+          }
+          std::sort(all.begin(), all.end());
+          return all;
+        };
+        ret = shapes(lhs) == shapes(rhs);
       }
-      ret &= (lhs.vertex_count() == rhs.vertex_count());
-      ret &= (lhs.edge_count() == rhs.edge_count());
-      ret &= (lhs.json_config() == rhs.json_config());
 
       return ret;
     }
@@ -577,43 +837,292 @@ namespace com {
       for (auto &connection : from_connections) {
         std::weak_ptr<DAGVertex> find = find_vertex(connection.vertex());
         assert(!find.expired() && "This should never happen.");
-        to.connect(find.lock());
+        if (to.connect(find.lock())) {
+          to.edges_.back()->condition_ = connection.edge().condition_;
+        }
       }
     }
 
-    DAG::DAG(const DAG &other) :
-      LoggedClass(*this),
-      json_config_(std::make_unique<rapidjson::Document>()) {
-      DAG *o = (const_cast<DAG *>(&other));
-      o->linear_traversal([&](std::shared_ptr<DAGVertex> v) {
-        DAGVertex tmp = v->clone();
-        add_vertex(std::move(tmp));
-      });
+    bool DAG::order_for_edge(
+      const DAGVertex &from, const DAGVertex &to, bool reorder
+    ) {
+      if (&from == &to) {
+        return false;
+      }
 
-      for (std::size_t i = 0; i < graph_.size(); ++i) {
-        clone_connections(*other.graph_[i], *graph_[i]);
+      const std::size_t lower = topological_index_.at(&to);
+      const std::size_t upper = topological_index_.at(&from);
+      if (upper < lower) {
+        return true;
       }
-      title_ = other.title_;
-      json_config_->CopyFrom(
-        (*other.json_config_), json_config_->GetAllocator()
+
+      // Only vertices ordered between to and from can lie on a path that
+      // leads from to back to from, so the search never leaves that region
+      // (Marchetti-Spaccamela et al. / Pearce-Kelly forward search).
+      std::unordered_set<const DAGVertex *> reached{&to};
+      std::vector<const DAGVertex *> to_visit{&to};
+      while (!to_visit.empty()) {
+        const DAGVertex *curr = to_visit.back();
+        to_visit.pop_back();
+
+        for (const DAGVertex::Edge_t &e : curr->edges_) {
+          std::shared_ptr<DAGVertex> next = e->connection_.lock();
+          if (next == nullptr) {
+            continue;
+          }
+          if (next.get() == &from) {
+            return false;
+          }
+          auto it = topological_index_.find(next.get());
+          if (it != topological_index_.end() && it->second < upper &&
+              reached.insert(next.get()).second) {
+            to_visit.push_back(next.get());
+          }
+        }
+      }
+
+      if (reorder) {
+        // Everything reachable from to moves after from, and both groups
+        // keep their relative order, which keeps every existing edge valid.
+        std::vector<DAGVertex *> kept;
+        std::vector<DAGVertex *> shifted;
+        for (std::size_t i = lower; i <= upper; ++i) {
+          DAGVertex *v = topological_order_[i];
+          if (v != nullptr) {
+            (reached.count(v) ? shifted : kept).push_back(v);
+          }
+        }
+
+        std::size_t position = lower;
+        for (DAGVertex *v : kept) {
+          place_in_topological_order(v, position++);
+        }
+        for (DAGVertex *v : shifted) {
+          place_in_topological_order(v, position++);
+        }
+        for (; position <= upper; ++position) {
+          topological_order_[position] = nullptr;
+        }
+      }
+
+      return true;
+    }
+
+    void
+    DAG::place_in_topological_order(DAGVertex *v, std::size_t position) {
+      topological_order_[position] = v;
+      topological_index_[v] = position;
+    }
+
+    void DAG::drop_from_topological_order(const DAGVertex *v) {
+      auto it = topological_index_.find(v);
+      if (it != topological_index_.end()) {
+        topological_order_[it->second] = nullptr;
+        topological_index_.erase(it);
+      }
+
+      // Squeeze out the holes once they make up most of the order so the
+      // regions scanned by order_for_edge stay proportional to the graph.
+      if (topological_order_.size() > 2 * (topological_index_.size() + 16)) {
+        std::size_t position = 0;
+        for (std::size_t i = 0; i < topological_order_.size(); ++i) {
+          DAGVertex *curr = topological_order_[i];
+          if (curr != nullptr) {
+            place_in_topological_order(curr, position++);
+          }
+        }
+        topological_order_.resize(position);
+      }
+    }
+
+    std::shared_ptr<DAGVertex> DAG::make_vertex(DAGVertex &&v) {
+      std::shared_ptr<DAGVertex> ret = std::allocate_shared<DAGVertex>(
+        DAGPoolAllocator<DAGVertex>(memory_pool_), std::move(v)
       );
+      // Edges already drawn belong to the pool v came with, so only a
+      // vertex without one starts drawing from this DAG's pool.
+      if (ret->pool_ == nullptr) {
+        ret->pool_ = memory_pool_;
+      }
+
+      return ret;
     }
 
-    DAG &DAG::operator=(const DAG &rhs) {
-      DAG &o = *(const_cast<DAG *>(&rhs));
-      o.linear_traversal([&](std::shared_ptr<DAGVertex> v) {
-        DAGVertex tmp = v->clone();
-        add_vertex(std::move(tmp));
+    void DAG::detach_vertex(const std::shared_ptr<DAGVertex> &v) {
+      unindex_label(v.get());
+      unlink_vertex(v);
+      dirty_.erase(v->get_uuid());
+      // graph_ keeps insertion order, which traversal relies on, so this is
+      // the one step that is not bounded by the degree of v.
+      graph_.erase(std::find(graph_.begin(), graph_.end(), v));
+    }
+
+    void DAG::unlink_vertex(const std::shared_ptr<DAGVertex> &v) {
+      topology_changed();
+      drop_from_topological_order(v.get());
+      v->clear_incomming_edges();
+      v->visit_all_edges([&](const DAGEdge &e) {
+        if (e.connection_.lock() != nullptr) {
+          e.connection_.lock()->sub_incomming_edge();
+        }
       });
+      v->clear_edges();
+    }
 
-      for (std::size_t i = 0; i < graph_.size(); ++i) {
-        clone_connections(*rhs.graph_[i], *graph_[i]);
+    const ReachabilityIndex &DAG::reachability_index() {
+      if (!reachability_) {
+        std::shared_ptr<const FrozenDAG> frozen =
+          std::make_shared<const FrozenDAG>(*this);
+        reachability_ = std::make_shared<const ReachabilityIndex>(*frozen);
+        frozen_ = std::move(frozen);
       }
 
-      title_ = rhs.title_;
-      json_config_->CopyFrom(
-        (*rhs.json_config_), json_config_->GetAllocator()
-      );
+      return *reachability_;
+    }
+
+    void DAG::topology_changed() {
+      frozen_.reset();
+      reachability_.reset();
+      structural_hash_valid_ = false;
+    }
+
+    void DAG::index_label(const std::shared_ptr<DAGVertex> &v) {
+      const LabelPool::Id id = labels_.intern(v->label());
+      if (id == label_index_.size()) {
+        label_index_.emplace_back();
+      }
+      label_index_[id].push_back(v);
+    }
+
+    void DAG::unindex_label(const DAGVertex *v) {
+      const LabelPool::Id id = labels_.find(v->label());
+      if (id != LabelPool::npos) {
+        DAG_t &with_label = label_index_[id];
+        auto it = std::find_if(
+          with_label.begin(), with_label.end(),
+          [&](const std::shared_ptr<DAGVertex> &w) { return w.get() == v; }
+        );
+        if (it != with_label.end()) {
+          with_label.erase(it);
+        }
+      }
+    }
+
+    void DAG::rebuild_topological_order() {
+      std::unordered_map<const DAGVertex *, std::size_t> in_degree;
+      for (const std::shared_ptr<DAGVertex> &v : graph_) {
+        in_degree.emplace(v.get(), 0);
+      }
+      for (const std::shared_ptr<DAGVertex> &v : graph_) {
+        for (const DAGVertex::Edge_t &e : v->edges_) {
+          std::shared_ptr<DAGVertex> next = e->connection_.lock();
+          auto it = in_degree.find(next.get());
+          if (it != in_degree.end()) {
+            ++(it->second);
+          }
+        }
+      }
+
+      topological_order_.clear();
+      topological_index_.clear();
+      topological_order_.reserve(graph_.size());
+      for (const std::shared_ptr<DAGVertex> &v : graph_) {
+        if (in_degree[v.get()] == 0) {
+          topological_order_.push_back(v.get());
+        }
+      }
+      // topological_order_ doubles as Kahn's queue.
+      for (std::size_t head = 0; head < topological_order_.size(); ++head) {
+        DAGVertex *curr = topological_order_[head];
+        topological_index_[curr] = head;
+        for (const DAGVertex::Edge_t &e : curr->edges_) {
+          std::shared_ptr<DAGVertex> next = e->connection_.lock();
+          auto it = in_degree.find(next.get());
+          if (it != in_degree.end() && --(it->second) == 0) {
+            topological_order_.push_back(next.get());
+          }
+        }
+      }
+
+      // Vertices connected behind the DAG's back (DAGVertex::connect) can
+      // form a cycle. Keep them indexed so lookups still work; the order is
+      // only meaningful for the acyclic part.
+      if (topological_order_.size() != graph_.size()) {
+        for (const std::shared_ptr<DAGVertex> &v : graph_) {
+          if (topological_index_.count(v.get()) == 0) {
+            topological_order_.push_back(nullptr);
+            place_in_topological_order(
+              v.get(), topological_order_.size() - 1
+            );
+          }
+        }
+      }
+    }
+
+    void DAG::set_json_config(const rapidjson::Document &json_config) {
+      std::shared_ptr<rapidjson::Document> doc =
+        std::make_shared<rapidjson::Document>();
+      doc->CopyFrom(json_config, doc->GetAllocator());
+      json_config_ = std::move(doc);
+      structural_hash_valid_ = false;
+    }
+
+    void DAG::copy_from(const DAG &other) {
+      std::unordered_map<const DAGVertex *, std::shared_ptr<DAGVertex>>
+        copies;
+      copies.reserve(other.graph_.size());
+      graph_.reserve(other.graph_.size());
+      for (const std::shared_ptr<DAGVertex> &v : other.graph_) {
+        // The copy shares v's Task until one of them asks to change it.
+        std::shared_ptr<DAGVertex> copy = make_vertex(v->clone());
+        graph_.push_back(copy);
+        uuid_index_.emplace(copy->get_uuid().clone(), copy);
+        index_label(copy);
+        copies.emplace(v.get(), std::move(copy));
+      }
+
+      for (const std::shared_ptr<DAGVertex> &v : other.graph_) {
+        DAGVertex &from = *copies[v.get()];
+        for (const DAGVertex::Edge_t &e : v->edges_) {
+          auto to = copies.find(e->connection_.lock().get());
+          assert(to != copies.end() && "This should never happen.");
+          if (from.connect(to->second)) {
+            from.edges_.back()->condition_ = e->condition_;
+          }
+        }
+      }
+
+      // other's order is already valid for the same topology, so it is
+      // carried over rather than recomputed.
+      topological_order_.reserve(other.topological_order_.size());
+      for (const DAGVertex *v : other.topological_order_) {
+        DAGVertex *copy = (v != nullptr) ? copies[v].get() : nullptr;
+        if (copy != nullptr) {
+          topological_index_[copy] = topological_order_.size();
+        }
+        topological_order_.push_back(copy);
+      }
+
+      for (const UUID &u : other.dirty_) {
+        dirty_.emplace(u.clone());
+      }
+      title_ = other.title_;
+      json_config_ = other.json_config_;
+      // The copy has the same structure, so other's hash holds for it.
+      structural_hash_ = other.structural_hash_;
+      structural_hash_valid_ = other.structural_hash_valid_;
+    }
+
+    DAG::DAG(const DAG &other) :
+      LoggedClass(*this), memory_pool_(std::make_shared<DAGMemoryPool>()) {
+      copy_from(other);
+    }
+
+    DAG &DAG::operator=(const DAG &rhs) {
+      if (this != &rhs) {
+        reset();
+        copy_from(rhs);
+      }
       Logging::info(LOG_TAG, "Assigned DAG with title=", title_);
 
       return (*this);
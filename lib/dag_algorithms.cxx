@@ -2,12 +2,145 @@
 
 #include "dag_scheduler/dag_edge.h"
 #include "dag_scheduler/dag_vertex.h"
+#include "dag_scheduler/frozen_dag.h"
 #include "dag_scheduler/logging.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace com {
   namespace dag_scheduler {
+    namespace {
+      typedef FrozenDAG::Index Index;
+
+      /**
+       * @brief Threads that split each frontier of a sweep over a
+       *        \ref FrozenDAG between them.
+       *
+       * The caller takes part as worker 0, so a \ref FrontierPool of one
+       * thread runs everything inline. Work is handed out a chunk of
+       * indices at a time, and every call to \ref for_each is a barrier.
+       */
+      class FrontierPool {
+      public:
+        explicit FrontierPool(std::size_t threads) :
+          out_(std::max<std::size_t>(threads, 1)) {
+          for (std::size_t id = 1; id < out_.size(); ++id) {
+            workers_.emplace_back([this, id]() { serve(id); });
+          }
+        }
+
+        ~FrontierPool() {
+          {
+            std::lock_guard<std::mutex> lock(lock_);
+            stop_ = true;
+          }
+          cond_.notify_all();
+          for (std::thread &worker : workers_) {
+            worker.join();
+          }
+        }
+
+        /**
+         * @brief Call visit(i, out) for every i below \p count and gather
+         *        what was appended to out into \p next.
+         */
+        template <typename Visit>
+        void for_each(
+          std::size_t count, const Visit &visit, std::vector<Index> &next
+        ) {
+          cursor_.store(0);
+          auto job = [this, count, &visit](std::size_t id) {
+            std::vector<Index> &out = out_[id];
+            for (std::size_t at = cursor_.fetch_add(chunk); at < count;
+                 at = cursor_.fetch_add(chunk)) {
+              const std::size_t end = std::min(at + chunk, count);
+              for (; at < end; ++at) {
+                visit(at, out);
+              }
+            }
+          };
+
+          if (workers_.empty() || count <= chunk) {
+            job(0);
+          } else {
+            {
+              std::lock_guard<std::mutex> lock(lock_);
+              job_ = job;
+              busy_ = workers_.size();
+              ++generation_;
+            }
+            cond_.notify_all();
+            job(0);
+            std::unique_lock<std::mutex> lock(lock_);
+            cond_.wait(lock, [this]() { return busy_ == 0; });
+            job_ = nullptr;
+          }
+
+          next.clear();
+          for (std::vector<Index> &out : out_) {
+            next.insert(next.end(), out.begin(), out.end());
+            out.clear();
+          }
+        }
+
+      private:
+        void serve(std::size_t id) {
+          std::size_t seen = 0;
+          while (true) {
+            std::function<void(std::size_t)> job;
+            {
+              std::unique_lock<std::mutex> lock(lock_);
+              cond_.wait(lock, [this, seen]() {
+                return stop_ || generation_ != seen;
+              });
+              if (stop_) {
+                break;
+              }
+              seen = generation_;
+              job = job_;
+            }
+            job(id);
+            std::lock_guard<std::mutex> lock(lock_);
+            if (--busy_ == 0) {
+              cond_.notify_all();
+            }
+          }
+        }
+
+      private:
+        static constexpr std::size_t chunk = 1024;
+
+        std::vector<std::vector<Index>> out_;
+        std::vector<std::thread> workers_;
+        std::atomic<std::size_t> cursor_{0};
+        std::mutex lock_;
+        std::condition_variable cond_;
+        std::function<void(std::size_t)> job_;
+        std::size_t busy_ = 0;
+        std::size_t generation_ = 0;
+        bool stop_ = false;
+      };
+
+      constexpr std::size_t FrontierPool::chunk;
+
+      std::size_t thread_count(const FrozenDAG &plan, std::size_t threads) {
+        std::size_t ret = threads;
+        if (ret == 0) {
+          ret = (plan.vertex_count() >= parallel_vertex_threshold)
+                  ? std::thread::hardware_concurrency()
+                  : 1;
+        }
+        return std::max<std::size_t>(ret, 1);
+      }
+    } // namespace
+
     std::vector<std::shared_ptr<DAGVertex>>
     dag_vertices_with_no_incomming_edges(DAG &g) {
       std::vector<std::shared_ptr<DAGVertex>> output;
@@ -30,96 +163,303 @@ namespace com {
       dag_topological_sort_init.store(true);
 
       sorted_vertices.clear();
-      // Sorted nodes.
-      std::list<std::shared_ptr<DAGVertex>> L;
-      // Set of nodes with no incomming edges.
-      auto Qv = dag_vertices_with_no_incomming_edges(g);
-      std::list<std::shared_ptr<DAGVertex>> Q(Qv.begin(), Qv.end());
-
-      while (!Q.empty()) {
-        std::shared_ptr<DAGVertex> curr = Q.front();
-        Q.pop_front();
-        L.push_back(curr);
-
-        curr->visit_all_edges([&](const DAGEdge &e) {
-          DAGEdge &e_ref = *const_cast<DAGEdge *>(&e);
-          std::shared_ptr<DAGVertex> m = e_ref.get_connection().lock();
-          e_ref.connect_to(nullptr);
-          assert(m && "Removing connection got rid of shared_ptr.");
-          if (!(m->has_incomming_edges())) {
-            Q.push_back(m);
-          }
-        });
-      }
-
-      ret = (L.size() != g.vertex_count());
-      for (std::shared_ptr<DAGVertex> v : L) {
+      std::vector<std::shared_ptr<DAGVertex>> sorted;
+      TopologicalSorter sorter;
+      ret = !sorter.sort(g, sorted);
+      for (const std::shared_ptr<DAGVertex> &v : sorted) {
         sorted_vertices.push_back(v->clone());
       }
 
       if (ret) {
         Logging::fatal(
-          LOG_TAG, "Failed to sort vertices.", (g.vertex_count() - L.size()),
-          "failed to sort."
+          LOG_TAG, "Failed to sort vertices.",
+          (g.vertex_count() - sorted.size()), "failed to sort."
         );
       }
 
       return ret;
     }
 
+    bool TopologicalSorter::sort(
+      const FrozenDAG &plan, std::vector<FrozenDAG::Index> &order
+    ) {
+      const std::vector<FrozenDAG::Index> &in_degrees = plan.in_degrees();
+      in_degree_.assign(in_degrees.begin(), in_degrees.end());
+      order.clear();
+      order.reserve(plan.vertex_count());
+      for (std::size_t i = 0; i < in_degree_.size(); ++i) {
+        if (in_degree_[i] == 0) {
+          order.push_back(static_cast<FrozenDAG::Index>(i));
+        }
+      }
+      // order doubles as Kahn's queue; everything before head is done.
+      for (std::size_t head = 0; head < order.size(); ++head) {
+        for (FrozenDAG::Index s : plan.successors(order[head])) {
+          if (--in_degree_[static_cast<std::size_t>(s)] == 0) {
+            order.push_back(s);
+          }
+        }
+      }
+
+      return order.size() == plan.vertex_count();
+    }
+
+    bool TopologicalSorter::sort(
+      DAG &g, std::vector<std::shared_ptr<DAGVertex>> &order
+    ) {
+      const FrozenDAG plan(g);
+      const bool ret = sort(plan, order_);
+
+      order.clear();
+      order.reserve(order_.size());
+      for (FrozenDAG::Index i : order_) {
+        order.push_back(plan.vertex(i));
+      }
+
+      return ret;
+    }
+
+    bool dag_levels(
+      const FrozenDAG &plan, std::vector<Index> &levels, std::size_t threads
+    ) {
+      const std::size_t n = plan.vertex_count();
+      FrontierPool pool(thread_count(plan, threads));
+      std::unique_ptr<std::atomic<Index>[]> remaining(
+        new std::atomic<Index>[n]
+      );
+      std::vector<Index> frontier;
+      std::vector<Index> next;
+
+      levels.resize(n);
+      pool.for_each(
+        n,
+        [&](std::size_t i, std::vector<Index> &out) {
+          const Index in_degree = plan.in_degree(static_cast<Index>(i));
+          remaining[i].store(in_degree);
+          if (in_degree == 0) {
+            out.push_back(static_cast<Index>(i));
+          }
+        },
+        frontier
+      );
+
+      std::size_t visited = 0;
+      for (Index level = 0; !frontier.empty(); ++level) {
+        visited += frontier.size();
+        pool.for_each(
+          frontier.size(),
+          [&](std::size_t at, std::vector<Index> &out) {
+            const Index v = frontier[at];
+            levels[static_cast<std::size_t>(v)] = level;
+            for (Index s : plan.successors(v)) {
+              if (remaining[static_cast<std::size_t>(s)].fetch_sub(1) == 1) {
+                out.push_back(s);
+              }
+            }
+          },
+          next
+        );
+        frontier.swap(next);
+      }
+
+      const bool ret = (visited == n);
+      if (!ret) {
+        levels.clear();
+      }
+
+      return ret;
+    }
+
+    bool upward_ranks(
+      const FrozenDAG &plan, const std::vector<double> &costs,
+      std::vector<double> &ranks, std::size_t threads
+    ) {
+      assert(costs.size() == plan.vertex_count() && "One cost per vertex.");
+      const std::size_t n = plan.vertex_count();
+      FrontierPool pool(thread_count(plan, threads));
+      std::unique_ptr<std::atomic<Index>[]> remaining(
+        new std::atomic<Index>[n]
+      );
+      std::vector<Index> frontier;
+      std::vector<Index> next;
+
+      ranks.resize(n);
+      pool.for_each(
+        n,
+        [&](std::size_t i, std::vector<Index> &out) {
+          const Index out_degree =
+            static_cast<Index>(plan.successors(static_cast<Index>(i)).size());
+          remaining[i].store(out_degree);
+          if (out_degree == 0) {
+            out.push_back(static_cast<Index>(i));
+          }
+        },
+        frontier
+      );
+
+      // A vertex joins the frontier once all of its successors are ranked,
+      // and those were ranked in an earlier round.
+      std::size_t visited = 0;
+      while (!frontier.empty()) {
+        visited += frontier.size();
+        pool.for_each(
+          frontier.size(),
+          [&](std::size_t at, std::vector<Index> &out) {
+            const Index v = frontier[at];
+            double longest = 0.0;
+            for (Index s : plan.successors(v)) {
+              longest = std::max(longest, ranks[static_cast<std::size_t>(s)]);
+            }
+            ranks[static_cast<std::size_t>(v)] =
+              costs[static_cast<std::size_t>(v)] + longest;
+            for (Index p : plan.predecessors(v)) {
+              if (remaining[static_cast<std::size_t>(p)].fetch_sub(1) == 1) {
+                out.push_back(p);
+              }
+            }
+          },
+          next
+        );
+        frontier.swap(next);
+      }
+
+      const bool ret = (visited == n);
+      if (!ret) {
+        ranks.clear();
+      }
+
+      return ret;
+    }
+
+    std::size_t downstream_closure(
+      const FrozenDAG &plan, const std::vector<Index> &seeds,
+      std::vector<bool> &closure
+    ) {
+      closure.assign(plan.vertex_count(), false);
+      std::vector<Index> stack;
+      for (Index i : seeds) {
+        if (!closure[static_cast<std::size_t>(i)]) {
+          closure[static_cast<std::size_t>(i)] = true;
+          stack.push_back(i);
+        }
+      }
+
+      std::size_t ret = stack.size();
+      while (!stack.empty()) {
+        const Index curr = stack.back();
+        stack.pop_back();
+        for (Index s : plan.successors(curr)) {
+          if (!closure[static_cast<std::size_t>(s)]) {
+            closure[static_cast<std::size_t>(s)] = true;
+            stack.push_back(s);
+            ++ret;
+          }
+        }
+      }
+
+      return ret;
+    }
+
+    std::size_t chain_links(const FrozenDAG &plan, std::vector<Index> &next) {
+      std::size_t ret = 0;
+
+      next.assign(plan.vertex_count(), FrozenDAG::npos);
+      for (std::size_t i = 0; i < next.size(); ++i) {
+        FrozenDAG::IndexRange successors =
+          plan.successors(static_cast<Index>(i));
+        if (successors.size() == 1 && plan.in_degree(successors[0]) == 1) {
+          next[i] = successors[0];
+          ++ret;
+        }
+      }
+
+      return ret;
+    }
+
     bool
     process_dag(DAG &g, processed_order_type &out, TaskScheduler &scheduler) {
       bool ret = false;
       LogTag LOG_TAG(__FUNCTION__);
       Logging::add_std_cout_logger(LOG_TAG);
 
-      DAG g_clone = g.clone();
-      DAG g_check = g.clone();
-
-      std::list<DAGVertex> check;
-      ret = !dag_topological_sort(g_check, check);
-      if (ret && check.size() == g_clone.vertex_count()) {
+      // Levels are found over a snapshot, so neither g nor a copy of it is
+      // taken apart to find them.
+      std::shared_ptr<const FrozenDAG> snapshot =
+        std::make_shared<const FrozenDAG>(g);
+      const FrozenDAG &plan = *snapshot;
+      std::vector<Index> vertex_levels;
+      ret = dag_levels(plan, vertex_levels);
+      if (ret) {
         out.clear();
-        std::vector<std::shared_ptr<DAGVertex>>
-          curr_dag_vertices_with_no_incomming_edges =
-            dag_vertices_with_no_incomming_edges(g_clone);
-
-        std::vector<DAGVertex> vertices_to_process;
-        while (!curr_dag_vertices_with_no_incomming_edges.empty()) {
-          std::for_each(
-            curr_dag_vertices_with_no_incomming_edges.begin(),
-            curr_dag_vertices_with_no_incomming_edges.end(),
-            [&](std::shared_ptr<DAGVertex> v) {
-              DAGVertex v_clone = v->clone();
-              assert(
-                g_clone.remove_vertex(*(v.get())) &&
-                "Failed to remove vertex from graph."
-              );
-              vertices_to_process.push_back(std::move(v_clone));
-            }
-          );
-
-          out.push_back({});
-          for (DAGVertex &v : vertices_to_process) {
-            out.back().push_back(v.clone());
+        // Filling the levels in index order keeps each one in the order
+        // the vertices were added to g.
+        for (std::size_t i = 0; i < vertex_levels.size(); ++i) {
+          const std::size_t level =
+            static_cast<std::size_t>(vertex_levels[i]);
+          if (level >= out.size()) {
+            out.resize(level + 1);
           }
-          std::for_each(
-            vertices_to_process.begin(), vertices_to_process.end(),
-            [&](DAGVertex &vertex) {
-              scheduler.queue_task(std::move(vertex.get_task()));
-            }
-          );
-          vertices_to_process.clear();
-
-          curr_dag_vertices_with_no_incomming_edges.clear();
-          curr_dag_vertices_with_no_incomming_edges =
-            dag_vertices_with_no_incomming_edges(g_clone);
+          out[level].push_back(plan.vertex(static_cast<Index>(i))->clone());
         }
+        DAGExecution::start(std::move(snapshot), scheduler);
       } else {
         Logging::fatal(LOG_TAG, g.title(), "was cyclic.");
       }
 
       return ret;
     }
+
+    std::shared_ptr<DAGExecution> execute_dag(
+      DAG &g, TaskScheduler &scheduler, std::shared_ptr<TaskCostModel> costs,
+      std::shared_ptr<TaskResultCache> cache, bool fuse_chains
+    ) {
+      return DAGExecution::start(
+        std::make_shared<const FrozenDAG>(g), scheduler, std::move(costs),
+        std::move(cache), fuse_chains
+      );
+    }
+
+    std::shared_ptr<DAGExecution> execute_dag_incremental(
+      DAG &g, TaskScheduler &scheduler, const DAGExecution &previous,
+      std::shared_ptr<TaskCostModel> costs,
+      std::shared_ptr<TaskResultCache> cache, bool fuse_chains
+    ) {
+      std::shared_ptr<DAGExecution> ret;
+      LogTag LOG_TAG(__FUNCTION__);
+      Logging::add_std_cout_logger(LOG_TAG);
+
+      // The plan of previous is only reusable if g still has the same
+      // vertices and as many edges.
+      const FrozenDAG &plan = previous.plan();
+      bool same_topology = (g.vertex_count() == plan.vertex_count() &&
+                            g.edge_count() == plan.edge_count());
+      for (std::size_t i = 0; same_topology && i < plan.vertex_count(); ++i) {
+        const std::shared_ptr<DAGVertex> &v =
+          plan.vertex(static_cast<Index>(i));
+        same_topology = (g.find_vertex_by_uuid(v->get_uuid()).lock() == v);
+      }
+
+      if (same_topology) {
+        std::vector<Index> dirty;
+        for (const std::weak_ptr<DAGVertex> &v : g.dirty_vertices()) {
+          dirty.push_back(plan.index_of(v.lock()->get_uuid()));
+        }
+        ret = DAGExecution::restart(
+          previous, dirty, scheduler, std::move(costs), std::move(cache),
+          fuse_chains
+        );
+      } else {
+        Logging::info(
+          LOG_TAG, g.title(), "changed shape since it last ran, running all",
+          "of it."
+        );
+        ret = execute_dag(
+          g, scheduler, std::move(costs), std::move(cache), fuse_chains
+        );
+      }
+      g.clear_dirty();
+
+      return ret;
+    }
   } // namespace dag_scheduler
 } // namespace com
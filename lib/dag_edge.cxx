@@ -1,28 +1,61 @@
 #include "dag_scheduler/dag_edge.h"
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
 
 namespace com {
   namespace dag_scheduler {
-    DAGEdge::DAGEdge() : current_status_(Status::initialized) {}
+    namespace {
+      void erase_one(std::vector<DAGVertex *> &vs, const DAGVertex *v) {
+        auto it = std::find(vs.begin(), vs.end(), v);
+        if (it != vs.end()) {
+          vs.erase(it);
+        }
+      }
+    } // namespace
+
+    void DAGEdgeDeleter::operator()(DAGEdge *e) const {
+      if (pool == nullptr) {
+        delete e;
+      } else {
+        e->~DAGEdge();
+        pool->deallocate(e, sizeof(DAGEdge));
+      }
+    }
+
+    DAGEdge::DAGEdge() :
+      current_status_(Status::initialized), source_(nullptr),
+      target_(nullptr) {}
 
     DAGEdge::~DAGEdge() {
+      unlink();
       current_status_ = Status::non_traverable;
       connection_.reset();
     }
 
-    DAGEdge::DAGEdge(DAGEdge &&other) {
+    DAGEdge::DAGEdge(DAGEdge &&other) :
+      source_(other.source_), target_(other.target_),
+      condition_(std::move(other.condition_)) {
       uuid_ = std::move(other.uuid_);
       current_status_ = other.current_status_;
       connection_ = std::move(other.connection_);
       other.current_status_ = Status::non_traverable;
+      other.source_ = nullptr;
+      other.target_ = nullptr;
     }
 
     DAGEdge &DAGEdge::operator=(DAGEdge &&rhs) {
+      unlink();
       uuid_ = std::move(rhs.uuid_);
       current_status_ = rhs.current_status_;
       connection_ = std::move(rhs.connection_);
+      source_ = rhs.source_;
+      target_ = rhs.target_;
+      condition_ = std::move(rhs.condition_);
       rhs.current_status_ = Status::non_traverable;
+      rhs.source_ = nullptr;
+      rhs.target_ = nullptr;
 
       return (*this);
     }
@@ -38,15 +71,33 @@ namespace com {
         connection_.lock()->sub_incomming_edge();
         ret = false;
       }
+      unlink();
 
       connection_ = v;
+      target_ = v.get();
       if (!connection_.expired()) {
         connection_.lock()->add_incomming_edge();
       }
+      link();
 
       return ret;
     }
 
+    void DAGEdge::link() {
+      if (source_ != nullptr && target_ != nullptr) {
+        source_->add_successor(target_);
+        target_->predecessors_.push_back(source_);
+      }
+    }
+
+    void DAGEdge::unlink() {
+      if (source_ != nullptr && target_ != nullptr) {
+        source_->remove_successor(target_);
+        erase_one(target_->predecessors_, source_);
+      }
+      target_ = nullptr;
+    }
+
     bool DAGEdge::is_a_connection_to(const DAGVertex &v) const {
       bool ret = false;
 
@@ -63,6 +114,10 @@ namespace com {
       return current_status_;
     }
 
+    std::shared_ptr<const DAGEdge::Condition_t> DAGEdge::condition() const {
+      return condition_;
+    }
+
     std::string DAGEdge::current_status_as_string() const {
       std::string ret;
 
@@ -84,12 +139,15 @@ namespace com {
     DAGEdge::DAGEdge(const DAGEdge &other) :
       uuid_(const_cast<DAGEdge *>(&other)->uuid_.clone()),
       current_status_(other.current_status()),
-      connection_(/*We cannot connect because we do NOT own.*/) {}
+      connection_(/*We cannot connect because we do NOT own.*/),
+      source_(nullptr), target_(nullptr), condition_(other.condition_) {}
 
     DAGEdge &DAGEdge::operator=(const DAGEdge &rhs) {
+      unlink();
       uuid_ = const_cast<DAGEdge *>(&rhs)->uuid_.clone();
       current_status_ = rhs.current_status();
       connection_.reset(/*We cannot connect because we do NOT own.*/);
+      condition_ = rhs.condition_;
 
       return (*this);
     }
@@ -116,7 +174,7 @@ namespace com {
     bool operator==(const DAGEdge &lhs, const DAGEdge &rhs) {
       bool ret = true;
 
-      ret &= (lhs.uuid_.as_string() == rhs.uuid_.as_string());
+      ret &= (lhs.uuid_ == rhs.uuid_);
       ret &= (lhs.current_status_ == rhs.current_status_);
 
       std::shared_ptr<DAGVertex> lhs_connection = lhs.connection_.lock();
@@ -0,0 +1,575 @@
+#include "dag_scheduler/dag_execution.h"
+
+#include "dag_scheduler/dag_algorithms.h"
+#include "dag_scheduler/logging.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace com {
+  namespace dag_scheduler {
+    namespace {
+      // Runs the members of a fused chain, through the DAGExecution that
+      // hands in run_chain, which runs and completes each member's Task.
+      class ChainStage : public TaskStage {
+      public:
+        ChainStage(
+          const std::string &label, std::function<bool()> run_chain
+        ) :
+          TaskStage(label), run_chain_(std::move(run_chain)),
+          running_(false) {}
+
+        virtual bool run() override {
+          running_.store(true);
+          const bool ret = run_chain_();
+          running_.store(false);
+          return ret;
+        }
+
+        virtual bool is_running() const override { return running_.load(); }
+
+        virtual bool end() override { return true; }
+
+        virtual void cleanup() override {}
+
+        virtual std::unique_ptr<TaskStage> clone() const override {
+          return std::make_unique<ChainStage>(label_, run_chain_);
+        }
+
+      private:
+        std::function<bool()> run_chain_;
+        std::atomic_bool running_;
+      };
+    } // namespace
+
+    DAGExecution::DAGExecution(
+      std::shared_ptr<const FrozenDAG> plan, TaskScheduler &scheduler,
+      std::shared_ptr<TaskCostModel> costs,
+      std::shared_ptr<TaskResultCache> cache, bool fuse_chains
+    ) :
+      plan_(std::move(plan)), scheduler_(scheduler), costs_(std::move(costs)),
+      cache_(std::move(cache)),
+      remaining_(new std::atomic<Index>[plan_->vertex_count()]),
+      blocked_(new std::atomic_bool[plan_->vertex_count()]),
+      reached_(new std::atomic_bool[plan_->vertex_count()]),
+      edge_status_(new std::atomic<DAGEdge::Status>[plan_->edge_count()]),
+      status_(new std::atomic<Status>[plan_->vertex_count()]),
+      holds_(new std::atomic<Index>[plan_->vertex_count()]),
+      child_failed_(new std::atomic_bool[plan_->vertex_count()]),
+      finished_(0), expected_(plan_->vertex_count()), expanded_(0),
+      failed_(false) {
+      for (std::size_t i = 0; i < plan_->vertex_count(); ++i) {
+        remaining_[i].store(plan_->in_degrees()[i]);
+        blocked_[i].store(false);
+        reached_[i].store(false);
+        status_[i].store(Status::pending);
+        holds_[i].store(1);
+        child_failed_[i].store(false);
+      }
+      for (std::size_t e = 0; e < plan_->edge_count(); ++e) {
+        edge_status_[e].store(DAGEdge::Status::initialized);
+      }
+
+      if (costs_) {
+        std::vector<double> vertex_costs(plan_->vertex_count(), 0.0);
+        for (std::size_t i = 0; i < vertex_costs.size(); ++i) {
+          const Task *task = plan_->vertex(static_cast<Index>(i))->task();
+          if (task != nullptr) {
+            vertex_costs[i] = costs_->estimate(*task);
+          }
+        }
+        upward_ranks(*plan_, vertex_costs, ranks_);
+      }
+
+      if (cache_) {
+        // Keys chain through the predecessors, so they are computed in a
+        // topological order. Upstream keys are sorted so that the order
+        // edges were added in does not matter.
+        std::vector<Index> order;
+        TopologicalSorter().sort(*plan_, order);
+        keys_.resize(plan_->vertex_count());
+        std::vector<TaskResultCache::Key> upstream;
+        for (Index i : order) {
+          upstream.clear();
+          for (Index p : plan_->predecessors(i)) {
+            upstream.push_back(keys_[static_cast<std::size_t>(p)]);
+          }
+          std::sort(upstream.begin(), upstream.end());
+          const Task *task = plan_->vertex(i)->task();
+          keys_[static_cast<std::size_t>(i)] =
+            (task != nullptr) ? TaskResultCache::key(*task, upstream)
+                              : TaskResultCache::key(upstream);
+        }
+      }
+
+      if (fuse_chains) {
+        chain_links(*plan_, chain_next_);
+        // The successor of a vertex that fans out may have to wait on its
+        // children, and the one of a conditional edge may be pruned, which
+        // the chain would not do.
+        for (std::size_t i = 0; i < chain_next_.size(); ++i) {
+          const Task *task = plan_->vertex(static_cast<Index>(i))->task();
+          if ((task != nullptr && task->fans_out()) ||
+              has_conditions(static_cast<Index>(i))) {
+            chain_next_[i] = FrozenDAG::npos;
+          }
+        }
+      }
+    }
+
+    DAGExecution::~DAGExecution() {}
+
+    std::shared_ptr<DAGExecution> DAGExecution::start(
+      std::shared_ptr<const FrozenDAG> plan, TaskScheduler &scheduler,
+      std::shared_ptr<TaskCostModel> costs,
+      std::shared_ptr<TaskResultCache> cache, bool fuse_chains
+    ) {
+      std::shared_ptr<DAGExecution> ret;
+      LogTag LOG_TAG(__FUNCTION__);
+      Logging::add_std_cout_logger(LOG_TAG);
+
+      // A vertex on a cycle would never be released, so wait() would never
+      // return.
+      std::vector<Index> order;
+      if (TopologicalSorter().sort(*plan, order)) {
+        ret.reset(new DAGExecution(
+          std::move(plan), scheduler, std::move(costs), std::move(cache),
+          fuse_chains
+        ));
+        for (Index i : order) {
+          if (ret->plan_->in_degree(i) != 0) {
+            // Roots come first in the order.
+            break;
+          }
+          const Status result = ret->dispatch(i);
+          if (result != Status::queued) {
+            ret->finish(i, result);
+          }
+        }
+      } else {
+        Logging::fatal(LOG_TAG, "Cannot execute a cyclic graph.");
+      }
+
+      return ret;
+    }
+
+    std::shared_ptr<DAGExecution> DAGExecution::restart(
+      const DAGExecution &previous, const std::vector<Index> &dirty,
+      TaskScheduler &scheduler, std::shared_ptr<TaskCostModel> costs,
+      std::shared_ptr<TaskResultCache> cache, bool fuse_chains
+    ) {
+      assert(previous.is_finished() && "The previous run is not finished.");
+      const FrozenDAG &plan = *previous.plan_;
+      const std::size_t n = plan.vertex_count();
+
+      std::vector<Index> seeds(dirty);
+      for (std::size_t i = 0; i < n; ++i) {
+        if (!is_success(previous.status_[i].load())) {
+          seeds.push_back(static_cast<Index>(i));
+        }
+      }
+      std::vector<bool> affected;
+      downstream_closure(plan, seeds, affected);
+
+      std::shared_ptr<DAGExecution> ret(new DAGExecution(
+        previous.plan_, scheduler, std::move(costs), std::move(cache),
+        fuse_chains
+      ));
+      // The affected vertices are closed under successors, so a clean
+      // vertex is never counted down or released by the run. Each
+      // affected vertex only waits on its affected predecessors. A clean
+      // vertex succeeded or was pruned, so its edges were decided and,
+      // as nothing it depends on changed, still are.
+      std::size_t reused = 0;
+      std::vector<Index> ready;
+      for (std::size_t i = 0; i < n; ++i) {
+        if (affected[i]) {
+          Index waiting_on = 0;
+          for (Index p : plan.predecessors(static_cast<Index>(i))) {
+            waiting_on += affected[static_cast<std::size_t>(p)] ? 1 : 0;
+          }
+          ret->remaining_[i].store(waiting_on);
+          if (waiting_on == 0) {
+            ready.push_back(static_cast<Index>(i));
+          }
+        } else {
+          const Index from = static_cast<Index>(i);
+          const FrozenDAG::IndexRange successors = plan.successors(from);
+          for (std::size_t k = 0; k < successors.size(); ++k) {
+            const std::size_t e =
+              static_cast<std::size_t>(plan.edge_index(from, k));
+            const DAGEdge::Status taken = previous.edge_status_[e].load();
+            ret->edge_status_[e].store(taken);
+            if (taken == DAGEdge::Status::traversed) {
+              ret->reached_[static_cast<std::size_t>(successors[k])].store(
+                true
+              );
+            }
+          }
+          ret->status_[i].store(
+            previous.status_[i].load() == Status::pruned ? Status::pruned
+                                                         : Status::reused
+          );
+          ++reused;
+        }
+      }
+      ret->finished_.store(reused);
+
+      // Collected first, since a released Task can complete and release
+      // further vertices before this loop is done.
+      for (Index i : ready) {
+        if (plan.in_degree(i) != 0 &&
+            !ret->reached_[static_cast<std::size_t>(i)].load()) {
+          // Every predecessor is clean and none of them leads here.
+          ret->finish(i, Status::pruned);
+        } else {
+          const Status result = ret->dispatch(i);
+          if (result != Status::queued) {
+            ret->finish(i, result);
+          }
+        }
+      }
+
+      return ret;
+    }
+
+    bool DAGExecution::wait() {
+      std::unique_lock<std::mutex> lock(finished_lock_);
+      finished_cond_.wait(lock, [this]() { return is_finished(); });
+      return succeeded();
+    }
+
+    bool DAGExecution::wait_for(const std::chrono::milliseconds &timeout) {
+      std::unique_lock<std::mutex> lock(finished_lock_);
+      return finished_cond_.wait_for(lock, timeout, [this]() {
+        return is_finished();
+      });
+    }
+
+    bool DAGExecution::is_finished() const {
+      // finished_ first: expected_ only grows, so they can only be read as
+      // equal once they were.
+      const std::size_t finished = finished_.load();
+      return finished == expected_.load();
+    }
+
+    bool DAGExecution::succeeded() const { return !failed_.load(); }
+
+    std::size_t DAGExecution::finished_count() const {
+      return finished_.load();
+    }
+
+    std::size_t DAGExecution::expanded_count() const {
+      return expanded_.load();
+    }
+
+    DAGExecution::Status DAGExecution::status(Index i) const {
+      assert(
+        static_cast<std::size_t>(i) < plan_->vertex_count() &&
+        "Index out of bounds."
+      );
+      return status_[static_cast<std::size_t>(i)].load();
+    }
+
+    double DAGExecution::rank(Index i) const {
+      assert(
+        static_cast<std::size_t>(i) < plan_->vertex_count() &&
+        "Index out of bounds."
+      );
+      return ranks_.empty() ? 0.0 : ranks_[static_cast<std::size_t>(i)];
+    }
+
+    DAGEdge::Status DAGExecution::edge_status(Index from, Index to) const {
+      DAGEdge::Status ret = DAGEdge::Status::initialized;
+
+      const FrozenDAG::IndexRange successors = plan_->successors(from);
+      for (std::size_t k = 0; k < successors.size(); ++k) {
+        if (successors[k] == to) {
+          const std::size_t e =
+            static_cast<std::size_t>(plan_->edge_index(from, k));
+          ret = edge_status_[e].load();
+          break;
+        }
+      }
+
+      return ret;
+    }
+
+    const FrozenDAG &DAGExecution::plan() const { return *plan_; }
+
+    bool DAGExecution::is_success(Status status) {
+      // A pruned vertex did not fail, it has nothing to pass on.
+      return status == Status::succeeded || status == Status::reused ||
+             status == Status::cached || status == Status::pruned;
+    }
+
+    bool DAGExecution::has_conditions(Index i) const {
+      bool ret = false;
+
+      if (plan_->condition_count() > 0) {
+        const std::size_t degree = plan_->successors(i).size();
+        for (std::size_t k = 0; !ret && k < degree; ++k) {
+          ret = plan_->condition(plan_->edge_index(i, k)) != nullptr;
+        }
+      }
+
+      return ret;
+    }
+
+    void DAGExecution::decide(Index i, const Task &ran) {
+      const std::size_t degree = plan_->successors(i).size();
+      for (std::size_t k = 0; k < degree; ++k) {
+        const Index e = plan_->edge_index(i, k);
+        const DAGEdge::Condition_t *condition = plan_->condition(e);
+        if (condition != nullptr) {
+          edge_status_[static_cast<std::size_t>(e)].store(
+            (*condition)(ran) ? DAGEdge::Status::traversed
+                              : DAGEdge::Status::non_traverable
+          );
+        }
+      }
+    }
+
+    DAGExecution::Status DAGExecution::shortcut(Index i) {
+      Status ret = Status::queued;
+
+      if (plan_->vertex(i)->task() == nullptr) {
+        ret = Status::succeeded;
+      } else if (
+        cache_ && !has_conditions(i) &&
+        cache_->contains(keys_[static_cast<std::size_t>(i)])
+      ) {
+        ret = Status::cached;
+      }
+
+      return ret;
+    }
+
+    DAGExecution::Status DAGExecution::dispatch(Index i) {
+      const Status ret = shortcut(i);
+
+      if (ret == Status::queued) {
+        release(i);
+      }
+
+      return ret;
+    }
+
+    std::unique_ptr<Task> DAGExecution::prepare(Index i) {
+      std::unique_ptr<Task> ret = plan_->vertex(i)->task()->clone();
+      std::shared_ptr<DAGExecution> self = shared_from_this();
+      // Only the task itself calls this, so the raw pointer is live.
+      const Task *ran = ret.get();
+      ret->set_dependency_callback([self, i, ran](bool status) {
+        if (status && self->costs_) {
+          self->costs_->record(*ran, ran->run_time());
+        }
+        if (status) {
+          self->decide(i, *ran);
+        }
+        self->finish(i, status ? Status::succeeded : Status::failed);
+      });
+      if (ret->fans_out()) {
+        ret->set_fan_out_callback(
+          [self, i](std::unique_ptr<Task> &&child, bool join) {
+            return self->expand(i, std::move(child), join);
+          }
+        );
+      }
+      ret->set_priority(rank(i));
+      status_[static_cast<std::size_t>(i)].store(Status::queued);
+
+      return ret;
+    }
+
+    void DAGExecution::release(Index i) {
+      if (!chain_next_.empty() &&
+          chain_next_[static_cast<std::size_t>(i)] != FrozenDAG::npos) {
+        release_chain(i);
+      } else {
+        scheduler_.queue_task(prepare(i));
+      }
+    }
+
+    void DAGExecution::release_chain(Index head) {
+      std::shared_ptr<DAGExecution> self = shared_from_this();
+      std::vector<Index> members;
+      for (Index i = head; i != FrozenDAG::npos;
+           i = chain_next_[static_cast<std::size_t>(i)]) {
+        // Claimed now, so that finish() leaves the member to this chain
+        // once its predecessor is done rather than releasing it again.
+        status_[static_cast<std::size_t>(i)].store(Status::queued);
+        members.push_back(i);
+      }
+
+      // One stage for the whole chain, so a worker takes it up once and
+      // pays its per stage overhead once.
+      std::vector<std::unique_ptr<TaskStage>> stages;
+      stages.push_back(std::make_unique<ChainStage>(
+        plan_->vertex(head)->label(),
+        [self, members]() {
+          bool ret = true;
+          for (std::size_t m = 0; ret && m < members.size(); ++m) {
+            const Index i = members[m];
+            // Only the head was checked for a shortcut when released.
+            const Status result =
+              (m == 0) ? Status::queued : self->shortcut(i);
+            if (result == Status::queued) {
+              std::unique_ptr<Task> task = self->prepare(i);
+              ret = task->iterate_stages([](TaskStage &stage) {
+                return stage.run();
+              });
+              // Finishes i, and skips the rest of the chain on failure.
+              task->complete(ret);
+            } else {
+              self->finish(i, result);
+            }
+          }
+          return ret;
+        }
+      ));
+
+      std::unique_ptr<Task> chain =
+        std::make_unique<Task>(stages, plan_->vertex(head)->label());
+      chain->set_dependency_callback([self, members](bool) {
+        // A chain that was stopped before its stage ran never ran any
+        // member. The first one fails, which skips the others.
+        for (Index i : members) {
+          if (self->status_[static_cast<std::size_t>(i)].load() ==
+              Status::queued) {
+            self->finish(i, Status::failed);
+            break;
+          }
+        }
+      });
+      chain->set_priority(rank(head));
+      scheduler_.queue_task(std::move(chain));
+    }
+
+    bool DAGExecution::expand(
+      Index parent, std::unique_ptr<Task> &&child, bool join
+    ) {
+      // Counted before it can finish, and while parent, or the child that
+      // emits it, still holds the run open.
+      expected_.fetch_add(1);
+      expanded_.fetch_add(1);
+      if (join) {
+        holds_[static_cast<std::size_t>(parent)].fetch_add(1);
+      }
+
+      std::shared_ptr<DAGExecution> self = shared_from_this();
+      child->set_dependency_callback([self, parent, join](bool status) {
+        self->finish_child(parent, join, status);
+      });
+      if (child->fans_out()) {
+        // Grandchildren belong to the same vertex.
+        child->set_fan_out_callback(
+          [self, parent](std::unique_ptr<Task> &&grandchild, bool joins) {
+            return self->expand(parent, std::move(grandchild), joins);
+          }
+        );
+      }
+      child->set_priority(rank(parent));
+      scheduler_.queue_task(std::move(child));
+
+      return true;
+    }
+
+    void DAGExecution::finish(Index i, Status result) {
+      Finished_t finished{{i, result}};
+      drain(finished, 0);
+    }
+
+    void DAGExecution::finish_child(Index parent, bool join, bool status) {
+      const std::size_t at = static_cast<std::size_t>(parent);
+      Finished_t finished;
+      if (!status) {
+        failed_.store(true);
+        if (join) {
+          child_failed_[at].store(true);
+        }
+      }
+      if (join && holds_[at].fetch_sub(1) == 1) {
+        release_successors(parent, finished);
+      }
+      drain(finished, 1);
+    }
+
+    void DAGExecution::release_successors(Index i, Finished_t &finished) {
+      const std::size_t at = static_cast<std::size_t>(i);
+      const Status result = status_[at].load();
+      const bool pruned = result == Status::pruned;
+      const bool succeeded = is_success(result) && !child_failed_[at].load();
+      // Only a Task that ran is recorded, and only once the children it
+      // waits on are done too.
+      if (succeeded && result == Status::succeeded && cache_ &&
+          plan_->vertex(i)->task() != nullptr) {
+        cache_->insert(keys_[at]);
+      }
+
+      const FrozenDAG::IndexRange successors = plan_->successors(i);
+      for (std::size_t k = 0; k < successors.size(); ++k) {
+        const Index s = successors[k];
+        const std::size_t next = static_cast<std::size_t>(s);
+        std::atomic<DAGEdge::Status> &edge =
+          edge_status_[static_cast<std::size_t>(plan_->edge_index(i, k))];
+        if (pruned) {
+          edge.store(DAGEdge::Status::non_traverable);
+        } else if (!succeeded) {
+          blocked_[next].store(true);
+        } else if (edge.load() != DAGEdge::Status::non_traverable) {
+          edge.store(DAGEdge::Status::traversed);
+          reached_[next].store(true);
+        }
+        if (remaining_[next].fetch_sub(1) == 1) {
+          // A vertex already queued belongs to a fused chain, which runs
+          // it next.
+          if (blocked_[next].load()) {
+            finished.emplace_back(s, Status::skipped);
+          } else if (!reached_[next].load()) {
+            // Pruned without being queued, and its successors with it.
+            finished.emplace_back(s, Status::pruned);
+          } else if (status_[next].load() != Status::queued) {
+            const Status next_result = dispatch(s);
+            if (next_result != Status::queued) {
+              finished.emplace_back(s, next_result);
+            }
+          }
+        }
+      }
+    }
+
+    void DAGExecution::drain(Finished_t &finished, std::size_t count) {
+      // Vertices that finish without going through the scheduler, since
+      // they are skipped, cached or have no task, are handled in this loop
+      // rather than by recursing, so a long chain of them cannot run out
+      // of stack.
+      while (!finished.empty()) {
+        const Index curr = finished.back().first;
+        const Status curr_result = finished.back().second;
+        finished.pop_back();
+        status_[static_cast<std::size_t>(curr)].store(curr_result);
+        if (curr_result == Status::failed) {
+          failed_.store(true);
+        }
+        ++count;
+
+        // Joined children still running release the successors instead,
+        // when the last of them finishes.
+        if (holds_[static_cast<std::size_t>(curr)].fetch_sub(1) == 1) {
+          release_successors(curr, finished);
+        }
+      }
+
+      if (finished_.fetch_add(count) + count == expected_.load()) {
+        std::lock_guard<std::mutex> lock(finished_lock_);
+        finished_cond_.notify_all();
+      }
+    }
+  } // namespace dag_scheduler
+} // namespace com
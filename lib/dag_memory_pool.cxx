@@ -0,0 +1,92 @@
+#include "dag_scheduler/dag_memory_pool.h"
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+
+namespace com {
+  namespace dag_scheduler {
+    DAGMemoryPool::DAGMemoryPool(std::size_t slab_size) :
+      slab_size_(round_up(slab_size)), stats_{0, 0, 0, 0} {}
+
+    DAGMemoryPool::~DAGMemoryPool() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      size_classes_.clear();
+      slabs_.clear();
+    }
+
+    void *DAGMemoryPool::allocate(std::size_t bytes) {
+      const std::size_t block_size = round_up(bytes);
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      void *ret = nullptr;
+      if (block_size > slab_size_ / 8) {
+        ret = ::operator new(block_size);
+      } else {
+        SizeClass &size_class = size_class_for(block_size);
+        if (size_class.free_list != nullptr) {
+          ret = size_class.free_list;
+          size_class.free_list = size_class.free_list->next;
+        } else {
+          if (size_class.cursor == size_class.end) {
+            slabs_.emplace_back(new char[slab_size_]);
+            size_class.cursor = slabs_.back().get();
+            size_class.end = size_class.cursor +
+                             (slab_size_ / block_size) * block_size;
+            ++stats_.slab_count;
+            stats_.bytes_reserved += slab_size_;
+          }
+          ret = size_class.cursor;
+          size_class.cursor += block_size;
+        }
+      }
+      ++stats_.blocks_in_use;
+      stats_.bytes_in_use += block_size;
+
+      return ret;
+    }
+
+    void DAGMemoryPool::deallocate(void *p, std::size_t bytes) {
+      if (p == nullptr) {
+        return;
+      }
+
+      const std::size_t block_size = round_up(bytes);
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      if (block_size > slab_size_ / 8) {
+        ::operator delete(p);
+      } else {
+        SizeClass &size_class = size_class_for(block_size);
+        FreeBlock *block = static_cast<FreeBlock *>(p);
+        block->next = size_class.free_list;
+        size_class.free_list = block;
+      }
+      assert(stats_.blocks_in_use > 0 && "Freeing more than allocated.");
+      --stats_.blocks_in_use;
+      stats_.bytes_in_use -= block_size;
+    }
+
+    DAGMemoryPool::Stats DAGMemoryPool::stats() const {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return stats_;
+    }
+
+    std::size_t DAGMemoryPool::round_up(std::size_t bytes) {
+      const std::size_t align = alignof(std::max_align_t);
+      bytes = (bytes < sizeof(FreeBlock)) ? sizeof(FreeBlock) : bytes;
+      return ((bytes + align - 1) / align) * align;
+    }
+
+    DAGMemoryPool::SizeClass &
+    DAGMemoryPool::size_class_for(std::size_t block_size) {
+      for (SizeClass &size_class : size_classes_) {
+        if (size_class.block_size == block_size) {
+          return size_class;
+        }
+      }
+      size_classes_.push_back({block_size, nullptr, nullptr, nullptr});
+      return size_classes_.back();
+    }
+  } // namespace dag_scheduler
+} // namespace com
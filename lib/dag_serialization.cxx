@@ -15,6 +15,7 @@
 #include <iterator>
 #include <memory>
 #include <stdexcept>
+#include <vector>
 
 namespace com {
   namespace dag_scheduler {
@@ -26,6 +27,7 @@ namespace com {
       "Configuration";
     const std::string YAMLDagDeserializer::INITIAL_INPUTS_KEY =
       "InitialInputs";
+    const std::string YAMLDagDeserializer::COST_KEY = "Cost";
 
     const std::string YAMLDagDeserializer::TITLE_KEY = "Title";
     const std::string YAMLDagDeserializer::NAME_KEY = "Name";
@@ -82,6 +84,7 @@ namespace com {
       if (ret.empty()) {
         ret = std::string("      Task:\n") +
               std::string("        Name: <optional string>\n") +
+              std::string("        Cost: <optional seconds>\n") +
               std::string("        InitialInputs: <optional YAML>\n") +
               std::string("          <valid YAML>\n") +
               std::string("        Configuration: <optional YAML>\n") +
@@ -94,6 +97,7 @@ namespace com {
       } else {
         ret = std::string("      Task:\n") +
               std::string("        Name: <optional string>\n") +
+              std::string("        Cost: <optional seconds>\n") +
               std::string("        InitialInputs: <optional YAML>\n") +
               std::string("          <valid YAML>\n") +
               std::string("        Configuration: <optional YAML>\n") +
@@ -295,6 +299,8 @@ namespace com {
           LOG_TAG, "Going to process vertices", vertices_node, "..."
         );
         if (vertices_node.size() >= 0) {
+          std::vector<DAGVertex> dag_vertices;
+          dag_vertices.reserve(vertices.size());
           for (const YAML::Node &vertex_node : vertices) {
             Logging::info(LOG_TAG, "Processing", vertex_node, "...");
             std::string name;
@@ -313,9 +319,9 @@ namespace com {
                 vertex_node
               );
             }
-            DAGVertex next_vertex(name, std::move(task), std::move(uuid));
-            dag->add_vertex(std::move(next_vertex));
+            dag_vertices.emplace_back(name, std::move(task), std::move(uuid));
           }
+          dag->bulk_load(std::move(dag_vertices), {});
         } else {
           Logging::warn(
             LOG_TAG, "Empty verticies node specified to", typeid(*this).name()
@@ -401,6 +407,15 @@ namespace com {
           stages, task_name, json_config, json_initial_inputs
         );
       }
+
+      if (task_node[COST_KEY]) {
+        const double cost = task_node[COST_KEY].as<double>();
+        if (cost < 0.0) {
+          auto error = std::string("\"Cost\" must not be negative.");
+          throw_wrong_type(UpTo::TASK, error);
+        }
+        task->set_cost_estimate(cost);
+      }
     }
 
     void YAMLDagDeserializer::throw_wrong_type(
@@ -637,6 +652,7 @@ namespace com {
             std::unique_ptr<TaskStage> next_stage =
               dynamically_load_stage(shared_library, symbol_name, stage_name);
             if (next_stage) {
+              next_stage->set_origin(library_name + ":" + symbol_name);
               Logging::info(LOG_TAG, "next_stage: ", (*next_stage));
             } else {
               std::stringstream error_builder;
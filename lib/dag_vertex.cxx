@@ -1,10 +1,14 @@
 #include "dag_scheduler/dag_vertex.h"
 
+#include "dag_scheduler/content_hash.h"
 #include "dag_scheduler/dag_edge.h"
 
 #include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <new>
+#include <unordered_set>
+#include <utility>
 
 namespace com {
   namespace dag_scheduler {
@@ -36,17 +40,20 @@ namespace com {
       const std::string &label, std::unique_ptr<Task> &&task
     ) :
       current_status_(Status::INITIALIZED), label_(label),
-      incomming_edge_count_(0), task_(std::move(task)) {}
+      incomming_edge_count_(0),
+      task_(std::make_shared<std::unique_ptr<Task>>(std::move(task))) {}
 
     DAGVertex::DAGVertex(
       const std::string &label, std::unique_ptr<Task> &&task, UUID &&uuid
     ) :
       uuid_(std::move(uuid)), current_status_(Status::INITIALIZED),
-      label_(label), incomming_edge_count_(0), task_(std::move(task)) {}
+      label_(label), incomming_edge_count_(0),
+      task_(std::make_shared<std::unique_ptr<Task>>(std::move(task))) {}
 
     DAGVertex::~DAGVertex() {
       current_status_ = Status::INVALID;
       label_.clear();
+      detach_from_predecessors();
       clear_edges();
       incomming_edge_count_.store(0);
     }
@@ -55,7 +62,9 @@ namespace com {
       uuid_ = std::move(other.uuid_);
       label_ = std::move(other.label_);
       current_status_ = other.current_status_;
+      pool_ = std::move(other.pool_);
       edges_ = std::move(other.edges_);
+      adopt_links_of(other);
       incomming_edge_count_ = other.incomming_edge_count_.load();
       task_ = std::move(other.task_);
 
@@ -68,9 +77,15 @@ namespace com {
       uuid_ = std::move(rhs.uuid_);
       label_ = std::move(rhs.label_);
       current_status_ = rhs.current_status_;
+      detach_from_predecessors();
+      // The edges being dropped may still belong to pool_, so it is only
+      // replaced once they are gone.
       edges_ = std::move(rhs.edges_);
+      pool_ = std::move(rhs.pool_);
+      adopt_links_of(rhs);
       incomming_edge_count_ = rhs.incomming_edge_count_.load();
       task_ = std::move(rhs.task_);
+      structure_changed();
 
       rhs.label_.clear();
       rhs.current_status_ = Status::INVALID;
@@ -84,8 +99,9 @@ namespace com {
     bool DAGVertex::connect(std::shared_ptr<DAGVertex> other) {
       bool ret = false;
 
-      if (!contains_connection_to(*other)) {
-        std::unique_ptr<DAGEdge> e(new DAGEdge);
+      if (!has_successor(other.get())) {
+        Edge_t e = make_edge(DAGEdge());
+        e->source_ = this;
         e->connect_to(other);
         edges_.push_back(std::move(e));
         ret = true;
@@ -97,16 +113,7 @@ namespace com {
     }
 
     bool DAGVertex::contains_connection_to(const DAGVertex &other) {
-      bool ret = false;
-
-      for (const auto &ptrref : edges_) {
-        if (ptrref->is_a_connection_to(other)) {
-          ret = true;
-          break;
-        }
-      }
-
-      return ret;
+      return has_successor(&other);
     }
 
     std::vector<std::shared_ptr<DAGVertex>> DAGVertex::restablish_connections(
@@ -120,7 +127,8 @@ namespace com {
         std::shared_ptr<DAGVertex> other =
           std::make_shared<DAGVertex>(vertex.clone());
         DAGEdge edge = *(const_cast<DAGEdge *>(&connection.edge()));
-        std::unique_ptr<DAGEdge> tmp_edge(new DAGEdge(edge.clone()));
+        Edge_t tmp_edge = make_edge(edge.clone());
+        tmp_edge->source_ = this;
         tmp_edge->connect_to(other);
         // We need to preserve the shared_ptr so the edge's weak_ptr does not
         // expire.
@@ -140,7 +148,7 @@ namespace com {
 
       std::for_each(
         edges_.begin(), edges_.end(),
-        [&](const std::unique_ptr<DAGEdge> &e) { cb(*e); }
+        [&](const Edge_t &e) { cb(*e); }
       );
     }
 
@@ -149,7 +157,7 @@ namespace com {
       std::vector<DAGVertex_connection> ret;
       ret.reserve(edges_.size());
 
-      for (std::unique_ptr<DAGEdge> &e : edges_) {
+      for (Edge_t &e : edges_) {
         DAGEdge e_clone = e->clone();
         DAGVertex v_clone = e->get_connection().lock()->clone();
         ret.push_back(DAGVertex_connection(e_clone, v_clone));
@@ -199,7 +207,75 @@ namespace com {
 
     const std::string &DAGVertex::label() const { return label_; }
 
-    std::unique_ptr<Task> &DAGVertex::get_task() { return task_; }
+    std::unique_ptr<Task> &DAGVertex::get_task() {
+      // The reference handed out can be used to change the Task.
+      structure_changed();
+      if (!task_) {
+        task_ = std::make_shared<std::unique_ptr<Task>>();
+      } else if (task_.use_count() > 1) {
+        // Another copy still reads the shared Task, so this one gets its
+        // own before it can be changed.
+        std::unique_ptr<Task> own = (*task_) ? (*task_)->clone() : nullptr;
+        task_ = std::make_shared<std::unique_ptr<Task>>(std::move(own));
+      }
+
+      return *task_;
+    }
+
+    const Task *DAGVertex::task() const {
+      return task_ ? task_->get() : nullptr;
+    }
+
+    std::uint64_t DAGVertex::structural_hash() const {
+      if (!structural_hash_valid_) {
+        // A post order walk of the stale vertices below this, without
+        // recursion so a long chain cannot run out of stack. A vertex is
+        // only expanded once, which also ends the walk on a cycle made
+        // behind the DAG's back.
+        std::vector<std::pair<const DAGVertex *, bool>> stack;
+        std::unordered_set<const DAGVertex *> expanded;
+        stack.emplace_back(this, false);
+        while (!stack.empty()) {
+          const DAGVertex *v = stack.back().first;
+          if (v->structural_hash_valid_) {
+            stack.pop_back();
+          } else if (!stack.back().second) {
+            stack.back().second = true;
+            if (expanded.insert(v).second) {
+              for (const DAGVertex *next : v->successors_) {
+                if (!next->structural_hash_valid_) {
+                  stack.emplace_back(next, false);
+                }
+              }
+            }
+          } else {
+            stack.pop_back();
+            std::vector<std::uint64_t> successor_hashes;
+            successor_hashes.reserve(v->successors_.size());
+            for (const DAGVertex *next : v->successors_) {
+              successor_hashes.push_back(next->structural_hash_);
+            }
+            std::sort(successor_hashes.begin(), successor_hashes.end());
+
+            ContentHash hash;
+            hash.add(v->label_);
+            const Task *t = v->task();
+            hash.add(static_cast<std::uint64_t>(t != nullptr));
+            if (t != nullptr) {
+              hash.add(t->content_hash());
+            }
+            hash.add(static_cast<std::uint64_t>(successor_hashes.size()));
+            for (std::uint64_t h : successor_hashes) {
+              hash.add(h);
+            }
+            v->structural_hash_ = hash.value();
+            v->structural_hash_valid_ = true;
+          }
+        }
+      }
+
+      return structural_hash_;
+    }
 
     bool DAGVertex::has_incomming_edges() const {
       return (incomming_edge_count_ > 0);
@@ -209,12 +285,170 @@ namespace com {
       return incomming_edge_count_;
     }
 
+    const std::vector<DAGVertex *> &DAGVertex::successors() const {
+      return successors_;
+    }
+
+    const std::vector<DAGVertex *> &DAGVertex::predecessors() const {
+      return predecessors_;
+    }
+
     void DAGVertex::add_incomming_edge() { ++incomming_edge_count_; }
 
     void DAGVertex::sub_incomming_edge() { --incomming_edge_count_; }
 
     void DAGVertex::clear_edges() { edges_.clear(); }
 
+    void DAGVertex::clear_incomming_edges() {
+      // Dropping an edge unlinks it from predecessors_, so walk a copy.
+      const std::vector<DAGVertex *> preds = predecessors_;
+      for (DAGVertex *p : preds) {
+        std::vector<Edge_t> &edges = p->edges_;
+        auto keep = edges.begin();
+        for (auto it = edges.begin(); it != edges.end(); ++it) {
+          if ((*it)->target_ == this) {
+            (*it)->connect_to(nullptr);
+          } else {
+            std::swap(*keep, *it);
+            ++keep;
+          }
+        }
+        edges.erase(keep, edges.end());
+      }
+      assert(predecessors_.empty() && "Predecessor still points at this.");
+    }
+
+    DAGVertex::Edge_t DAGVertex::make_edge(DAGEdge &&e) {
+      Edge_t ret;
+
+      if (pool_) {
+        void *block = pool_->allocate(sizeof(DAGEdge));
+        ret = Edge_t(new (block) DAGEdge(std::move(e)), {pool_.get()});
+      } else {
+        ret = Edge_t(new DAGEdge(std::move(e)));
+      }
+
+      return ret;
+    }
+
+    void DAGVertex::detach_from_predecessors() {
+      // The edges stay with their owners, as they always have, but they no
+      // longer name (this) as a raw target.
+      for (DAGVertex *p : predecessors_) {
+        p->remove_all_successor(this);
+        for (Edge_t &e : p->edges_) {
+          if (e->target_ == this) {
+            e->target_ = nullptr;
+          }
+        }
+      }
+      predecessors_.clear();
+    }
+
+    void DAGVertex::adopt_links_of(DAGVertex &other) {
+      successors_ = std::move(other.successors_);
+      successor_set_ = std::move(other.successor_set_);
+      predecessors_ = std::move(other.predecessors_);
+      other.successors_.clear();
+      other.predecessors_.clear();
+
+      for (Edge_t &e : edges_) {
+        e->source_ = this;
+      }
+      for (DAGVertex *s : successors_) {
+        std::replace(
+          s->predecessors_.begin(), s->predecessors_.end(), &other, this
+        );
+      }
+      for (DAGVertex *p : predecessors_) {
+        p->replace_successor(&other, this);
+        for (Edge_t &e : p->edges_) {
+          if (e->target_ == &other) {
+            e->target_ = this;
+          }
+        }
+      }
+    }
+
+    bool DAGVertex::has_successor(const DAGVertex *s) const {
+      bool ret = false;
+
+      if (successor_set_) {
+        ret = (successor_set_->count(s) != 0);
+      } else {
+        ret = (std::find(successors_.begin(), successors_.end(), s) !=
+               successors_.end());
+      }
+
+      return ret;
+    }
+
+    void DAGVertex::add_successor(DAGVertex *s) {
+      structure_changed();
+      successors_.push_back(s);
+      if (successor_set_) {
+        successor_set_->insert(s);
+      } else if (successors_.size() > successor_scan_limit) {
+        successor_set_ =
+          std::make_unique<std::unordered_multiset<const DAGVertex *>>(
+            successors_.begin(), successors_.end()
+          );
+      }
+    }
+
+    void DAGVertex::remove_successor(const DAGVertex *s) {
+      auto it = std::find(successors_.begin(), successors_.end(), s);
+      if (it != successors_.end()) {
+        structure_changed();
+        successors_.erase(it);
+        if (successor_set_) {
+          successor_set_->erase(successor_set_->find(s));
+        }
+      }
+    }
+
+    void DAGVertex::remove_all_successor(const DAGVertex *s) {
+      structure_changed();
+      successors_.erase(
+        std::remove(successors_.begin(), successors_.end(), s),
+        successors_.end()
+      );
+      if (successor_set_) {
+        successor_set_->erase(s);
+      }
+    }
+
+    void DAGVertex::replace_successor(DAGVertex *from, DAGVertex *to) {
+      structure_changed();
+      std::replace(successors_.begin(), successors_.end(), from, to);
+      if (successor_set_) {
+        for (std::size_t n = successor_set_->erase(from); n > 0; --n) {
+          successor_set_->insert(to);
+        }
+      }
+    }
+
+    void DAGVertex::structure_changed() {
+      // Once a stale vertex is reached everything upstream of it is
+      // already stale.
+      std::vector<DAGVertex *> stack;
+      if (structural_hash_valid_) {
+        stack.push_back(this);
+      }
+      while (!stack.empty()) {
+        DAGVertex *v = stack.back();
+        stack.pop_back();
+        if (v->structural_hash_valid_) {
+          v->structural_hash_valid_ = false;
+          for (DAGVertex *p : v->predecessors_) {
+            if (p->structural_hash_valid_) {
+              stack.push_back(p);
+            }
+          }
+        }
+      }
+    }
+
     void DAGVertex::reset_incomming_edge_count() {
       incomming_edge_count_.store(0);
     }
@@ -226,10 +460,8 @@ namespace com {
 
     DAGVertex::DAGVertex(const DAGVertex &other) :
       uuid_(const_cast<DAGVertex *>(&other)->uuid_.clone()),
-      current_status_(other.current_status_), label_(other.label()) {
-      if (other.task_) {
-        task_ = other.task_->clone();
-      }
+      current_status_(other.current_status_), label_(other.label()),
+      task_(other.task_) {
       reset_incomming_edge_count();
       // We cannot add back the connections since the edge adds a weak_ptr
       // to a DAGVertex we no longer can duplicate. This has to be done
@@ -242,9 +474,10 @@ namespace com {
       uuid_ = t.uuid_.clone();
       current_status_ = t.current_status_;
       label_ = rhs.label();
-      if (rhs.task_) {
-        task_ = rhs.task_->clone();
+      if (rhs.task() != nullptr) {
+        task_ = rhs.task_;
       }
+      structure_changed();
       reset_incomming_edge_count();
       // We cannot add back the connections since the edge adds a weak_ptr
       // to a DAGVertex we no longer can duplicate. This has to be done
@@ -265,8 +498,7 @@ namespace com {
         out << "\t" << e << std::endl;
       });
 
-      const std::unique_ptr<Task> &task_ptr =
-        const_cast<DAGVertex &>(v).get_task();
+      const Task *task_ptr = v.task();
       out << "task_ = ";
       if (task_ptr) {
         out << (*task_ptr);
@@ -281,10 +513,7 @@ namespace com {
       bool ret = true;
 
       if (lhs.current_status_ == rhs.current_status_) {
-        auto lhs_str = lhs.uuid_.as_string();
-        auto rhs_str = rhs.uuid_.as_string();
-
-        ret &= (lhs_str == rhs_str);
+        ret &= (lhs.uuid_ == rhs.uuid_);
         ret &= (lhs.label() == rhs.label());
 
         std::size_t lhs_edge_count = lhs.edge_count();
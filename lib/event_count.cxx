@@ -0,0 +1,128 @@
+#include "dag_scheduler/event_count.h"
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#endif
+
+namespace com {
+  namespace dag_scheduler {
+#if defined(__linux__)
+    namespace detail {
+      long futex(
+        std::atomic<EventCount::Key_t> &word, int op, int value,
+        const struct timespec *timeout
+      ) {
+        static_assert(
+          sizeof(std::atomic<EventCount::Key_t>) == sizeof(int),
+          "A futex word is an int"
+        );
+        return syscall(
+          SYS_futex, reinterpret_cast<int *>(&word), op, value, timeout,
+          nullptr, 0
+        );
+      }
+    } // namespace detail
+#endif
+
+    EventCount::EventCount() : epoch_(0), waiters_(0) {}
+
+    EventCount::Key_t EventCount::prepare_wait() {
+      // Counted before the epoch is read, so a notify that changed the
+      // condition after this either sees the waiter or bumped the epoch
+      // already.
+      waiters_.fetch_add(1, std::memory_order_seq_cst);
+      return epoch_.load(std::memory_order_seq_cst);
+    }
+
+    void EventCount::cancel_wait() { finish_wait(); }
+
+    void EventCount::wait(Key_t key) {
+#if defined(__linux__)
+      while (epoch_.load(std::memory_order_acquire) == key) {
+        detail::futex(
+          epoch_, FUTEX_WAIT_PRIVATE, static_cast<int>(key), nullptr
+        );
+      }
+#else
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [&]() {
+          return epoch_.load(std::memory_order_acquire) != key;
+        });
+      }
+#endif
+      finish_wait();
+    }
+
+    bool EventCount::wait_until(
+      Key_t key, const std::chrono::steady_clock::time_point &deadline
+    ) {
+      bool ret = true;
+
+#if defined(__linux__)
+      while (ret && epoch_.load(std::memory_order_acquire) == key) {
+        const auto left = deadline - std::chrono::steady_clock::now();
+        if (left <= std::chrono::steady_clock::duration::zero()) {
+          ret = false;
+        } else {
+          const auto ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(left);
+          struct timespec timeout;
+          timeout.tv_sec = static_cast<time_t>(ns.count() / 1000000000);
+          timeout.tv_nsec = static_cast<long>(ns.count() % 1000000000);
+          detail::futex(
+            epoch_, FUTEX_WAIT_PRIVATE, static_cast<int>(key), &timeout
+          );
+        }
+      }
+#else
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ret = cond_.wait_until(lock, deadline, [&]() {
+          return epoch_.load(std::memory_order_acquire) != key;
+        });
+      }
+#endif
+      finish_wait();
+
+      return ret;
+    }
+
+    void EventCount::notify_one() { notify(false); }
+
+    void EventCount::notify_all() { notify(true); }
+
+    void EventCount::notify(bool all) {
+      // A read-modify-write, rather than a load, so it is ordered after
+      // the change to the condition without a fence.
+      if (waiters_.fetch_add(0, std::memory_order_seq_cst) > 0) {
+#if defined(__linux__)
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        detail::futex(
+          epoch_, FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, nullptr
+        );
+#else
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          epoch_.fetch_add(1, std::memory_order_seq_cst);
+        }
+        if (all) {
+          cond_.notify_all();
+        } else {
+          cond_.notify_one();
+        }
+#endif
+      }
+    }
+
+    void EventCount::finish_wait() {
+      waiters_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -0,0 +1,38 @@
+#include "dag_scheduler/fan_out_task_stage.h"
+
+#include "dag_scheduler/logging.h"
+#include "dag_scheduler/task.h"
+
+#include <utility>
+
+namespace com {
+  namespace dag_scheduler {
+    FanOutTaskStage::FanOutTaskStage() : TaskStage() {}
+
+    FanOutTaskStage::FanOutTaskStage(const std::string &label) :
+      TaskStage(label) {}
+
+    FanOutTaskStage::~FanOutTaskStage() {}
+
+    void FanOutTaskStage::set_emit(Emit_t emit) { emit_ = std::move(emit); }
+
+    bool FanOutTaskStage::can_emit() const { return bool(emit_); }
+
+    bool FanOutTaskStage::emit(std::unique_ptr<Task> &&child, bool join) {
+      bool ret = false;
+
+      if (emit_) {
+        ret = emit_(std::move(child), join);
+      } else {
+        LogTag LOG_TAG(__FUNCTION__);
+        Logging::add_std_cout_logger(LOG_TAG);
+        Logging::warn(
+          LOG_TAG, "Stage", label_, "is not run as part of a DAG, so",
+          child->label(), "is dropped."
+        );
+      }
+
+      return ret;
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -0,0 +1,150 @@
+#include "dag_scheduler/frozen_dag.h"
+
+#include "dag_scheduler/dag_edge.h"
+
+#include <cassert>
+#include <limits>
+
+namespace com {
+  namespace dag_scheduler {
+    FrozenDAG::IndexRange::IndexRange(const Index *begin, const Index *end) :
+      begin_(begin), end_(end) {}
+
+    const FrozenDAG::Index *FrozenDAG::IndexRange::begin() const {
+      return begin_;
+    }
+
+    const FrozenDAG::Index *FrozenDAG::IndexRange::end() const {
+      return end_;
+    }
+
+    std::size_t FrozenDAG::IndexRange::size() const {
+      return static_cast<std::size_t>(end_ - begin_);
+    }
+
+    bool FrozenDAG::IndexRange::empty() const { return begin_ == end_; }
+
+    FrozenDAG::Index FrozenDAG::IndexRange::operator[](std::size_t i) const {
+      assert(i < size() && "Index out of bounds.");
+      return begin_[i];
+    }
+
+    constexpr FrozenDAG::Index FrozenDAG::npos;
+
+    FrozenDAG::FrozenDAG(DAG &g) {
+      assert(
+        g.vertex_count() <
+          static_cast<std::size_t>(std::numeric_limits<Index>::max()) &&
+        "Too many vertices to index with Index."
+      );
+
+      vertices_.reserve(g.vertex_count());
+      uuid_index_.reserve(g.vertex_count());
+      std::unordered_map<const DAGVertex *, Index> ids;
+      ids.reserve(g.vertex_count());
+      g.linear_traversal([&](std::shared_ptr<DAGVertex> v) {
+        const Index id = static_cast<Index>(vertices_.size());
+        ids.emplace(v.get(), id);
+        uuid_index_.emplace(v->get_uuid().clone(), id);
+        vertices_.push_back(std::move(v));
+      });
+
+      const std::size_t n = vertices_.size();
+      successor_offsets_.assign(n + 1, 0);
+      in_degree_.assign(n, 0);
+      for (std::size_t i = 0; i < n; ++i) {
+        for (const DAGVertex::Edge_t &e : vertices_[i]->edges_) {
+          auto it = ids.find(e->connection_.lock().get());
+          if (it != ids.end()) {
+            if (e->condition_) {
+              conditions_.emplace(
+                static_cast<Index>(successor_targets_.size()), e->condition_
+              );
+            }
+            successor_targets_.push_back(it->second);
+            ++in_degree_[static_cast<std::size_t>(it->second)];
+          }
+        }
+        successor_offsets_[i + 1] =
+          static_cast<Index>(successor_targets_.size());
+      }
+
+      // Predecessors are a counting sort of the successor lists by target,
+      // which leaves every predecessor list in ascending index order.
+      predecessor_offsets_.assign(n + 1, 0);
+      for (std::size_t i = 0; i < n; ++i) {
+        predecessor_offsets_[i + 1] = predecessor_offsets_[i] + in_degree_[i];
+      }
+      predecessor_targets_.resize(successor_targets_.size());
+      std::vector<Index> fill(
+        predecessor_offsets_.begin(), predecessor_offsets_.end() - 1
+      );
+      for (std::size_t i = 0; i < n; ++i) {
+        for (Index s : successors(static_cast<Index>(i))) {
+          const std::size_t slot =
+            static_cast<std::size_t>(fill[static_cast<std::size_t>(s)]++);
+          predecessor_targets_[slot] = static_cast<Index>(i);
+        }
+      }
+    }
+
+    std::size_t FrozenDAG::vertex_count() const { return vertices_.size(); }
+
+    std::size_t FrozenDAG::edge_count() const {
+      return successor_targets_.size();
+    }
+
+    const std::shared_ptr<DAGVertex> &FrozenDAG::vertex(Index i) const {
+      return vertices_[static_cast<std::size_t>(i)];
+    }
+
+    FrozenDAG::IndexRange FrozenDAG::successors(Index i) const {
+      const std::size_t at = static_cast<std::size_t>(i);
+      const Index *data = successor_targets_.data();
+      return IndexRange(
+        data + successor_offsets_[at], data + successor_offsets_[at + 1]
+      );
+    }
+
+    FrozenDAG::IndexRange FrozenDAG::predecessors(Index i) const {
+      const std::size_t at = static_cast<std::size_t>(i);
+      const Index *data = predecessor_targets_.data();
+      return IndexRange(
+        data + predecessor_offsets_[at], data + predecessor_offsets_[at + 1]
+      );
+    }
+
+    FrozenDAG::Index FrozenDAG::edge_index(Index i, std::size_t k) const {
+      return successor_offsets_[static_cast<std::size_t>(i)] +
+             static_cast<Index>(k);
+    }
+
+    const DAGEdge::Condition_t *FrozenDAG::condition(Index e) const {
+      const DAGEdge::Condition_t *ret = nullptr;
+
+      auto found = conditions_.find(e);
+      if (found != conditions_.end()) {
+        ret = found->second.get();
+      }
+
+      return ret;
+    }
+
+    std::size_t FrozenDAG::condition_count() const {
+      return conditions_.size();
+    }
+
+    FrozenDAG::Index FrozenDAG::in_degree(Index i) const {
+      return in_degree_[static_cast<std::size_t>(i)];
+    }
+
+    const std::vector<FrozenDAG::Index> &FrozenDAG::in_degrees() const {
+      return in_degree_;
+    }
+
+    FrozenDAG::Index FrozenDAG::index_of(const UUID &u) const {
+      auto it = uuid_index_.find(u);
+      return (it != uuid_index_.end()) ? it->second : npos;
+    }
+  } // namespace dag_scheduler
+} // namespace com
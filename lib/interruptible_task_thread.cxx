@@ -3,9 +3,8 @@
 #include "dag_scheduler/logging.h"
 #include "dag_scheduler/task.h"
 
-#include <condition_variable>
 #include <functional>
-#include <vector>
+#include <utility>
 
 /* ✓ */
 namespace com {
@@ -14,7 +13,7 @@ namespace com {
       InterruptibleTaskThread(LogTag(__FUNCTION__)) {}
 
     InterruptibleTaskThread::InterruptibleTaskThread(const LogTag &tag) :
-      LOG_TAG(tag), interrupt_(false), running_(false) {
+      LOG_TAG(tag), interrupt_(false), running_(false), stop_(false) {
       Logging::add_std_cout_logger(tag);
       Logging::add_std_cerr_logger(tag);
     }
@@ -24,10 +23,14 @@ namespace com {
     InterruptibleTaskThread::InterruptibleTaskThread(
       InterruptibleTaskThread &&other
     ) :
-      LOG_TAG(std::move(other.LOG_TAG)), interrupt_(false), running_(false) {
+      LOG_TAG(std::move(other.LOG_TAG)), interrupt_(false), running_(false),
+      stop_(false) {
       assert(not other.is_running() && "Cannot move a running task.");
 
+      // other keeps its worker, if it has one, until it is destroyed.
+      std::lock_guard<std::mutex> lock(other.task_lock_);
       task_ = std::move(other.task_);
+      idle_callback_ = std::move(other.idle_callback_);
     }
 
     InterruptibleTaskThread &
@@ -37,65 +40,93 @@ namespace com {
       LOG_TAG = std::move(rhs.LOG_TAG);
       interrupt_.store(false);
       running_.store(false);
-      task_ = std::move(rhs.task_);
+      std::unique_ptr<Task> task;
+      std::function<void()> idle_callback;
+      {
+        std::lock_guard<std::mutex> lock(rhs.task_lock_);
+        task = std::move(rhs.task_);
+        idle_callback = std::move(rhs.idle_callback_);
+      }
+      {
+        std::lock_guard<std::mutex> lock(task_lock_);
+        task_ = std::move(task);
+        idle_callback_ = std::move(idle_callback);
+      }
 
       return (*this);
     }
 
     bool
     InterruptibleTaskThread::set_task_and_run(std::unique_ptr<Task> &&task) {
-      bool thread_started = false;
-      std::mutex return_mutex;
-      std::unique_lock<std::mutex> return_lock(return_mutex);
-      std::condition_variable return_cond;
+      bool ret = false;
 
       {
         std::lock_guard<std::mutex> lock(task_lock_);
-        task_ = std::move(task);
+        if (task_ == nullptr) {
+          task_ = std::move(task);
+          // Set before the worker wakes so a scheduler looking for an idle
+          // thread cannot pick this one again in between.
+          running_.store(task_ != nullptr);
+          if (!thread_.joinable()) {
+            stop_ = false;
+            thread_ = std::thread(&InterruptibleTaskThread::work, this);
+          }
+          ret = true;
+        }
       }
+      task_cond_.notify_one();
 
-      std::function<bool(InterruptibleTaskThread *)> threaded_func =
-        [&](InterruptibleTaskThread *self) {
-          thread_started = true;
-          return_cond.notify_one();
-          bool all_ran = false;
-          if (self->task_ != nullptr) {
-            self->running_.store(true);
-            all_ran = self->task_->iterate_stages([&](TaskStage &next) {
-              bool stage_status = false;
-              {
-                std::lock_guard<std::mutex> lock(task_lock_);
-                Logging::info(LOG_TAG, "Going to run stage", next);
-                stage_status = next.run();
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
-              }
-
-              const bool this_was_interrupted = self->was_interrupted();
-              const bool cont = stage_status && (not this_was_interrupted);
-
-              if (cont) {
-                Logging::info(LOG_TAG, "Ran stage", next);
-              } else {
-                Logging::error(LOG_TAG, "Failed to execute", next);
-                all_ran = false;
-              }
-
-              return cont;
-            });
-            std::unique_ptr<com::dag_scheduler::Task> tmp =
-              std::move(self->task_);
-            self->task_.reset();
-            self->running_.store(false);
-            tmp->complete(all_ran);
-          }
-          return all_ran;
-        };
+      return ret;
+    }
+
+    void InterruptibleTaskThread::set_idle_callback(
+      std::function<void()> idle_callback
+    ) {
+      std::lock_guard<std::mutex> lock(task_lock_);
+      idle_callback_ = std::move(idle_callback);
+    }
 
-      InterruptibleTaskThread *threaded_ptr = this;
-      thread_ = std::thread(threaded_func, threaded_ptr);
+    void InterruptibleTaskThread::work() {
+      std::unique_lock<std::mutex> lock(task_lock_);
+      while (true) {
+        task_cond_.wait(lock, [this]() { return stop_ || task_ != nullptr; });
+        if (task_ == nullptr) {
+          // Only stop on an empty slot: a Task handed over before shutdown
+          // still runs, killed, so that it completes.
+          break;
+        }
+
+        // The slot stays filled while the Task runs, so set_interrupt can
+        // reach it; only this thread empties it.
+        Task *task = task_.get();
+        lock.unlock();
+        bool all_ran = task->iterate_stages([&](TaskStage &next) {
+          Logging::info(LOG_TAG, "Going to run stage", next);
+          const bool stage_status = next.run();
+
+          const bool this_was_interrupted = was_interrupted();
+          const bool cont = stage_status && (not this_was_interrupted);
+
+          if (cont) {
+            Logging::info(LOG_TAG, "Ran stage", next);
+          } else {
+            Logging::error(LOG_TAG, "Failed to execute", next);
+          }
 
-      return_cond.wait(return_lock);
-      return thread_started;
+          return cont;
+        });
+        lock.lock();
+        std::unique_ptr<Task> done = std::move(task_);
+        running_.store(false);
+        lock.unlock();
+
+        done->complete(all_ran);
+        done.reset();
+        if (idle_callback_) {
+          idle_callback_();
+        }
+        lock.lock();
+      }
     }
 
     void InterruptibleTaskThread::set_interrupt(bool should_interrupt) {
@@ -125,6 +156,11 @@ namespace com {
       if (running_.load()) {
         set_interrupt();
       }
+      {
+        std::lock_guard<std::mutex> lock(task_lock_);
+        stop_ = true;
+      }
+      task_cond_.notify_all();
       if (thread_.joinable()) {
         thread_.join();
       }
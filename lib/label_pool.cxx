@@ -0,0 +1,42 @@
+#include "dag_scheduler/label_pool.h"
+
+#include <cassert>
+
+namespace com {
+  namespace dag_scheduler {
+    LabelPool::Id LabelPool::intern(const std::string &label) {
+      Id ret = find(label);
+
+      if (ret == npos) {
+        ret = labels_.size();
+        labels_.push_back(label);
+        ids_.emplace(std::string_view(labels_.back()), ret);
+      }
+
+      return ret;
+    }
+
+    LabelPool::Id LabelPool::find(const std::string &label) const {
+      Id ret = npos;
+
+      auto it = ids_.find(std::string_view(label));
+      if (it != ids_.end()) {
+        ret = it->second;
+      }
+
+      return ret;
+    }
+
+    const std::string &LabelPool::label(Id id) const {
+      assert(id < labels_.size() && "Label id out of bounds.");
+      return labels_[id];
+    }
+
+    std::size_t LabelPool::size() const { return labels_.size(); }
+
+    void LabelPool::clear() {
+      ids_.clear();
+      labels_.clear();
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -195,6 +195,20 @@ namespace com {
       return ret;
     }
 
+    bool Logging::remove_logger(const LogTag &tag) {
+      bool ret = false;
+
+      std::lock_guard<std::mutex> lock(Logging::loggers_mutex_);
+      auto tag_it = detail::find_sink(tag, Logging::loggers_);
+      if (tag_it != Logging::loggers_.end()) {
+        boost::log::core::get()->remove_sink(tag_it->second.lock());
+        Logging::loggers_.erase(tag_it);
+        ret = true;
+      }
+
+      return ret;
+    }
+
     void Logging::write_severity_log(
       const LogTag &tag, boost::log::trivial::severity_level level,
       const std::string &message
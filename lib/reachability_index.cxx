@@ -0,0 +1,254 @@
+#include "dag_scheduler/reachability_index.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace com {
+  namespace dag_scheduler {
+    constexpr std::size_t ReachabilityIndex::default_dense_limit;
+
+    ReachabilityIndex::ReachabilityIndex(
+      const FrozenDAG &plan, std::size_t dense_limit
+    ) :
+      vertex_count_(plan.vertex_count()), words_per_row_(0) {
+      successor_offsets_.reserve(vertex_count_ + 1);
+      predecessor_offsets_.reserve(vertex_count_ + 1);
+      successor_offsets_.push_back(0);
+      predecessor_offsets_.push_back(0);
+      for (std::size_t i = 0; i < vertex_count_; ++i) {
+        const Index at = static_cast<Index>(i);
+        for (Index s : plan.successors(at)) {
+          successor_targets_.push_back(s);
+        }
+        for (Index p : plan.predecessors(at)) {
+          predecessor_targets_.push_back(p);
+        }
+        successor_offsets_.push_back(
+          static_cast<Index>(successor_targets_.size())
+        );
+        predecessor_offsets_.push_back(
+          static_cast<Index>(predecessor_targets_.size())
+        );
+      }
+
+      build_topological_rank(plan);
+      if (!topological_rank_.empty() && vertex_count_ <= dense_limit) {
+        build_closure(plan);
+      } else {
+        build_intervals(plan);
+      }
+    }
+
+    bool ReachabilityIndex::is_reachable(Index from, Index to) const {
+      assert(
+        static_cast<std::size_t>(from) < vertex_count_ &&
+        static_cast<std::size_t>(to) < vertex_count_ &&
+        "Index out of bounds."
+      );
+      bool ret = false;
+
+      const std::size_t f = static_cast<std::size_t>(from);
+      const std::size_t t = static_cast<std::size_t>(to);
+      if (is_dense()) {
+        ret = ((row(from)[t / 64] >> (t % 64)) & 1u) != 0;
+      } else if (!topological_rank_.empty() &&
+                 topological_rank_[f] >= topological_rank_[t]) {
+        ret = false;
+      } else if (pre_order_[f] < pre_order_[t] &&
+                 pre_order_[t] <= post_order_[f]) {
+        ret = true;
+      } else {
+        ret = search(from, to);
+      }
+
+      return ret;
+    }
+
+    std::vector<ReachabilityIndex::Index>
+    ReachabilityIndex::downstream_of(Index from) const {
+      std::vector<Index> ret;
+
+      if (is_dense()) {
+        const std::uint64_t *bits = row(from);
+        for (std::size_t w = 0; w < words_per_row_; ++w) {
+          for (std::uint64_t word = bits[w]; word != 0; word &= word - 1) {
+            std::size_t bit = 0;
+            while (((word >> bit) & 1u) == 0) {
+              ++bit;
+            }
+            ret.push_back(static_cast<Index>(w * 64 + bit));
+          }
+        }
+      } else {
+        ret = walk(from, successor_offsets_, successor_targets_);
+      }
+
+      return ret;
+    }
+
+    std::vector<ReachabilityIndex::Index>
+    ReachabilityIndex::upstream_of(Index to) const {
+      return walk(to, predecessor_offsets_, predecessor_targets_);
+    }
+
+    bool ReachabilityIndex::is_dense() const { return !closure_.empty(); }
+
+    std::size_t ReachabilityIndex::vertex_count() const {
+      return vertex_count_;
+    }
+
+    void ReachabilityIndex::build_topological_rank(const FrozenDAG &plan) {
+      std::vector<Index> remaining = plan.in_degrees();
+      std::vector<Index> order;
+      order.reserve(vertex_count_);
+      for (std::size_t i = 0; i < vertex_count_; ++i) {
+        if (remaining[i] == 0) {
+          order.push_back(static_cast<Index>(i));
+        }
+      }
+      // order doubles as Kahn's queue.
+      for (std::size_t head = 0; head < order.size(); ++head) {
+        for (Index s : plan.successors(order[head])) {
+          if (--remaining[static_cast<std::size_t>(s)] == 0) {
+            order.push_back(s);
+          }
+        }
+      }
+
+      if (order.size() == vertex_count_) {
+        topological_rank_.resize(vertex_count_);
+        for (std::size_t r = 0; r < order.size(); ++r) {
+          topological_rank_[static_cast<std::size_t>(order[r])] =
+            static_cast<Index>(r);
+        }
+      }
+    }
+
+    void ReachabilityIndex::build_closure(const FrozenDAG &plan) {
+      words_per_row_ = (vertex_count_ + 63) / 64;
+      closure_.assign(vertex_count_ * words_per_row_, 0);
+
+      std::vector<Index> order(vertex_count_);
+      for (std::size_t i = 0; i < vertex_count_; ++i) {
+        order[static_cast<std::size_t>(topological_rank_[i])] =
+          static_cast<Index>(i);
+      }
+      // Every successor comes later in the order, so walking it backwards
+      // finishes a row before any row that needs it.
+      for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        std::uint64_t *bits = closure_.data() +
+                              static_cast<std::size_t>(*it) * words_per_row_;
+        for (Index s : plan.successors(*it)) {
+          const std::size_t at = static_cast<std::size_t>(s);
+          bits[at / 64] |= (std::uint64_t(1) << (at % 64));
+          const std::uint64_t *from = row(s);
+          for (std::size_t w = 0; w < words_per_row_; ++w) {
+            bits[w] |= from[w];
+          }
+        }
+      }
+    }
+
+    void ReachabilityIndex::build_intervals(const FrozenDAG &plan) {
+      pre_order_.assign(vertex_count_, FrozenDAG::npos);
+      post_order_.assign(vertex_count_, FrozenDAG::npos);
+
+      Index next = 0;
+      std::vector<std::pair<Index, std::size_t>> stack;
+      auto visit = [&](Index root) {
+        pre_order_[static_cast<std::size_t>(root)] = next++;
+        stack.emplace_back(root, 0);
+        while (!stack.empty()) {
+          const Index curr = stack.back().first;
+          FrozenDAG::IndexRange succ = plan.successors(curr);
+          std::size_t &edge = stack.back().second;
+          while (edge < succ.size() &&
+                 pre_order_[static_cast<std::size_t>(succ[edge])] !=
+                   FrozenDAG::npos) {
+            ++edge;
+          }
+          if (edge < succ.size()) {
+            const Index child = succ[edge++];
+            pre_order_[static_cast<std::size_t>(child)] = next++;
+            stack.emplace_back(child, 0);
+          } else {
+            post_order_[static_cast<std::size_t>(curr)] = next - 1;
+            stack.pop_back();
+          }
+        }
+      };
+      // Roots first keeps the trees, and so the intervals, as large as
+      // possible. The second pass picks up vertices only on a cycle.
+      for (std::size_t i = 0; i < vertex_count_; ++i) {
+        if (plan.in_degree(static_cast<Index>(i)) == 0) {
+          visit(static_cast<Index>(i));
+        }
+      }
+      for (std::size_t i = 0; i < vertex_count_; ++i) {
+        if (pre_order_[i] == FrozenDAG::npos) {
+          visit(static_cast<Index>(i));
+        }
+      }
+    }
+
+    bool ReachabilityIndex::search(Index from, Index to) const {
+      bool ret = false;
+
+      const std::size_t t = static_cast<std::size_t>(to);
+      const bool ranked = !topological_rank_.empty();
+      std::vector<bool> seen(vertex_count_, false);
+      std::vector<Index> pending{from};
+      while (!ret && !pending.empty()) {
+        const std::size_t curr = static_cast<std::size_t>(pending.back());
+        pending.pop_back();
+        for (Index i = successor_offsets_[curr];
+             !ret && i < successor_offsets_[curr + 1]; ++i) {
+          const std::size_t s = static_cast<std::size_t>(
+            successor_targets_[static_cast<std::size_t>(i)]
+          );
+          if (s == t || (pre_order_[s] < pre_order_[t] &&
+                         pre_order_[t] <= post_order_[s])) {
+            ret = true;
+          } else if (!seen[s] &&
+                     (!ranked ||
+                      topological_rank_[s] < topological_rank_[t])) {
+            seen[s] = true;
+            pending.push_back(static_cast<Index>(s));
+          }
+        }
+      }
+
+      return ret;
+    }
+
+    std::vector<ReachabilityIndex::Index> ReachabilityIndex::walk(
+      Index start, const std::vector<Index> &offsets,
+      const std::vector<Index> &targets
+    ) const {
+      std::vector<Index> ret;
+
+      std::vector<bool> seen(vertex_count_, false);
+      std::vector<Index> pending{start};
+      while (!pending.empty()) {
+        const std::size_t curr = static_cast<std::size_t>(pending.back());
+        pending.pop_back();
+        for (Index i = offsets[curr]; i < offsets[curr + 1]; ++i) {
+          const Index next = targets[static_cast<std::size_t>(i)];
+          if (!seen[static_cast<std::size_t>(next)]) {
+            seen[static_cast<std::size_t>(next)] = true;
+            ret.push_back(next);
+            pending.push_back(next);
+          }
+        }
+      }
+      std::sort(ret.begin(), ret.end());
+
+      return ret;
+    }
+
+    const std::uint64_t *ReachabilityIndex::row(Index i) const {
+      return closure_.data() + static_cast<std::size_t>(i) * words_per_row_;
+    }
+  } // namespace dag_scheduler
+} // namespace com
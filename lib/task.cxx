@@ -1,9 +1,13 @@
 #include "dag_scheduler/task.h"
 
+#include "dag_scheduler/content_hash.h"
 #include "dag_scheduler/logging.h"
 #include "dag_scheduler/task_callback_plugin.h"
 
+#include <algorithm>
+#include <cassert>
 #include <memory>
+#include <typeinfo>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
@@ -172,6 +176,7 @@ namespace com {
     Task::Task(Task &&other) :
       LoggedClass<Task>(*this), iterating_(false), kill_(false),
       stages_(std::move(other.stages_)), label_(std::move(other.label_)),
+      cost_estimate_(other.cost_estimate_), priority_(other.priority_),
       uuid_(other.uuid_.clone()), json_config_(std::move(other.json_config_)),
       json_initial_inputs_(std::move(other.json_initial_inputs_)) {
       assert(
@@ -190,6 +195,8 @@ namespace com {
       kill_.store(false);
       stages_ = std::move(other.stages_);
       label_ = std::move(other.label_);
+      cost_estimate_ = other.cost_estimate_;
+      priority_ = other.priority_;
       uuid_ = other.uuid_.clone();
       json_config_ = std::move(other.json_config_);
       json_initial_inputs_ = std::move(other.json_initial_inputs_);
@@ -201,12 +208,24 @@ namespace com {
 
     const UUID &Task::get_uuid() const { return uuid_; }
 
+    double Task::cost_estimate() const { return cost_estimate_; }
+
+    void Task::set_cost_estimate(double seconds) { cost_estimate_ = seconds; }
+
+    double Task::priority() const { return priority_; }
+
+    void Task::set_priority(double priority) { priority_ = priority; }
+
+    std::chrono::nanoseconds Task::run_time() const { return run_time_; }
+
     bool
     Task::iterate_stages(const std::function<bool(TaskStage &)> &next_stage) {
       bool ran_all = false;
 
       if (not iterating_.load()) {
         iterating_.store(true);
+        const std::chrono::steady_clock::time_point started =
+          std::chrono::steady_clock::now();
         {
           ran_all = std::all_of(
             stages_.begin(), stages_.end(),
@@ -218,6 +237,9 @@ namespace com {
             }
           );
         }
+        run_time_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - started
+        );
         iterating_.store(false);
       }
 
@@ -241,6 +263,34 @@ namespace com {
         );
         complete_callback_plugin_->completed(status, (*this));
       }
+
+      if (dependency_callback_) {
+        dependency_callback_(status);
+      }
+    }
+
+    void Task::set_dependency_callback(std::function<void(bool)> callback) {
+      dependency_callback_ = std::move(callback);
+    }
+
+    void Task::set_fan_out_callback(FanOutTaskStage::Emit_t emit) {
+      for (std::unique_ptr<TaskStage> &stage : stages_) {
+        FanOutTaskStage *fan_out =
+          dynamic_cast<FanOutTaskStage *>(stage.get());
+        if (fan_out != nullptr) {
+          fan_out->set_emit(emit);
+        }
+      }
+    }
+
+    bool Task::fans_out() const {
+      return std::any_of(
+        stages_.begin(), stages_.end(),
+        [](const std::unique_ptr<TaskStage> &stage) {
+          return dynamic_cast<const FanOutTaskStage *>(stage.get()) !=
+                 nullptr;
+        }
+      );
     }
 
     bool Task::callback_is_set() const {
@@ -283,46 +333,75 @@ namespace com {
       }
     }
 
+    const rapidjson::Document &Task::json_initial_inputs() const {
+      return (*json_initial_inputs_);
+    }
+
+    void Task::visit_stages(
+      const std::function<void(const TaskStage &)> &visit
+    ) const {
+      for (const std::unique_ptr<TaskStage> &stage : stages_) {
+        visit(*stage);
+      }
+    }
+
+    std::uint64_t Task::content_hash() const {
+      ContentHash ret;
+
+      for (const std::unique_ptr<TaskStage> &stage : stages_) {
+        // Without an origin the dynamic type is the best name there is for
+        // the code a stage runs.
+        ret.add(
+          stage->origin().empty() ? std::string(typeid(*stage).name())
+                                  : stage->origin()
+        );
+        ret.add(stage->label());
+      }
+      ret.add(ContentHash::canonical_json(json_config()));
+      ret.add(ContentHash::canonical_json(json_initial_inputs()));
+
+      return ret.value();
+    }
+
+    void Task::override_initial_inputs(
+      const rapidjson::Document &json_initial_inputs
+    ) {
+      assert(!iterating_.load() && "Task is running.");
+      set_json_initial_inputs(json_initial_inputs);
+    }
+
     std::unique_ptr<Task> Task::clone() const {
       std::vector<std::unique_ptr<TaskStage>> cloned_stages;
       std::for_each(
         stages_.begin(), stages_.end(),
         [&cloned_stages](const std::unique_ptr<TaskStage> &next_stage) {
           std::unique_ptr<TaskStage> &&task_stage_ptr = next_stage->clone();
+          // Stages clone themselves without knowing where they came from.
+          task_stage_ptr->set_origin(next_stage->origin());
           cloned_stages.push_back(std::move(task_stage_ptr));
         }
       );
 
-      rapidjson::Document json_config;
-      if (json_config_) {
-        rapidjson::Document &this_document = *(json_config_.get());
-        json_config.CopyFrom(this_document, json_config.GetAllocator());
-      }
-
-      rapidjson::Document json_initial_inputs;
-      if (json_initial_inputs_) {
-        rapidjson::Document &this_document = *(json_initial_inputs_.get());
-        json_initial_inputs.CopyFrom(
-          this_document, json_initial_inputs.GetAllocator()
-        );
-      }
-
       std::unique_ptr<Task> task_ptr;
       if (complete_callback_plugin_) {
         std::unique_ptr<TaskCallbackPlugin> &&callback_plugin =
           complete_callback_plugin_->clone();
         task_ptr = std::make_unique<Task>(
-          cloned_stages, label_, std::move(callback_plugin), json_config,
-          json_initial_inputs
+          cloned_stages, label_, std::move(callback_plugin)
         );
       } else {
-        task_ptr = std::make_unique<Task>(
-          cloned_stages, label_, complete_callback_, json_config,
-          json_initial_inputs
-        );
+        task_ptr =
+          std::make_unique<Task>(cloned_stages, label_, complete_callback_);
       }
 
+      if (json_config_) {
+        task_ptr->json_config_ = json_config_;
+      }
+      if (json_initial_inputs_) {
+        task_ptr->json_initial_inputs_ = json_initial_inputs_;
+      }
       task_ptr->update_uuid(uuid_);
+      task_ptr->cost_estimate_ = cost_estimate_;
 
       return task_ptr;
     }
@@ -374,23 +453,17 @@ namespace com {
     }
 
     void Task::set_json_config(const rapidjson::Document &json_config) {
-      if (json_config_) {
-        json_config_.reset();
-      }
-      json_config_ = std::make_unique<rapidjson::Document>();
-      json_config_->CopyFrom(json_config, json_config_->GetAllocator());
+      auto document = std::make_shared<rapidjson::Document>();
+      document->CopyFrom(json_config, document->GetAllocator());
+      json_config_ = std::move(document);
     }
 
     void Task::set_json_initial_inputs(
       const rapidjson::Document &json_initial_inputs
     ) {
-      if (json_initial_inputs_) {
-        json_initial_inputs_.reset();
-      }
-      json_initial_inputs_ = std::make_unique<rapidjson::Document>();
-      json_initial_inputs_->CopyFrom(
-        json_initial_inputs, json_initial_inputs_->GetAllocator()
-      );
+      auto document = std::make_shared<rapidjson::Document>();
+      document->CopyFrom(json_initial_inputs, document->GetAllocator());
+      json_initial_inputs_ = std::move(document);
     }
 
     void Task::update_uuid(const UUID &uuid) {
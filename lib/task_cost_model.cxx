@@ -0,0 +1,52 @@
+#include "dag_scheduler/task_cost_model.h"
+
+#include <cassert>
+
+namespace com {
+  namespace dag_scheduler {
+    constexpr double TaskCostModel::default_smoothing;
+
+    TaskCostModel::TaskCostModel(double default_cost, double smoothing) :
+      default_cost_(default_cost), smoothing_(smoothing) {
+      assert(default_cost > 0.0 && "A default cost must be positive.");
+      assert(
+        smoothing > 0.0 && smoothing <= 1.0 &&
+        "Smoothing must be in (0, 1]."
+      );
+    }
+
+    double TaskCostModel::estimate(const Task &t) const {
+      double ret = default_cost_;
+
+      std::lock_guard<std::mutex> lock(history_lock_);
+      auto found = history_.find(t.label());
+      if (found != history_.end()) {
+        ret = found->second;
+      } else if (t.cost_estimate() > 0.0) {
+        ret = t.cost_estimate();
+      }
+
+      return ret;
+    }
+
+    void TaskCostModel::record(
+      const Task &t, const std::chrono::nanoseconds &run_time
+    ) {
+      const double seconds =
+        std::chrono::duration_cast<std::chrono::duration<double>>(run_time)
+          .count();
+
+      std::lock_guard<std::mutex> lock(history_lock_);
+      auto inserted = history_.emplace(t.label(), seconds);
+      if (!inserted.second) {
+        double &average = inserted.first->second;
+        average += smoothing_ * (seconds - average);
+      }
+    }
+
+    bool TaskCostModel::has_history(const std::string &label) const {
+      std::lock_guard<std::mutex> lock(history_lock_);
+      return history_.count(label) != 0;
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -0,0 +1,131 @@
+#include "dag_scheduler/task_result_cache.h"
+
+#include "dag_scheduler/content_hash.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <boost/filesystem/operations.hpp>
+
+namespace com {
+  namespace dag_scheduler {
+    constexpr std::size_t TaskResultCache::default_memory_capacity;
+
+    TaskResultCache::TaskResultCache(
+      std::size_t memory_capacity, const boost::filesystem::path &directory
+    ) :
+      LoggedClass<TaskResultCache>(*this), memory_capacity_(memory_capacity),
+      directory_(directory) {
+      if (!directory_.empty()) {
+        boost::system::error_code error;
+        boost::filesystem::create_directories(directory_, error);
+        if (error) {
+          Logging::error(
+            LOG_TAG, "Could not create", directory_.string(), ":",
+            error.message(), "so results are only kept in memory."
+          );
+          directory_.clear();
+        }
+      }
+    }
+
+    TaskResultCache::Key
+    TaskResultCache::key(const Task &t, const std::vector<Key> &upstream) {
+      ContentHash ret;
+
+      ret.add(t.content_hash());
+      ret.add(key(upstream));
+
+      return ret.value();
+    }
+
+    TaskResultCache::Key
+    TaskResultCache::key(const std::vector<Key> &upstream) {
+      ContentHash ret;
+
+      ret.add(static_cast<std::uint64_t>(upstream.size()));
+      for (Key k : upstream) {
+        ret.add(k);
+      }
+
+      return ret.value();
+    }
+
+    bool TaskResultCache::contains(Key key) {
+      std::lock_guard<std::mutex> lock(lock_);
+      bool ret = false;
+
+      auto found = index_.find(key);
+      if (found != index_.end()) {
+        lru_.splice(lru_.begin(), lru_, found->second);
+        ret = true;
+      } else if (!directory_.empty()) {
+        boost::system::error_code error;
+        if (boost::filesystem::exists(path_of(key), error)) {
+          remember(key);
+          ++disk_hits_;
+          ret = true;
+        }
+      }
+      ++(ret ? hits_ : misses_);
+
+      return ret;
+    }
+
+    void TaskResultCache::insert(Key key) {
+      bool known = false;
+      {
+        std::lock_guard<std::mutex> lock(lock_);
+        known = index_.find(key) != index_.end();
+        if (!known) {
+          remember(key);
+        }
+      }
+
+      // A key in memory was written or found on disk already. The file is
+      // written outside of lock_, which only guards memory.
+      if (!(known || directory_.empty())) {
+        const boost::filesystem::path path = path_of(key);
+        boost::system::error_code error;
+        if (!boost::filesystem::exists(path, error)) {
+          std::ofstream out(path.string(), std::ios::trunc);
+          out << path.filename().string() << std::endl;
+          if (!out) {
+            Logging::warn(
+              LOG_TAG, "Could not write", path.string(), "to the cache."
+            );
+          }
+        }
+      }
+    }
+
+    void TaskResultCache::clear_memory() {
+      std::lock_guard<std::mutex> lock(lock_);
+      lru_.clear();
+      index_.clear();
+    }
+
+    TaskResultCache::Stats TaskResultCache::stats() const {
+      std::lock_guard<std::mutex> lock(lock_);
+      return Stats{hits_, misses_, disk_hits_, lru_.size()};
+    }
+
+    void TaskResultCache::remember(Key key) {
+      if (memory_capacity_ > 0) {
+        if (lru_.size() == memory_capacity_) {
+          index_.erase(lru_.back());
+          lru_.pop_back();
+        }
+        lru_.push_front(key);
+        index_.emplace(key, lru_.begin());
+      }
+    }
+
+    boost::filesystem::path TaskResultCache::path_of(Key key) const {
+      std::stringstream name;
+      name << std::hex << std::setw(16) << std::setfill('0') << key;
+      return directory_ / name.str();
+    }
+  } // namespace dag_scheduler
+} // namespace com
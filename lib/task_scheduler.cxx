@@ -2,60 +2,168 @@
 
 #include "dag_scheduler/logging.h"
 
+#include <algorithm>
+#include <functional>
+#include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace com {
   namespace dag_scheduler {
-    TaskScheduler::TaskScheduler() :
-      LoggedClass<TaskScheduler>(*this), pause_(true), kill_(true) {
-      for (std::uint8_t id = 0; id < thread_pool_.size(); ++id) {
-        thread_pool_[id].reset(
-          new InterruptibleTaskThread(LogTag(std::to_string(id)))
-        );
+    namespace detail {
+      // The scheduler and index of the pool thread this is, once it went
+      // idle the first time. Until then what it queues goes on the queue.
+      thread_local const TaskScheduler *current_scheduler = nullptr;
+      thread_local std::size_t current_id = 0;
+
+      std::size_t random_victim(std::size_t count) {
+        thread_local std::minstd_rand generator(static_cast<unsigned>(
+          std::hash<std::thread::id>()(std::this_thread::get_id())
+        ));
+        return static_cast<std::size_t>(generator()) % count;
+      }
+
+      // Completed, unsuccessfully, rather than just destroyed, so what
+      // waits on it, such as a DAGExecution, is not left hanging.
+      void drop(std::unique_ptr<Task> &task) {
+        task->kill();
+        task->complete(false);
+        task.reset(nullptr);
+      }
+    } // namespace detail
+
+    TaskScheduler::TaskScheduler() : TaskScheduler(default_pool_size()) {}
+
+    TaskScheduler::TaskScheduler(
+      std::size_t pool_size, Mode mode, Queue queue
+    ) :
+      TaskScheduler(
+        pool_size, PoolLimits{pool_size, pool_size}, mode, queue
+      ) {}
+
+    TaskScheduler::TaskScheduler(
+      std::size_t pool_size, const PoolLimits &limits, Mode mode,
+      Queue queue
+    ) :
+      LoggedClass<TaskScheduler>(*this), killed_size_(0), taking_(0),
+      pause_(true), kill_(true), limits_(limits), elastic_(false),
+      mode_(mode), stealable_(0), pool_size_(0) {
+      limits_.min_size = std::max<std::size_t>(limits_.min_size, 1);
+      limits_.max_size = std::max(limits_.max_size, limits_.min_size);
+      elastic_ = limits_.min_size < limits_.max_size;
+      pool_size =
+        std::min(std::max(pool_size, limits_.min_size), limits_.max_size);
+      if (queue == Queue::lock_free) {
+        ring_.reset(new BoundedTaskQueue());
+      }
+      if (mode_ == Mode::work_stealing) {
+        deques_.reserve(limits_.max_size);
+        for (std::size_t i = 0; i < limits_.max_size; ++i) {
+          deques_.emplace_back(new WorkStealingDeque());
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(thread_pool_lock_);
+      thread_pool_.reserve(pool_size);
+      idle_since_.reserve(pool_size);
+      for (std::size_t i = 0; i < pool_size; ++i) {
+        add_thread();
+      }
+    }
+
+    TaskScheduler::~TaskScheduler() {
+      shutdown();
+      // Joined first, so a Task still running cannot queue more behind
+      // the drop. Outside of thread_pool_lock_, as idle callbacks take it.
+      std::vector<std::unique_ptr<InterruptibleTaskThread>> threads;
+      {
+        std::lock_guard<std::mutex> lock(thread_pool_lock_);
+        threads.swap(thread_pool_);
       }
+      threads.clear();
+      drop_queued();
+    }
+
+    std::size_t TaskScheduler::default_pool_size() {
+      return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
     }
 
     bool TaskScheduler::startup() {
       pause_.store(false);
       kill_.store(false);
-      auto refresh_time = std::chrono::milliseconds(5);
       while (!kill_.load()) {
-        bool should_get_next = !(kill_.load() || pause_.load());
-        if (should_get_next) {
+        InterruptibleTaskThread *thread = nullptr;
+        std::size_t id = 0;
+        std::unique_ptr<InterruptibleTaskThread> retired;
+        bool resized = false;
+        std::size_t resized_from = 0;
+        ResizeCallback_t resize_callback;
+        {
+          std::unique_lock<std::mutex> lock(thread_pool_lock_);
+          // Announced before the check, so what changes after it wakes
+          // this, whether or not it takes thread_pool_lock_.
+          const EventCount::Key_t key = dispatcher_event_.prepare_wait();
+          // Not a wait with a predicate: each wake up may start or end a
+          // wait on a full pool, which moves the deadline.
+          const Clock_t::time_point resize_at = next_resize();
+          if (kill_.load() || can_dispatch()) {
+            dispatcher_event_.cancel_wait();
+          } else {
+            lock.unlock();
+            if (resize_at == Clock_t::time_point::max()) {
+              dispatcher_event_.wait(key);
+            } else {
+              dispatcher_event_.wait_until(key, resize_at);
+            }
+            lock.lock();
+          }
+          if (kill_.load()) {
+            break;
+          }
+          if (can_dispatch()) {
+            id = idle_.back();
+            idle_.pop_back();
+            thread = thread_pool_[id].get();
+          } else {
+            resized_from = pool_size_.load();
+            resized = resize(retired);
+            resize_callback = resize_callback_;
+          }
+        }
+        // A removed thread is idle, so joining it is quick. It is done
+        // outside of thread_pool_lock_ as its idle callback takes it.
+        retired.reset(nullptr);
+        if (resized) {
+          Logging::info(
+            LOG_TAG, "Resized the pool from", resized_from, "to",
+            pool_size_.load()
+          );
+          if (resize_callback) {
+            resize_callback(resized_from, pool_size_.load());
+          }
+        }
+
+        if (thread != nullptr) {
+          bool handed_over = false;
           std::unique_ptr<Task> next_task = nullptr;
-          queue_.wait_for_and_pop(next_task, refresh_time);
-          if (next_task) {
+          // kill_task, or a thread that went idle, may have taken the
+          // work.
+          if (take_task(id, next_task) && next_task) {
             Logging::info(LOG_TAG, "next task =", (*next_task));
-            while (true) {
-              if (kill_.load()) {
-                if (next_task) {
-                  next_task->kill();
-                }
-                break;
-              }
-              if (!pause_.load()) {
-                std::size_t unused_index = first_unused_thread();
-                if (unused_index != static_cast<std::size_t>(-1)) {
-                  if (kill_.load()) {
-                    if (next_task) {
-                      next_task->kill();
-                    }
-                    next_task.reset(nullptr);
-                    break;
-                  }
-                  {
-                    std::lock_guard<std::mutex> lock(thread_pool_lock_);
-                    if (next_task) {
-                      thread_pool_[unused_index]->set_task_and_run(
-                        std::move(next_task)
-                      );
-                    }
-                  }
-                }
+            if (kill_.load()) {
+              detail::drop(next_task);
+            } else {
+              handed_over = thread->set_task_and_run(std::move(next_task));
+              if (!handed_over) {
+                queue_.push(std::move(next_task));
               }
             }
           }
+          if (!handed_over) {
+            std::lock_guard<std::mutex> lock(thread_pool_lock_);
+            idle_.push_back(id);
+          }
         }
       }
 
@@ -63,7 +171,18 @@ namespace com {
     }
 
     void TaskScheduler::queue_task(std::unique_ptr<Task> &&t) {
-      queue_.push(std::move(t));
+      if (mode_ == Mode::work_stealing &&
+          detail::current_scheduler == this) {
+        // Counted first, so stealable_ never reads less than there is.
+        ++stealable_;
+        deques_[detail::current_id]->push(std::move(t));
+      } else if (ring_ == nullptr || !ring_->try_push(std::move(t))) {
+        // Onto the queue once the ring is full, rather than block what
+        // queued it, which may be a Task on the pool.
+        queue_.push(std::move(t));
+      }
+      // Idle threads, if any, are to steal it.
+      wake_dispatcher();
     }
 
     bool TaskScheduler::kill_task(const Task &t) {
@@ -73,33 +192,257 @@ namespace com {
     bool TaskScheduler::kill_task(const UUID &u) {
       std::unique_ptr<Task> to_kill;
       queue_.remove_task_from_queue(u, to_kill);
+      if (to_kill != nullptr) {
+        detail::drop(to_kill);
+      }
+      // Otherwise it may be on the ring or a deque, which can only be
+      // popped from. If both are empty it ran already, or never was queued.
+      if (to_kill == nullptr && !ring_and_deques_empty()) {
+        std::lock_guard<std::mutex> lock(killed_lock_);
+        killed_.emplace(u.clone());
+        killed_size_.store(killed_.size());
+      }
       return true;
-      ;
     }
 
-    void TaskScheduler::pause() { pause_.store(true); }
+    void TaskScheduler::pause() {
+      pause_.store(true);
+      wake_dispatcher();
+    }
 
-    void TaskScheduler::resume() { pause_.store(false); }
+    void TaskScheduler::resume() {
+      pause_.store(false);
+      wake_dispatcher();
+    }
 
     bool TaskScheduler::is_paused() { return pause_.load(); }
 
     void TaskScheduler::shutdown() {
       pause();
       kill_.store(true);
+      wake_dispatcher();
+      drop_queued();
     }
 
     bool TaskScheduler::is_shutdown() { return kill_.load(); }
 
-    std::size_t TaskScheduler::first_unused_thread() {
+    std::size_t TaskScheduler::pool_size() const { return pool_size_.load(); }
+
+    const TaskScheduler::PoolLimits &TaskScheduler::pool_limits() const {
+      return limits_;
+    }
+
+    void
+    TaskScheduler::set_resize_callback(ResizeCallback_t resize_callback) {
       std::lock_guard<std::mutex> lock(thread_pool_lock_);
-      std::size_t first_unused_index = static_cast<std::size_t>(-1);
-      for (std::size_t i = 0; i < thread_pool_.size(); ++i) {
-        if (not thread_pool_[i]->is_running()) {
-          first_unused_index = i;
-          break;
+      resize_callback_ = std::move(resize_callback);
+    }
+
+    TaskScheduler::Mode TaskScheduler::mode() const { return mode_; }
+
+    TaskScheduler::Queue TaskScheduler::queue() const {
+      return (ring_ != nullptr) ? Queue::lock_free : Queue::locked;
+    }
+
+    bool TaskScheduler::has_work() const {
+      return !queue_.empty() || (ring_ != nullptr && !ring_->empty()) ||
+             stealable_.load() > 0;
+    }
+
+    bool TaskScheduler::ring_and_deques_empty() const {
+      return (ring_ == nullptr || ring_->empty()) && stealable_.load() == 0;
+    }
+
+    bool TaskScheduler::can_dispatch() const {
+      return !pause_.load() && !idle_.empty() && has_work();
+    }
+
+    bool TaskScheduler::is_starved() const {
+      return !pause_.load() && idle_.empty() && has_work();
+    }
+
+    bool
+    TaskScheduler::take_task(std::size_t id, std::unique_ptr<Task> &task) {
+      bool ret = false;
+
+      ++taking_;
+      if (mode_ == Mode::work_stealing) {
+        // Only the owner pops, newest first. Anyone else steals.
+        const bool owner =
+          detail::current_scheduler == this && detail::current_id == id;
+        if (owner) {
+          ret = deques_[id]->pop(task);
+        }
+        if (!ret && stealable_.load() > 0) {
+          const std::size_t count = deques_.size();
+          const std::size_t first = detail::random_victim(count);
+          for (std::size_t i = 0; i < count && !ret; ++i) {
+            const std::size_t victim = (first + i) % count;
+            if (!(owner && victim == id)) {
+              ret = deques_[victim]->steal(task);
+            }
+          }
+        }
+        if (ret) {
+          --stealable_;
+          if (task != nullptr && take_killed(*task)) {
+            detail::drop(task);
+          }
+        }
+      }
+      if (!ret && ring_ != nullptr) {
+        ret = ring_->try_pop(task);
+        if (ret && task != nullptr && take_killed(*task)) {
+          detail::drop(task);
+        }
+      }
+      if (!ret) {
+        ret = queue_.try_pop(task);
+      }
+      if (--taking_ == 0 && killed_size_.load() > 0) {
+        std::lock_guard<std::mutex> lock(killed_lock_);
+        // Drained, and what was popped was looked up, so no Task left to
+        // kill is on either. Checked in this order, as a pop empties them
+        // before its take is done.
+        if (ring_and_deques_empty() && taking_.load() == 0) {
+          killed_.clear();
+          killed_size_.store(0);
+        }
+      }
+
+      return ret;
+    }
+
+    bool TaskScheduler::take_killed(const Task &task) {
+      bool ret = false;
+
+      if (killed_size_.load() > 0) {
+        std::lock_guard<std::mutex> lock(killed_lock_);
+        ret = killed_.erase(task.get_uuid()) > 0;
+        killed_size_.store(killed_.size());
+      }
+
+      return ret;
+    }
+
+    void TaskScheduler::drop_queued() {
+      std::unique_ptr<Task> task;
+      for (std::unique_ptr<WorkStealingDeque> &deque : deques_) {
+        while (deque->steal(task)) {
+          --stealable_;
+          if (task != nullptr) {
+            detail::drop(task);
+          }
+        }
+      }
+      while (ring_ != nullptr && ring_->try_pop(task)) {
+        if (task != nullptr) {
+          detail::drop(task);
+        }
+      }
+      while (queue_.try_pop(task)) {
+        if (task != nullptr) {
+          detail::drop(task);
+        }
+      }
+    }
+
+    TaskScheduler::Clock_t::time_point TaskScheduler::next_resize() {
+      Clock_t::time_point ret = Clock_t::time_point::max();
+
+      if (elastic_) {
+        if (is_starved()) {
+          if (starved_since_ == Clock_t::time_point()) {
+            starved_since_ = Clock_t::now();
+          }
+          if (pool_size_.load() < limits_.max_size) {
+            ret = starved_since_ + limits_.grow_after;
+          }
+        } else {
+          starved_since_ = Clock_t::time_point();
+          if (!idle_.empty() && pool_size_.load() > limits_.min_size) {
+            ret = idle_since_[idle_.front()] + limits_.shrink_after;
+          }
+        }
+      }
+
+      return ret;
+    }
+
+    bool TaskScheduler::resize(
+      std::unique_ptr<InterruptibleTaskThread> &retired
+    ) {
+      bool ret = false;
+
+      const Clock_t::time_point now = Clock_t::now();
+      if (next_resize() <= now) {
+        if (is_starved()) {
+          add_thread();
+          // Grow again only if work waits that long once more.
+          starved_since_ = now;
+        } else {
+          const std::size_t id = idle_.front();
+          idle_.pop_front();
+          retired = std::move(thread_pool_[id]);
+          --pool_size_;
+        }
+        ret = true;
+      }
+
+      return ret;
+    }
+
+    void TaskScheduler::add_thread() {
+      std::size_t id = 0;
+      while (id < thread_pool_.size() && thread_pool_[id] != nullptr) {
+        ++id;
+      }
+      if (id == thread_pool_.size()) {
+        thread_pool_.emplace_back();
+        idle_since_.emplace_back();
+      }
+      thread_pool_[id].reset(
+        new InterruptibleTaskThread(LogTag(std::to_string(id)))
+      );
+      thread_pool_[id]->set_idle_callback([this, id]() { thread_idle(id); });
+      idle_since_[id] = Clock_t::now();
+      idle_.push_back(id);
+      ++pool_size_;
+    }
+
+    void TaskScheduler::thread_idle(std::size_t id) {
+      bool handed_over = false;
+      if (mode_ == Mode::work_stealing) {
+        detail::current_scheduler = this;
+        detail::current_id = id;
+        // Run the next Task here at once, rather than through startup.
+        std::unique_ptr<Task> next_task = nullptr;
+        if (!(pause_.load() || kill_.load()) && take_task(id, next_task) &&
+            next_task) {
+          InterruptibleTaskThread *thread = nullptr;
+          {
+            std::lock_guard<std::mutex> lock(thread_pool_lock_);
+            thread = thread_pool_[id].get();
+          }
+          handed_over = thread->set_task_and_run(std::move(next_task));
+          if (!handed_over) {
+            queue_.push(std::move(next_task));
+          }
+        }
+      }
+      if (!handed_over) {
+        {
+          std::lock_guard<std::mutex> lock(thread_pool_lock_);
+          idle_since_[id] = Clock_t::now();
+          idle_.push_back(id);
         }
+        dispatcher_event_.notify_one();
       }
-      return first_unused_index;
+    }
+
+    void TaskScheduler::wake_dispatcher() {
+      // No lock, and no system call unless the dispatcher is waiting.
+      dispatcher_event_.notify_one();
     }
   } // namespace dag_scheduler
 } // namespace com
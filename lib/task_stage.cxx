@@ -11,7 +11,8 @@ namespace com {
     TaskStage::~TaskStage() {}
 
     TaskStage::TaskStage(TaskStage &&other) :
-      label_(std::move(other.label_)), uuid_(std::move(other.uuid_)) {
+      label_(std::move(other.label_)), uuid_(std::move(other.uuid_)),
+      origin_(std::move(other.origin_)) {
       assert(not other.is_running() && "You cannot move a running TaskStage");
     }
 
@@ -20,6 +21,7 @@ namespace com {
 
       label_ = std::move(other.label_);
       uuid_ = std::move(other.uuid_);
+      origin_ = std::move(other.origin_);
 
       return (*this);
     }
@@ -28,6 +30,12 @@ namespace com {
 
     const UUID &TaskStage::get_uuid() const { return uuid_; }
 
+    const std::string &TaskStage::origin() const { return origin_; }
+
+    void TaskStage::set_origin(const std::string &origin) {
+      origin_ = origin;
+    }
+
     bool operator==(const TaskStage &lhs, const TaskStage &rhs) {
       return lhs.uuid_ == rhs.uuid_;
     }
@@ -1,5 +1,7 @@
 #include "dag_scheduler/uuid.h"
 
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 
@@ -18,7 +20,7 @@ namespace com {
 
     UUID::~UUID() { uuid_clear(uuid_); }
 
-    UUID UUID::clone() { return (*this); }
+    UUID UUID::clone() const { return (*this); }
 
     UUID::UUID(UUID &&other) {
       uuid_copy(uuid_, other.uuid_);
@@ -45,6 +47,19 @@ namespace com {
       return ret;
     }
 
+    std::size_t UUID::hash_value() const {
+      // uuid_t is 16 bytes; fold both halves so time based uuids, which
+      // share most of their low bytes, still spread across buckets.
+      std::uint64_t lo = 0;
+      std::uint64_t hi = 0;
+      std::memcpy(&lo, uuid_, sizeof(lo));
+      std::memcpy(&hi, uuid_ + sizeof(lo), sizeof(hi));
+
+      return static_cast<std::size_t>(
+        lo ^ (hi + 0x9e3779b97f4a7c15ULL + (lo << 6) + (lo >> 2))
+      );
+    }
+
     UUID::UUID(const UUID &other) { uuid_copy(uuid_, other.uuid_); }
 
     UUID &UUID::operator=(const UUID &rhs) {
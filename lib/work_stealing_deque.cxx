@@ -0,0 +1,123 @@
+#include "dag_scheduler/work_stealing_deque.h"
+
+#include <utility>
+
+// Follows "Correct and Efficient Work-Stealing for Weak Memory Models",
+// Le et al., PPoPP 2013, with seq_cst on the accesses to top_ and bottom_
+// that race in place of its fences, which TSan cannot check.
+namespace com {
+  namespace dag_scheduler {
+    WorkStealingDeque::Buffer::Buffer(std::size_t capacity) :
+      capacity(capacity), slots(new std::atomic<Task *>[capacity]) {
+      for (std::size_t i = 0; i < capacity; ++i) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+
+    Task *WorkStealingDeque::Buffer::get(std::int64_t i) const {
+      return slots[static_cast<std::size_t>(i) & (capacity - 1)].load(
+        std::memory_order_relaxed
+      );
+    }
+
+    void WorkStealingDeque::Buffer::put(std::int64_t i, Task *task) {
+      slots[static_cast<std::size_t>(i) & (capacity - 1)].store(
+        task, std::memory_order_relaxed
+      );
+    }
+
+    WorkStealingDeque::WorkStealingDeque(std::size_t capacity) :
+      top_(0), bottom_(0), buffer_(nullptr) {
+      std::size_t rounded = 1;
+      while (rounded < capacity) {
+        rounded <<= 1;
+      }
+      buffers_.emplace_back(new Buffer(rounded));
+      buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque::~WorkStealingDeque() {
+      std::unique_ptr<Task> task;
+      while (pop(task)) {
+        task.reset(nullptr);
+      }
+    }
+
+    void WorkStealingDeque::push(std::unique_ptr<Task> &&task) {
+      const std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+      const std::int64_t top = top_.load(std::memory_order_acquire);
+      Buffer *buffer = buffer_.load(std::memory_order_relaxed);
+      if (bottom - top >= static_cast<std::int64_t>(buffer->capacity)) {
+        buffer = grow(buffer, bottom, top);
+      }
+      buffer->put(bottom, task.release());
+      bottom_.store(bottom + 1, std::memory_order_release);
+    }
+
+    bool WorkStealingDeque::pop(std::unique_ptr<Task> &task) {
+      bool ret = false;
+
+      const std::int64_t bottom =
+        bottom_.load(std::memory_order_relaxed) - 1;
+      Buffer *buffer = buffer_.load(std::memory_order_relaxed);
+      bottom_.store(bottom, std::memory_order_seq_cst);
+      std::int64_t top = top_.load(std::memory_order_seq_cst);
+      if (top <= bottom) {
+        Task *taken = buffer->get(bottom);
+        ret = true;
+        if (top == bottom) {
+          // The last one: race the thieves for it.
+          ret = top_.compare_exchange_strong(
+            top, top + 1, std::memory_order_seq_cst,
+            std::memory_order_relaxed
+          );
+          bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        if (ret) {
+          task.reset(taken);
+        }
+      } else {
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+      }
+
+      return ret;
+    }
+
+    bool WorkStealingDeque::steal(std::unique_ptr<Task> &task) {
+      bool ret = false;
+
+      std::int64_t top = top_.load(std::memory_order_seq_cst);
+      const std::int64_t bottom = bottom_.load(std::memory_order_seq_cst);
+      if (top < bottom) {
+        Buffer *buffer = buffer_.load(std::memory_order_acquire);
+        Task *taken = buffer->get(top);
+        ret = top_.compare_exchange_strong(
+          top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed
+        );
+        if (ret) {
+          task.reset(taken);
+        }
+      }
+
+      return ret;
+    }
+
+    bool WorkStealingDeque::empty() const {
+      const std::int64_t bottom = bottom_.load(std::memory_order_acquire);
+      const std::int64_t top = top_.load(std::memory_order_acquire);
+      return bottom <= top;
+    }
+
+    WorkStealingDeque::Buffer *WorkStealingDeque::grow(
+      Buffer *buffer, std::int64_t bottom, std::int64_t top
+    ) {
+      buffers_.emplace_back(new Buffer(buffer->capacity * 2));
+      Buffer *grown = buffers_.back().get();
+      for (std::int64_t i = top; i < bottom; ++i) {
+        grown->put(i, buffer->get(i));
+      }
+      buffer_.store(grown, std::memory_order_release);
+      return grown;
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include "dag_scheduler/bounded_task_queue.h"
+
+#include "utils/test_task.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace com {
+  namespace dag_scheduler {
+    namespace detail {
+      std::unique_ptr<Task> numbered(std::size_t i) {
+        return std::unique_ptr<Task>(new TestTaskImpl(std::to_string(i)));
+      }
+    } // namespace detail
+
+    TEST(TestBoundedTaskQueue, empty) {
+      BoundedTaskQueue queue;
+      std::unique_ptr<Task> task;
+      EXPECT_TRUE(queue.empty());
+      EXPECT_EQ(0u, queue.size());
+      EXPECT_EQ(BoundedTaskQueue::default_capacity, queue.capacity());
+      EXPECT_FALSE(queue.try_pop(task));
+      EXPECT_FALSE(
+        queue.wait_for_and_pop(task, std::chrono::milliseconds(1))
+      );
+      EXPECT_EQ(nullptr, task);
+    }
+
+    TEST(TestBoundedTaskQueue, fifo_and_bounded) {
+      BoundedTaskQueue queue(3);
+      ASSERT_EQ(4u, queue.capacity());
+      for (std::size_t i = 0; i < queue.capacity(); ++i) {
+        EXPECT_TRUE(queue.try_push(detail::numbered(i)));
+      }
+      EXPECT_EQ(4u, queue.size());
+
+      std::unique_ptr<Task> refused = detail::numbered(4);
+      EXPECT_FALSE(queue.try_push(std::move(refused)));
+      ASSERT_NE(nullptr, refused);
+
+      // Around the ring a few times, so each cell is reused.
+      std::unique_ptr<Task> task;
+      for (std::size_t i = 0; i < 12; ++i) {
+        ASSERT_TRUE(queue.try_pop(task));
+        EXPECT_EQ(std::to_string(i), task->label());
+        EXPECT_TRUE(queue.try_push(detail::numbered(i + 4)));
+      }
+      queue.clear();
+      EXPECT_TRUE(queue.empty());
+    }
+
+    TEST(TestBoundedTaskQueue, push_waits_while_full) {
+      BoundedTaskQueue queue(2);
+      queue.push(detail::numbered(0));
+      queue.push(detail::numbered(1));
+
+      std::atomic_bool pushed(false);
+      std::thread producer([&]() {
+        queue.push(detail::numbered(2));
+        pushed.store(true);
+      });
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      EXPECT_FALSE(pushed.load());
+
+      std::unique_ptr<Task> task = queue.wait_and_pop();
+      EXPECT_EQ("0", task->label());
+      producer.join();
+      EXPECT_TRUE(pushed.load());
+      EXPECT_EQ(2u, queue.size());
+    }
+
+    TEST(TestBoundedTaskQueue, wait_and_pop_wakes_on_push) {
+      BoundedTaskQueue queue;
+      std::unique_ptr<Task> task;
+      std::thread consumer([&]() { task = queue.wait_and_pop(); });
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      queue.push(detail::numbered(7));
+      consumer.join();
+      ASSERT_NE(nullptr, task);
+      EXPECT_EQ("7", task->label());
+    }
+
+    TEST(TestBoundedTaskQueue, each_task_is_popped_once) {
+      const std::size_t count = 2000;
+      const std::size_t threads = 4;
+      BoundedTaskQueue queue(16);
+      std::atomic<std::size_t> popped(0);
+      std::vector<std::vector<std::string>> labels(threads);
+      std::vector<std::thread> consumers;
+      for (std::size_t c = 0; c < threads; ++c) {
+        consumers.emplace_back([&, c]() {
+          std::unique_ptr<Task> task;
+          while (popped.load() < count) {
+            if (queue.wait_for_and_pop(task, std::chrono::milliseconds(1))) {
+              labels[c].push_back(task->label());
+              ++popped;
+            }
+          }
+        });
+      }
+      std::vector<std::thread> producers;
+      for (std::size_t p = 0; p < threads; ++p) {
+        producers.emplace_back([&, p]() {
+          for (std::size_t i = p; i < count; i += threads) {
+            queue.push(detail::numbered(i));
+          }
+        });
+      }
+      for (std::thread &producer : producers) {
+        producer.join();
+      }
+      for (std::thread &consumer : consumers) {
+        consumer.join();
+      }
+
+      std::set<std::string> taken;
+      for (const std::vector<std::string> &popped_labels : labels) {
+        taken.insert(popped_labels.begin(), popped_labels.end());
+      }
+      EXPECT_EQ(count, taken.size());
+      EXPECT_TRUE(queue.empty());
+    }
+
+    TEST(TestBoundedTaskQueue, many_producers_on_a_full_ring) {
+      // Far more producers than slots, so most pushes wait on a full ring.
+      const std::size_t count = 2048;
+      const std::size_t producers = 32;
+      const std::size_t consumers = 4;
+      BoundedTaskQueue queue(4);
+      std::atomic<std::size_t> popped(0);
+      std::vector<std::vector<std::string>> labels(consumers);
+      std::vector<std::thread> threads;
+      for (std::size_t c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c]() {
+          std::unique_ptr<Task> task;
+          while (popped.load() < count) {
+            if (queue.wait_for_and_pop(task, std::chrono::milliseconds(1))) {
+              labels[c].push_back(task->label());
+              ++popped;
+            }
+          }
+        });
+      }
+      for (std::size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+          for (std::size_t i = p; i < count; i += producers) {
+            queue.push(detail::numbered(i));
+          }
+        });
+      }
+      for (std::thread &thread : threads) {
+        thread.join();
+      }
+
+      // Each popped once: as many labels as pushes, and all different.
+      std::set<std::string> taken;
+      std::size_t total = 0;
+      for (const std::vector<std::string> &popped_labels : labels) {
+        taken.insert(popped_labels.begin(), popped_labels.end());
+        total += popped_labels.size();
+      }
+      EXPECT_EQ(count, total);
+      EXPECT_EQ(count, taken.size());
+      EXPECT_TRUE(queue.empty());
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -11,6 +11,7 @@
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 namespace com {
   namespace dag_scheduler {
@@ -145,5 +146,29 @@ namespace com {
         ref_remains.as_string(), remains_check->get_uuid().as_string()
       );
     }
+
+    TEST_F(TestConcurrentTaskQueue, test_pop_highest_priority_first) {
+      ConcurrentTaskQueue queue;
+
+      const std::vector<std::pair<std::string, double>> pushed{
+        {"low_0", 1.0}, {"high", 3.0}, {"low_1", 1.0}, {"none", 0.0},
+        {"mid", 2.0}, {"low_2", 1.0}
+      };
+      for (const auto &next : pushed) {
+        std::vector<std::unique_ptr<TaskStage>> stages;
+        std::unique_ptr<Task> task_ptr(new Task(stages, next.first));
+        task_ptr->set_priority(next.second);
+        queue.push(std::move(task_ptr));
+      }
+
+      const std::vector<std::string> expected{"high",  "mid",   "low_0",
+                                              "low_1", "low_2", "none"};
+      for (const std::string &label : expected) {
+        std::unique_ptr<Task> popped;
+        ASSERT_TRUE(queue.try_pop(popped));
+        EXPECT_EQ(label, popped->label());
+      }
+      EXPECT_TRUE(queue.empty());
+    }
   } // namespace dag_scheduler
 } // namespace com
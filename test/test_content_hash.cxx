@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+
+#include "dag_scheduler/content_hash.h"
+
+#include <string>
+
+namespace com {
+  namespace dag_scheduler {
+    class TestContentHash : public ::testing::Test {
+    protected:
+      virtual void SetUp() {}
+
+      virtual void TearDown() {}
+    };
+
+    TEST_F(TestContentHash, fnv_1a) {
+      // Reference values of 64 bit FNV-1a.
+      EXPECT_EQ(0xcbf29ce484222325ull, ContentHash().value());
+      ContentHash hash;
+      hash.add("a", 1);
+      EXPECT_EQ(0xaf63dc4c8601ec8cull, hash.value());
+    }
+
+    TEST_F(TestContentHash, fields_keep_their_boundaries) {
+      ContentHash lhs;
+      lhs.add(std::string("ab"));
+      lhs.add(std::string("c"));
+      ContentHash rhs;
+      rhs.add(std::string("a"));
+      rhs.add(std::string("bc"));
+      EXPECT_NE(lhs.value(), rhs.value());
+
+      ContentHash same;
+      same.add(std::string("ab"));
+      same.add(std::string("c"));
+      EXPECT_EQ(lhs.value(), same.value());
+    }
+  } // namespace dag_scheduler
+} // namespace com
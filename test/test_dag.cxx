@@ -4,11 +4,14 @@
 
 #include "dag_scheduler/dag.h"
 #include "dag_scheduler/dag_algorithms.h"
+#include "dag_scheduler/dag_edge.h"
 #include "dag_scheduler/logged_class.hpp"
+#include "dag_scheduler/stop_watch.h"
 
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <chrono>
 #include <iostream>
 
 namespace com {
@@ -69,15 +72,13 @@ namespace com {
             get_dag().add_vertex(std::move(v));
             rapidjson::Document initial_input;
             get_generic_input(initial_input);
-            // TODO (mehoggan): Uncomment once
-            // override_initial_input_for_vertex_task is completed.
-            //
-            // get_dag().override_initial_input_for_vertex_task(
-            //   uuid_cloned, initial_input);
-            // std::weak_ptr<DAGVertex> v_weak =
-            //   get_dag().find_vertex_by_uuid(uuid_cloned);
-            // EXPECT_FALSE(v_weak.expired());
-            // ASSERT_TRUE(v_weak.lock()->get_task() != nullptr);
+            get_dag().override_initial_input_for_vertex_task(
+              uuid_cloned, initial_input
+            );
+            std::weak_ptr<DAGVertex> v_weak =
+              get_dag().find_vertex_by_uuid(uuid_cloned);
+            EXPECT_FALSE(v_weak.expired());
+            ASSERT_TRUE(v_weak.lock()->get_task() != nullptr);
             vertices_uuids.push_back(std::move(uuid_cloned));
           }
         );
@@ -776,6 +777,33 @@ namespace com {
       EXPECT_EQ(0ul, get_dag().vertex_count());
     }
 
+    TEST_F(TestDag, remove_vertex_drops_incomming_edges) {
+      std::vector<UUID> uuids;
+      for (const std::string label : {"a", "b", "c", "d"}) {
+        DAGVertex v(label);
+        uuids.push_back(UUID(v.get_uuid().as_string()));
+        get_dag().add_vertex(std::move(v));
+      }
+      // a -> c, b -> c, c -> d
+      ASSERT_TRUE(get_dag().connect_by_uuid(uuids[0], uuids[2]));
+      ASSERT_TRUE(get_dag().connect_by_uuid(uuids[1], uuids[2]));
+      ASSERT_TRUE(get_dag().connect_by_uuid(uuids[2], uuids[3]));
+      ASSERT_EQ(3ul, get_dag().edge_count());
+
+      std::shared_ptr<DAGVertex> a =
+        get_dag().find_vertex_by_uuid(uuids[0]).lock();
+      std::shared_ptr<DAGVertex> d =
+        get_dag().find_vertex_by_uuid(uuids[3]).lock();
+      ASSERT_TRUE(get_dag().remove_vertex_by_uuid(uuids[2]));
+
+      EXPECT_EQ(3ul, get_dag().vertex_count());
+      EXPECT_EQ(0ul, get_dag().edge_count());
+      EXPECT_EQ(0ul, a->edge_count());
+      EXPECT_TRUE(a->successors().empty());
+      EXPECT_EQ(0ul, d->incomming_edge_count());
+      EXPECT_TRUE(d->predecessors().empty());
+    }
+
     TEST_F(TestDag, remove_vertices_with_label) {
       fill_dag_default_with_tasks();
       DAG g_clone = get_dag().clone();
@@ -798,5 +826,509 @@ namespace com {
         EXPECT_EQ(0u, v->incomming_edge_count());
       });
     }
+
+    TEST_F(TestDag, override_initial_input_marks_dirty) {
+      std::vector<UUID> uuids = fill_dag_default_with_tasks();
+      EXPECT_EQ(uuids.size(), get_dag().dirty_vertices().size());
+      std::shared_ptr<DAGVertex> v =
+        get_dag().find_vertex_by_uuid(uuids[0]).lock();
+      std::string inputs;
+      v->task()->json_initial_inputs_str(inputs);
+      EXPECT_EQ(get_expected_input_str(), inputs);
+
+      DAG g_clone = get_dag().clone();
+      EXPECT_EQ(uuids.size(), g_clone.dirty_vertices().size());
+      get_dag().clear_dirty();
+      EXPECT_TRUE(get_dag().dirty_vertices().empty());
+      EXPECT_EQ(uuids.size(), g_clone.dirty_vertices().size());
+
+      EXPECT_FALSE(get_dag().mark_dirty(UUID()));
+      EXPECT_TRUE(get_dag().mark_dirty(uuids[0]));
+      EXPECT_TRUE(get_dag().mark_dirty(uuids[1]));
+      ASSERT_TRUE(get_dag().remove_vertex_by_uuid(uuids[0]));
+      std::vector<std::weak_ptr<DAGVertex>> dirty =
+        get_dag().dirty_vertices();
+      ASSERT_EQ(1u, dirty.size());
+      EXPECT_EQ(uuids[1], dirty[0].lock()->get_uuid());
+
+      get_dag().reset();
+      EXPECT_TRUE(get_dag().dirty_vertices().empty());
+    }
+
+    TEST_F(TestDag, remove_all_vertex_with_label_clears_dirty) {
+      std::vector<UUID> uuids;
+      for (const char *label : {"a", "a", "b"}) {
+        DAGVertex v(label);
+        uuids.push_back(UUID(v.get_uuid().as_string()));
+        ASSERT_TRUE(get_dag().add_vertex(std::move(v)));
+      }
+      for (const UUID &u : uuids) {
+        EXPECT_TRUE(get_dag().mark_dirty(u));
+      }
+
+      ASSERT_TRUE(get_dag().remove_all_vertex_with_label("a"));
+      ASSERT_EQ(1u, get_dag().dirty_.size());
+      EXPECT_EQ(1u, get_dag().dirty_.count(uuids[2]));
+    }
+
+    TEST_F(TestDag, structural_hash_is_cached) {
+      std::vector<DAGVertex> vertices_cloned = fill_dag_default();
+      ASSERT_TRUE(get_dag().connect_all_by_label("1", "2"));
+      ASSERT_TRUE(get_dag().connect_all_by_label("2", "3"));
+      const std::uint64_t hash = get_dag().structural_hash();
+      EXPECT_TRUE(get_dag().structural_hash_valid_);
+
+      // A copy carries the hash over.
+      DAG d_copy(get_dag());
+      EXPECT_TRUE(d_copy.structural_hash_valid_);
+      EXPECT_EQ(hash, d_copy.structural_hash());
+
+      // The same description built again hashes the same, UUIDs aside.
+      DAG rebuilt;
+      for (const DAGVertex &v : vertices_cloned) {
+        ASSERT_TRUE(rebuilt.add_vertex(DAGVertex(v.label())));
+      }
+      ASSERT_TRUE(rebuilt.connect_all_by_label("2", "3"));
+      ASSERT_TRUE(rebuilt.connect_all_by_label("1", "2"));
+      EXPECT_EQ(hash, rebuilt.structural_hash());
+      EXPECT_EQ(get_dag(), rebuilt);
+
+      // Titles are compared, and a hash collision is caught.
+      DAG titled("titled");
+      for (const DAGVertex &v : vertices_cloned) {
+        ASSERT_TRUE(titled.add_vertex(DAGVertex(v.label())));
+      }
+      ASSERT_TRUE(titled.connect_all_by_label("2", "3"));
+      ASSERT_TRUE(titled.connect_all_by_label("1", "2"));
+      EXPECT_NE(get_dag(), titled);
+      DAG collides;
+      for (const DAGVertex &v : vertices_cloned) {
+        ASSERT_TRUE(collides.add_vertex(DAGVertex(v.label() + "'")));
+      }
+      ASSERT_TRUE(collides.connect_all_by_label("2'", "3'"));
+      ASSERT_TRUE(collides.connect_all_by_label("1'", "2'"));
+      collides.structural_hash_ = hash;
+      collides.structural_hash_valid_ = true;
+      EXPECT_NE(get_dag(), collides);
+
+      ASSERT_TRUE(get_dag().connect_all_by_label("3", "5"));
+      EXPECT_FALSE(get_dag().structural_hash_valid_);
+      EXPECT_NE(get_dag(), rebuilt);
+      EXPECT_EQ(hash, d_copy.structural_hash());
+
+      get_dag().structural_hash();
+      EXPECT_TRUE(get_dag().mark_dirty(vertices_cloned[0].get_uuid()));
+      EXPECT_FALSE(get_dag().structural_hash_valid_);
+
+      get_dag().structural_hash();
+      ASSERT_TRUE(
+        get_dag().remove_vertex_by_uuid(vertices_cloned[10].get_uuid())
+      );
+      EXPECT_FALSE(get_dag().structural_hash_valid_);
+      EXPECT_NE(hash, get_dag().structural_hash());
+    }
+
+    TEST_F(TestDag, uuid_index_tracks_mutations) {
+      fill_dag_default();
+      std::vector<UUID> uuids;
+      get_dag().linear_traversal([&](std::shared_ptr<DAGVertex> v) {
+        uuids.push_back(UUID(v->get_uuid().as_string()));
+      });
+      ASSERT_EQ(11u, uuids.size());
+
+      DAG d_copy = get_dag().clone();
+      DAG d_to_move = get_dag().clone();
+      DAG d_moved(std::move(d_to_move));
+      for (const UUID &u : uuids) {
+        EXPECT_TRUE(get_dag().contains_vertex_by_uuid(u));
+        EXPECT_TRUE(d_copy.contains_vertex_by_uuid(u));
+        EXPECT_TRUE(d_moved.contains_vertex_by_uuid(u));
+        EXPECT_NE(
+          get_dag().find_vertex_by_uuid(u).lock(),
+          d_copy.find_vertex_by_uuid(u).lock()
+        );
+      }
+
+      ASSERT_TRUE(d_copy.remove_vertex_by_uuid(uuids[0]));
+      EXPECT_FALSE(d_copy.contains_vertex_by_uuid(uuids[0]));
+      EXPECT_FALSE(d_copy.remove_vertex_by_uuid(uuids[0]));
+      ASSERT_TRUE(d_copy.remove_all_vertex_with_label("2"));
+      EXPECT_EQ(7u, d_copy.vertex_count());
+      for (std::size_t i = 4; i < 7; ++i) {
+        EXPECT_FALSE(d_copy.contains_vertex_by_uuid(uuids[i]));
+      }
+      EXPECT_TRUE(d_copy.contains_vertex_by_uuid(uuids[1]));
+      EXPECT_TRUE(get_dag().contains_vertex_by_uuid(uuids[0]));
+
+      d_moved.reset();
+      for (const UUID &u : uuids) {
+        EXPECT_FALSE(d_moved.contains_vertex_by_uuid(u));
+        EXPECT_TRUE(d_moved.find_vertex_by_uuid(u).expired());
+      }
+
+      get_dag().reset();
+      EXPECT_EQ(0ul, get_dag().vertex_count());
+    }
+
+    TEST_F(TestDag, label_index) {
+      const std::size_t size = 3000;
+      const std::vector<std::string> labels{"load", "transform", "store"};
+      std::vector<UUID> uuids;
+      for (std::size_t i = 0; i < size; ++i) {
+        DAGVertex v(labels[i % labels.size()]);
+        uuids.push_back(UUID(v.get_uuid().as_string()));
+        get_dag().add_vertex(std::move(v));
+      }
+      EXPECT_EQ(labels.size(), get_dag().labels_.size());
+      EXPECT_TRUE(get_dag().contains_vertex_by_label("store"));
+      EXPECT_FALSE(get_dag().contains_vertex_by_label("missing"));
+      EXPECT_TRUE(get_dag().find_all_verticies_with_label("missing").empty());
+
+      // Vertices come back in the order they were added.
+      std::vector<std::weak_ptr<DAGVertex>> loads =
+        get_dag().find_all_verticies_with_label("load");
+      ASSERT_EQ(size / labels.size(), loads.size());
+      for (std::size_t i = 0; i < loads.size(); ++i) {
+        EXPECT_EQ(uuids[i * labels.size()], loads[i].lock()->get_uuid());
+      }
+
+      ASSERT_TRUE(get_dag().remove_vertex_by_uuid(uuids[0]));
+      EXPECT_EQ(
+        size / labels.size() - 1,
+        get_dag().find_all_verticies_with_label("load").size()
+      );
+
+      DAG d_copy = get_dag().clone();
+      EXPECT_EQ(
+        size / labels.size(),
+        d_copy.find_all_verticies_with_label("transform").size()
+      );
+
+      ASSERT_TRUE(get_dag().remove_all_vertex_with_label("transform"));
+      EXPECT_FALSE(get_dag().contains_vertex_by_label("transform"));
+      EXPECT_FALSE(get_dag().remove_all_vertex_with_label("transform"));
+      EXPECT_EQ(size - size / labels.size() - 1, get_dag().vertex_count());
+      EXPECT_FALSE(get_dag().contains_vertex_by_uuid(uuids[1]));
+      EXPECT_TRUE(get_dag().contains_vertex_by_uuid(uuids[2]));
+      EXPECT_TRUE(d_copy.contains_vertex_by_label("transform"));
+
+      // A label that comes back after every vertex with it was removed
+      // reuses its id.
+      get_dag().add_vertex(DAGVertex("transform"));
+      EXPECT_EQ(labels.size(), get_dag().labels_.size());
+      EXPECT_EQ(
+        1u, get_dag().find_all_verticies_with_label("transform").size()
+      );
+
+      get_dag().reset();
+      EXPECT_EQ(0u, get_dag().labels_.size());
+      EXPECT_FALSE(get_dag().contains_vertex_by_label("store"));
+    }
+
+    TEST_F(TestDag, connect_maintains_topological_order) {
+      auto expect_order_valid = [](DAG &d) {
+        EXPECT_EQ(d.vertex_count(), d.topological_index_.size());
+        d.linear_traversal([&](std::shared_ptr<DAGVertex> v) {
+          v->visit_all_edges([&](const DAGEdge &e) {
+            std::shared_ptr<DAGVertex> next =
+              const_cast<DAGEdge &>(e).get_connection().lock();
+            if (next != nullptr) {
+              EXPECT_LT(
+                d.topological_index_.at(v.get()),
+                d.topological_index_.at(next.get())
+              );
+            }
+          });
+        });
+      };
+
+      const std::size_t size = 64;
+      std::vector<UUID> uuids;
+      for (std::size_t i = 0; i < size; ++i) {
+        DAGVertex v(std::to_string(i));
+        uuids.push_back(UUID(v.get_uuid().as_string()));
+        get_dag().add_vertex(std::move(v));
+      }
+
+      // Each edge points backwards relative to insertion order, so every
+      // connect has to move part of the order.
+      for (std::size_t i = 1; i < size; ++i) {
+        EXPECT_FALSE(get_dag().connection_would_make_cyclic_by_uuid(
+          uuids[i], uuids[i - 1]
+        ));
+        EXPECT_TRUE(get_dag().connect_by_uuid(uuids[i], uuids[i - 1]));
+      }
+      expect_order_valid(get_dag());
+
+      EXPECT_TRUE(get_dag().connection_would_make_cyclic_by_uuid(
+        uuids[0], uuids[size - 1]
+      ));
+      EXPECT_THROW(
+        get_dag().connect_by_uuid(uuids[0], uuids[size - 1]),
+        DAG::DAGException
+      );
+      EXPECT_EQ(size - 1, get_dag().edge_count());
+
+      DAG d_copy = get_dag().clone();
+      expect_order_valid(d_copy);
+      EXPECT_TRUE(
+        d_copy.connection_would_make_cyclic_by_uuid(uuids[0], uuids[1])
+      );
+
+      // Breaking the chain in the middle lets the halves be joined the
+      // other way round.
+      ASSERT_TRUE(d_copy.remove_vertex_by_uuid(uuids[size / 2]));
+      EXPECT_FALSE(d_copy.connection_would_make_cyclic_by_uuid(
+        uuids[0], uuids[size - 1]
+      ));
+      EXPECT_TRUE(d_copy.connect_by_uuid(uuids[0], uuids[size - 1]));
+      expect_order_valid(d_copy);
+
+      get_dag().reset();
+      EXPECT_TRUE(get_dag().topological_order_.empty());
+      EXPECT_TRUE(get_dag().topological_index_.empty());
+    }
+
+    TEST_F(TestDag, bulk_load) {
+      const std::size_t size = 1000;
+      std::vector<DAGVertex> vertices;
+      std::vector<std::string> uuids;
+      for (std::size_t i = 0; i < size; ++i) {
+        vertices.emplace_back(std::to_string(i % 10));
+        uuids.push_back(vertices.back().get_uuid().as_string());
+      }
+      // A chain listed back to front plus a fan out from the head.
+      std::vector<std::pair<UUID, UUID>> edges;
+      for (std::size_t i = size - 1; i > 0; --i) {
+        edges.emplace_back(UUID(uuids[i - 1]), UUID(uuids[i]));
+      }
+      for (std::size_t i = 2; i < size; i += 7) {
+        edges.emplace_back(UUID(uuids[0]), UUID(uuids[i]));
+      }
+
+      EXPECT_TRUE(get_dag().bulk_load(std::move(vertices), edges));
+      auto find = [&](std::size_t i) {
+        return get_dag().find_vertex_by_uuid(UUID(uuids[i])).lock();
+      };
+      EXPECT_EQ(size, get_dag().vertex_count());
+      EXPECT_EQ(edges.size(), get_dag().edge_count());
+      EXPECT_TRUE(get_dag().are_connected(*find(0), *find(1)));
+      EXPECT_TRUE(get_dag().are_connected(*find(0), *find(9)));
+      EXPECT_EQ(0ul, find(0)->incomming_edge_count());
+      EXPECT_EQ(2ul, find(9)->incomming_edge_count());
+      for (std::size_t i = 1; i < size; ++i) {
+        EXPECT_LT(
+          get_dag().topological_index_.at(find(i - 1).get()),
+          get_dag().topological_index_.at(find(i).get())
+        );
+      }
+
+      // Closing the chain through a new vertex must be rejected without
+      // touching what is already loaded.
+      std::vector<DAGVertex> more;
+      more.emplace_back("closer");
+      std::string closer = more.back().get_uuid().as_string();
+      std::vector<std::pair<UUID, UUID>> cyclic;
+      cyclic.emplace_back(UUID(uuids[size - 1]), UUID(closer));
+      cyclic.emplace_back(UUID(closer), UUID(uuids[0]));
+      EXPECT_THROW(
+        get_dag().bulk_load(std::move(more), cyclic), DAG::DAGException
+      );
+      EXPECT_EQ(size, get_dag().vertex_count());
+      EXPECT_EQ(edges.size(), get_dag().edge_count());
+      EXPECT_FALSE(get_dag().contains_vertex_by_uuid(UUID(closer)));
+
+      // Duplicates and dangling edges are skipped and reported.
+      std::vector<DAGVertex> dupes;
+      dupes.emplace_back("dupe", nullptr, UUID(uuids[0]));
+      dupes.emplace_back("fresh");
+      std::string fresh = dupes.back().get_uuid().as_string();
+      std::vector<std::pair<UUID, UUID>> partial;
+      partial.emplace_back(UUID(uuids[size - 1]), UUID(fresh));
+      partial.emplace_back(UUID(fresh), UUID());
+      EXPECT_FALSE(get_dag().bulk_load(std::move(dupes), partial));
+      EXPECT_EQ(size + 1, get_dag().vertex_count());
+      EXPECT_EQ(edges.size() + 1, get_dag().edge_count());
+      EXPECT_FALSE(get_dag().connection_would_make_cyclic_by_uuid(
+        UUID(uuids[0]), UUID(fresh)
+      ));
+      EXPECT_TRUE(get_dag().connection_would_make_cyclic_by_uuid(
+        UUID(fresh), UUID(uuids[0])
+      ));
+    }
+
+    TEST_F(TestDag, bulk_load_reports_duplicate_edges) {
+      std::vector<DAGVertex> vertices;
+      vertices.emplace_back("a");
+      vertices.emplace_back("b");
+      const UUID a(vertices[0].get_uuid().as_string());
+      const UUID b(vertices[1].get_uuid().as_string());
+      std::vector<std::pair<UUID, UUID>> edges;
+      edges.emplace_back(UUID(a.as_string()), UUID(b.as_string()));
+      edges.emplace_back(UUID(a.as_string()), UUID(b.as_string()));
+      EXPECT_FALSE(get_dag().bulk_load(std::move(vertices), edges));
+      EXPECT_EQ(2u, get_dag().vertex_count());
+      EXPECT_EQ(1u, get_dag().edge_count());
+
+      // Drawing it again is a duplicate of the one already in the graph.
+      edges.pop_back();
+      EXPECT_FALSE(get_dag().bulk_load(std::vector<DAGVertex>(), edges));
+      EXPECT_EQ(1u, get_dag().edge_count());
+    }
+
+    TEST_F(TestDag, find_vertex_by_uuid_resolves_every_uuid) {
+      const std::size_t size = 8000;
+      std::vector<UUID> uuids;
+      uuids.reserve(size);
+      for (std::size_t i = 0; i < size; ++i) {
+        DAGVertex v(std::to_string(i));
+        uuids.push_back(UUID(v.get_uuid().as_string()));
+        get_dag().add_vertex(std::move(v));
+      }
+      ASSERT_EQ(size, get_dag().vertex_count());
+
+      for (std::size_t i = 0; i < size; ++i) {
+        std::shared_ptr<DAGVertex> found =
+          get_dag().find_vertex_by_uuid(uuids[i]).lock();
+        ASSERT_NE(nullptr, found);
+        EXPECT_EQ(std::to_string(i), found->label());
+      }
+      EXPECT_TRUE(get_dag().find_vertex_by_uuid(UUID()).expired());
+    }
+
+    TEST_F(TestDag, find_vertex_by_uuid_survives_vertex_assignment) {
+      DAG d;
+      DAGVertex a("a");
+      const UUID a_uuid(a.get_uuid().as_string());
+      ASSERT_TRUE(d.add_vertex(std::move(a)));
+      DAGVertex b("b");
+      const UUID b_uuid(b.get_uuid().as_string());
+      ASSERT_TRUE(d.add_vertex(std::move(b)));
+
+      // Rewrites the UUID of the indexed vertex in place.
+      DAGVertex other("other");
+      *d.find_vertex_by_uuid(a_uuid).lock() = std::move(other);
+
+      // Enough more that the index rehashes every key.
+      std::vector<UUID> uuids;
+      for (std::size_t i = 0; i < 1000; ++i) {
+        DAGVertex v(std::to_string(i));
+        uuids.push_back(UUID(v.get_uuid().as_string()));
+        ASSERT_TRUE(d.add_vertex(std::move(v)));
+      }
+
+      // Still found by the UUID it was indexed under.
+      std::shared_ptr<DAGVertex> found = d.find_vertex_by_uuid(a_uuid).lock();
+      ASSERT_NE(nullptr, found);
+      EXPECT_EQ("other", found->label());
+      found = d.find_vertex_by_uuid(b_uuid).lock();
+      ASSERT_NE(nullptr, found);
+      EXPECT_EQ("b", found->label());
+      for (std::size_t i = 0; i < uuids.size(); ++i) {
+        found = d.find_vertex_by_uuid(uuids[i]).lock();
+        ASSERT_NE(nullptr, found);
+        EXPECT_EQ(std::to_string(i), found->label());
+      }
+    }
+
+    TEST_F(TestDag, memory_per_vertex_report) {
+      const std::size_t size = 10000;
+      std::vector<DAGVertex> vertices;
+      std::vector<std::pair<UUID, UUID>> edges;
+      vertices.reserve(size);
+      for (std::size_t i = 0; i < size; ++i) {
+        vertices.emplace_back(std::to_string(i));
+        // Every vertex after the first two depends on the two before it.
+        if (i >= 2) {
+          for (std::size_t back : {1ul, 2ul}) {
+            edges.emplace_back(
+              UUID(vertices[i - back].get_uuid().as_string()),
+              UUID(vertices[i].get_uuid().as_string())
+            );
+          }
+        }
+      }
+      ASSERT_TRUE(get_dag().bulk_load(std::move(vertices), edges));
+      ASSERT_EQ(size, get_dag().vertex_count());
+      ASSERT_EQ(edges.size(), get_dag().edge_count());
+
+      DAGMemoryPool::Stats stats = get_dag().memory_stats();
+      const double bytes_per_vertex =
+        static_cast<double>(stats.bytes_in_use) / static_cast<double>(size);
+      Logging::info(
+        LOG_TAG, "memory per vertex:", bytes_per_vertex,
+        "bytes pooled (sizeof(DAGVertex)=", sizeof(DAGVertex),
+        "sizeof(DAGEdge)=", sizeof(DAGEdge), ") over", stats.slab_count,
+        "slabs,", stats.bytes_reserved, "bytes reserved for", size,
+        "vertices and", edges.size(), "edges"
+      );
+      EXPECT_EQ(size + edges.size(), stats.blocks_in_use);
+      // Each vertex shares its block with a shared_ptr control block and
+      // each edge is a block of its own, so anything past that is waste.
+      const std::size_t block_overhead = 2 * alignof(std::max_align_t) + 32;
+      EXPECT_LE(
+        stats.bytes_in_use,
+        size * (sizeof(DAGVertex) + block_overhead) +
+          edges.size() * (sizeof(DAGEdge) + alignof(std::max_align_t))
+      );
+      EXPECT_LT(stats.bytes_reserved, stats.bytes_in_use * 11 / 10);
+
+      // A vertex held past reset keeps its memory; everything else goes.
+      std::shared_ptr<DAGVertex> kept = get_dag().get_vertex_at(size / 2);
+      get_dag().reset();
+      stats = get_dag().memory_stats();
+      EXPECT_EQ(0u, stats.blocks_in_use);
+      EXPECT_EQ(0u, stats.bytes_reserved);
+      EXPECT_EQ(std::to_string(size / 2), kept->label());
+      EXPECT_EQ(2u, kept->edge_count());
+    }
+
+    TEST_F(TestDag, clone_shares_tasks) {
+      const std::size_t size = 1000;
+      std::vector<DAGVertex> vertices;
+      std::vector<std::pair<UUID, UUID>> edges;
+      vertices.reserve(size);
+      for (std::size_t i = 0; i < size; ++i) {
+        vertices.emplace_back(
+          std::to_string(i),
+          std::make_unique<TestTaskImpl>("Task " + std::to_string(i))
+        );
+        if (i >= 1) {
+          edges.emplace_back(
+            UUID(vertices[i - 1].get_uuid().as_string()),
+            UUID(vertices[i].get_uuid().as_string())
+          );
+        }
+      }
+      ASSERT_TRUE(get_dag().bulk_load(std::move(vertices), edges));
+
+      StopWatch sw(
+        LogTag(__FUNCTION__), "clone size=" + std::to_string(size)
+      );
+      DAG d_clone = get_dag().clone();
+      sw.stop();
+      ASSERT_EQ(size, d_clone.vertex_count());
+      EXPECT_EQ(edges.size(), d_clone.edge_count());
+      EXPECT_EQ(d_clone.topological_order_.size(), size);
+      for (std::size_t i = 0; i < size; ++i) {
+        std::shared_ptr<DAGVertex> orig = get_dag().get_vertex_at(i);
+        std::shared_ptr<DAGVertex> copy = d_clone.get_vertex_at(i);
+        ASSERT_NE(orig, copy);
+        EXPECT_EQ(orig->get_uuid(), copy->get_uuid());
+        EXPECT_EQ(orig->task(), copy->task());
+        EXPECT_EQ(copy.get(), d_clone.topological_order_[i]);
+      }
+
+      // Asking for a Task it could change gives the clone its own copy and
+      // leaves the original alone.
+      std::shared_ptr<DAGVertex> orig = get_dag().get_vertex_at(0);
+      std::shared_ptr<DAGVertex> copy = d_clone.get_vertex_at(0);
+      const Task *shared = orig->task();
+      ASSERT_NE(nullptr, copy->get_task());
+      EXPECT_NE(shared, copy->task());
+      EXPECT_EQ(shared, orig->task());
+      EXPECT_EQ(shared->label(), copy->task()->label());
+      EXPECT_EQ(shared, orig->get_task().get());
+    }
   } // namespace dag_scheduler
 } // namespace com
@@ -3,7 +3,11 @@
 #include "dag_scheduler/dag_algorithms.h"
 #include "dag_scheduler/logging.h"
 
+#include <algorithm>
 #include <iostream>
+#include <random>
+#include <string>
+#include <utility>
 
 namespace com {
   namespace dag_scheduler {
@@ -169,6 +173,267 @@ namespace com {
       get_dag().reset();
     }
 
+    TEST_F(TestDagAlgorithms, topological_sort_leaves_graph_untouched) {
+      std::vector<DAGVertex> vertices = fill_dag_default();
+
+      get_dag().connect(vertices[0], vertices[1]); // a -> b
+      get_dag().connect(vertices[0], vertices[2]); // a -> c
+      get_dag().connect(vertices[1], vertices[3]); // b -> d
+      get_dag().connect(vertices[2], vertices[3]); // c -> d
+      get_dag().connect(vertices[3], vertices[4]); // d -> e
+
+      DAG g_clone = get_dag().clone();
+      std::list<DAGVertex> sorted_vertices;
+      EXPECT_FALSE(dag_topological_sort(get_dag(), sorted_vertices));
+      EXPECT_EQ(get_dag().vertex_count(), sorted_vertices.size());
+      EXPECT_EQ(g_clone, get_dag());
+      EXPECT_EQ(5u, get_dag().edge_count());
+      EXPECT_TRUE(get_dag().are_connected(vertices[3], vertices[4]));
+
+      std::vector<std::shared_ptr<DAGVertex>> order;
+      TopologicalSorter sorter;
+      ASSERT_TRUE(sorter.sort(get_dag(), order));
+      ASSERT_EQ(get_dag().vertex_count(), order.size());
+      EXPECT_EQ(
+        get_dag().find_vertex(vertices[0]).lock().get(), order[0].get()
+      );
+      // Sorting leaves the graph as it was: equality compares the title,
+      // the counts, the structural hash and then the shape.
+      EXPECT_EQ(g_clone, get_dag());
+
+      get_dag().reset();
+    }
+
+    TEST_F(TestDagAlgorithms, topological_sorter_reuse_and_cycle) {
+      std::vector<DAGVertex> vertices = fill_dag_default();
+
+      get_dag().connect(vertices[0], vertices[1]); // a -> b
+      get_dag().connect(vertices[1], vertices[2]); // b -> c
+      get_dag().connect(vertices[2], vertices[3]); // c -> d
+
+      TopologicalSorter sorter;
+      std::vector<FrozenDAG::Index> order;
+      {
+        FrozenDAG plan(get_dag());
+        ASSERT_TRUE(sorter.sort(plan, order));
+        ASSERT_EQ(plan.vertex_count(), order.size());
+        std::vector<std::size_t> position(order.size());
+        for (std::size_t i = 0; i < order.size(); ++i) {
+          position[static_cast<std::size_t>(order[i])] = i;
+        }
+        for (FrozenDAG::Index u = 0;
+             u < static_cast<FrozenDAG::Index>(plan.vertex_count()); ++u) {
+          for (FrozenDAG::Index v : plan.successors(u)) {
+            EXPECT_LT(
+              position[static_cast<std::size_t>(u)],
+              position[static_cast<std::size_t>(v)]
+            );
+          }
+        }
+        // Sorting again gives the same order from the same scratch space.
+        std::vector<FrozenDAG::Index> again;
+        ASSERT_TRUE(sorter.sort(plan, again));
+        EXPECT_EQ(order, again);
+      }
+
+      // d -> a, added behind the DAG's back, closes a -> b -> c -> d.
+      std::weak_ptr<DAGVertex> d = get_dag().find_vertex(vertices[3]);
+      std::weak_ptr<DAGVertex> a = get_dag().find_vertex(vertices[0]);
+      d.lock()->connect(a.lock());
+      {
+        FrozenDAG plan(get_dag());
+        EXPECT_FALSE(sorter.sort(plan, order));
+        EXPECT_EQ(plan.vertex_count() - 4, order.size());
+      }
+      std::list<DAGVertex> sorted_vertices;
+      EXPECT_TRUE(dag_topological_sort(get_dag(), sorted_vertices));
+      EXPECT_EQ(get_dag().vertex_count() - 4, sorted_vertices.size());
+
+      get_dag().reset();
+    }
+
+    TEST_F(TestDagAlgorithms, upward_ranks) {
+      std::vector<DAGVertex> vertices = fill_dag_default();
+
+      get_dag().connect(vertices[0], vertices[1]); // a -> b
+      get_dag().connect(vertices[0], vertices[2]); // a -> c
+      get_dag().connect(vertices[1], vertices[3]); // b -> d
+      get_dag().connect(vertices[2], vertices[3]); // c -> d
+
+      FrozenDAG plan(get_dag());
+      std::vector<double> costs(plan.vertex_count(), 1.0);
+      costs[static_cast<std::size_t>(plan.index_of(vertices[2].get_uuid()))] =
+        4.0;
+      std::vector<double> ranks;
+      ASSERT_TRUE(upward_ranks(plan, costs, ranks));
+      auto rank_of = [&](const DAGVertex &v) {
+        return ranks[static_cast<std::size_t>(plan.index_of(v.get_uuid()))];
+      };
+      EXPECT_DOUBLE_EQ(6.0, rank_of(vertices[0]));
+      EXPECT_DOUBLE_EQ(2.0, rank_of(vertices[1]));
+      EXPECT_DOUBLE_EQ(5.0, rank_of(vertices[2]));
+      EXPECT_DOUBLE_EQ(1.0, rank_of(vertices[3]));
+      EXPECT_DOUBLE_EQ(1.0, rank_of(vertices[9]));
+
+      std::weak_ptr<DAGVertex> d = get_dag().find_vertex(vertices[3]);
+      std::weak_ptr<DAGVertex> a = get_dag().find_vertex(vertices[0]);
+      d.lock()->connect(a.lock());
+      FrozenDAG cyclic(get_dag());
+      EXPECT_FALSE(upward_ranks(cyclic, costs, ranks));
+      EXPECT_TRUE(ranks.empty());
+
+      get_dag().reset();
+    }
+
+    TEST_F(TestDagAlgorithms, dag_levels) {
+      std::vector<DAGVertex> vertices = fill_dag_default();
+
+      get_dag().connect(vertices[0], vertices[1]); // a -> b
+      get_dag().connect(vertices[1], vertices[2]); // b -> c
+      get_dag().connect(vertices[0], vertices[2]); // a -> c
+      get_dag().connect(vertices[3], vertices[2]); // d -> c
+
+      FrozenDAG plan(get_dag());
+      std::vector<FrozenDAG::Index> levels;
+      ASSERT_TRUE(dag_levels(plan, levels));
+      auto level_of = [&](const DAGVertex &v) {
+        return levels[static_cast<std::size_t>(plan.index_of(v.get_uuid()))];
+      };
+      EXPECT_EQ(0, level_of(vertices[0]));
+      EXPECT_EQ(1, level_of(vertices[1]));
+      EXPECT_EQ(2, level_of(vertices[2]));
+      EXPECT_EQ(0, level_of(vertices[3]));
+      EXPECT_EQ(0, level_of(vertices[9]));
+
+      std::weak_ptr<DAGVertex> c = get_dag().find_vertex(vertices[2]);
+      std::weak_ptr<DAGVertex> a = get_dag().find_vertex(vertices[0]);
+      c.lock()->connect(a.lock());
+      FrozenDAG cyclic(get_dag());
+      EXPECT_FALSE(dag_levels(cyclic, levels, 4));
+      EXPECT_TRUE(levels.empty());
+
+      get_dag().reset();
+    }
+
+    TEST_F(TestDagAlgorithms, parallel_levels_and_ranks_match_serial) {
+      // Wide enough that every frontier is split between the threads.
+      const std::size_t size = 20000;
+      std::mt19937 gen(7);
+      std::uniform_real_distribution<double> cost(1.0, 10.0);
+      std::vector<DAGVertex> vertices;
+      std::vector<std::pair<UUID, UUID>> edges;
+      std::vector<double> costs;
+      for (std::size_t i = 0; i < size; ++i) {
+        vertices.emplace_back(std::to_string(i));
+        costs.push_back(cost(gen));
+        std::size_t picked = i;
+        for (std::size_t e = 0; i >= 4000 && e < 2; ++e) {
+          std::uniform_int_distribution<std::size_t> pick(i - 4000, i - 1);
+          const std::size_t from = pick(gen);
+          // The same one twice would be a duplicate edge.
+          if (from != picked) {
+            picked = from;
+            edges.emplace_back(
+              UUID(vertices[from].get_uuid().as_string()),
+              UUID(vertices[i].get_uuid().as_string())
+            );
+          }
+        }
+      }
+      ASSERT_TRUE(get_dag().bulk_load(std::move(vertices), edges));
+      FrozenDAG plan(get_dag());
+
+      std::vector<FrozenDAG::Index> order;
+      ASSERT_TRUE(TopologicalSorter().sort(plan, order));
+      std::vector<FrozenDAG::Index> expected(size, 0);
+      for (FrozenDAG::Index v : order) {
+        for (FrozenDAG::Index s : plan.successors(v)) {
+          FrozenDAG::Index &level = expected[static_cast<std::size_t>(s)];
+          level = std::max(level, expected[static_cast<std::size_t>(v)] + 1);
+        }
+      }
+
+      std::vector<FrozenDAG::Index> serial_levels;
+      std::vector<FrozenDAG::Index> parallel_levels;
+      ASSERT_TRUE(dag_levels(plan, serial_levels, 1));
+      ASSERT_TRUE(dag_levels(plan, parallel_levels, 4));
+      EXPECT_EQ(expected, serial_levels);
+      EXPECT_EQ(expected, parallel_levels);
+
+      std::vector<double> serial_ranks;
+      std::vector<double> parallel_ranks;
+      ASSERT_TRUE(upward_ranks(plan, costs, serial_ranks, 1));
+      ASSERT_TRUE(upward_ranks(plan, costs, parallel_ranks, 4));
+      EXPECT_EQ(serial_ranks, parallel_ranks);
+
+      get_dag().reset();
+    }
+
+    TEST_F(TestDagAlgorithms, downstream_closure) {
+      std::vector<DAGVertex> vertices = fill_dag_default();
+
+      get_dag().connect(vertices[0], vertices[1]); // a -> b
+      get_dag().connect(vertices[1], vertices[2]); // b -> c
+      get_dag().connect(vertices[0], vertices[3]); // a -> d
+      get_dag().connect(vertices[4], vertices[2]); // e -> c
+
+      FrozenDAG plan(get_dag());
+      auto index_of = [&](const DAGVertex &v) {
+        return plan.index_of(v.get_uuid());
+      };
+      std::vector<bool> closure;
+      EXPECT_EQ(
+        3u, downstream_closure(
+              plan, {index_of(vertices[1]), index_of(vertices[4])}, closure
+            )
+      );
+      ASSERT_EQ(plan.vertex_count(), closure.size());
+      EXPECT_FALSE(closure[static_cast<std::size_t>(index_of(vertices[0]))]);
+      EXPECT_TRUE(closure[static_cast<std::size_t>(index_of(vertices[1]))]);
+      EXPECT_TRUE(closure[static_cast<std::size_t>(index_of(vertices[2]))]);
+      EXPECT_FALSE(closure[static_cast<std::size_t>(index_of(vertices[3]))]);
+      EXPECT_TRUE(closure[static_cast<std::size_t>(index_of(vertices[4]))]);
+
+      EXPECT_EQ(0u, downstream_closure(plan, {}, closure));
+
+      get_dag().reset();
+    }
+
+    TEST_F(TestDagAlgorithms, chain_links) {
+      std::vector<DAGVertex> vertices = fill_dag_default();
+
+      get_dag().connect(vertices[0], vertices[1]); // a -> b
+      get_dag().connect(vertices[1], vertices[2]); // b -> c
+      get_dag().connect(vertices[2], vertices[3]); // c -> d
+      get_dag().connect(vertices[2], vertices[4]); // c -> e
+      get_dag().connect(vertices[3], vertices[5]); // d -> f
+      get_dag().connect(vertices[4], vertices[5]); // e -> f
+      get_dag().connect(vertices[5], vertices[6]); // f -> g
+
+      FrozenDAG plan(get_dag());
+      auto index_of = [&](const DAGVertex &v) {
+        return plan.index_of(v.get_uuid());
+      };
+      auto next_of = [&](const std::vector<FrozenDAG::Index> &next,
+                         const DAGVertex &v) {
+        return next[static_cast<std::size_t>(index_of(v))];
+      };
+      std::vector<FrozenDAG::Index> next;
+      EXPECT_EQ(3u, chain_links(plan, next));
+      ASSERT_EQ(plan.vertex_count(), next.size());
+      EXPECT_EQ(index_of(vertices[1]), next_of(next, vertices[0]));
+      EXPECT_EQ(index_of(vertices[2]), next_of(next, vertices[1]));
+      // c branches and f joins, so neither is linked across.
+      EXPECT_EQ(FrozenDAG::npos, next_of(next, vertices[2]));
+      EXPECT_EQ(FrozenDAG::npos, next_of(next, vertices[3]));
+      EXPECT_EQ(FrozenDAG::npos, next_of(next, vertices[4]));
+      EXPECT_EQ(index_of(vertices[6]), next_of(next, vertices[5]));
+      EXPECT_EQ(FrozenDAG::npos, next_of(next, vertices[6]));
+      EXPECT_EQ(FrozenDAG::npos, next_of(next, vertices[7]));
+
+      get_dag().reset();
+    }
+
     TEST_F(TestDagAlgorithms, process_dag) {
       {
         std::vector<DAGVertex> vertices = fill_dag_default();
@@ -0,0 +1,1172 @@
+#include <gtest/gtest.h>
+
+#include "dag_scheduler/concurrent_task_queue.h"
+#include "dag_scheduler/dag.h"
+#include "dag_scheduler/dag_algorithms.h"
+#include "dag_scheduler/dag_execution.h"
+#include "dag_scheduler/fan_out_task_stage.h"
+#include "dag_scheduler/logging.h"
+#include "dag_scheduler/task.h"
+#include "dag_scheduler/task_cost_model.h"
+#include "dag_scheduler/task_scheduler.h"
+#include "dag_scheduler/task_stage.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace com {
+  namespace dag_scheduler {
+    namespace detail {
+      // Every stage run, in order, as "+label" when it starts and "-label"
+      // when it ends.
+      class RunLog {
+      public:
+        void add(const std::string &event) {
+          std::lock_guard<std::mutex> lock(lock_);
+          events_.push_back(event);
+          threads_[event] = std::this_thread::get_id();
+        }
+
+        // The thread event was last logged from.
+        std::thread::id thread_of(const std::string &event) {
+          std::lock_guard<std::mutex> lock(lock_);
+          return threads_[event];
+        }
+
+        std::size_t at(const std::string &event) {
+          std::lock_guard<std::mutex> lock(lock_);
+          return static_cast<std::size_t>(
+            std::find(events_.begin(), events_.end(), event) - events_.begin()
+          );
+        }
+
+        std::size_t size() {
+          std::lock_guard<std::mutex> lock(lock_);
+          return events_.size();
+        }
+
+      private:
+        std::mutex lock_;
+        std::vector<std::string> events_;
+        std::map<std::string, std::thread::id> threads_;
+      };
+
+      class LoggingStage : public TaskStage {
+      public:
+        LoggingStage(
+          const std::string &label, std::shared_ptr<RunLog> log,
+          const std::chrono::milliseconds &run_time, bool succeed
+        ) :
+          TaskStage(label), log_(log), run_time_(run_time),
+          succeed_(succeed) {}
+
+        virtual bool run() override {
+          log_->add("+" + label_);
+          std::this_thread::sleep_for(run_time_);
+          log_->add("-" + label_);
+          return succeed_;
+        }
+
+        virtual bool is_running() const override { return false; }
+
+        virtual bool end() override { return true; }
+
+        virtual void cleanup() override {}
+
+        virtual std::unique_ptr<TaskStage> clone() const override {
+          return std::make_unique<LoggingStage>(
+            label_, log_, run_time_, succeed_
+          );
+        }
+
+      private:
+        std::shared_ptr<RunLog> log_;
+        std::chrono::milliseconds run_time_;
+        bool succeed_;
+      };
+
+      // Picks a branch when run, which conditions read off the Task that
+      // ran, see chose.
+      class ChoosingStage : public TaskStage {
+      public:
+        ChoosingStage(
+          const std::string &label, std::shared_ptr<RunLog> log,
+          const std::string &choice
+        ) :
+          TaskStage(label), log_(log), choice_(choice) {}
+
+        virtual bool run() override {
+          log_->add("+" + label_);
+          chosen_ = choice_;
+          log_->add("-" + label_);
+          return true;
+        }
+
+        virtual bool is_running() const override { return false; }
+
+        virtual bool end() override { return true; }
+
+        virtual void cleanup() override {}
+
+        virtual std::unique_ptr<TaskStage> clone() const override {
+          return std::make_unique<ChoosingStage>(label_, log_, choice_);
+        }
+
+        static bool chose(const Task &upstream, const std::string &branch) {
+          bool ret = false;
+          upstream.visit_stages([&](const TaskStage &stage) {
+            const ChoosingStage *choosing =
+              dynamic_cast<const ChoosingStage *>(&stage);
+            ret = ret || (choosing != nullptr && choosing->chosen_ == branch);
+          });
+          return ret;
+        }
+
+      private:
+        std::shared_ptr<RunLog> log_;
+        std::string choice_;
+        std::string chosen_;
+      };
+
+      // Kills the Task with uuid when run, logging like LoggingStage.
+      class KillingStage : public TaskStage {
+      public:
+        KillingStage(
+          const std::string &label, std::shared_ptr<RunLog> log,
+          TaskScheduler &scheduler, const std::string &uuid
+        ) :
+          TaskStage(label), log_(log), scheduler_(scheduler), uuid_(uuid) {}
+
+        virtual bool run() override {
+          log_->add("+" + label_);
+          const bool ret = scheduler_.kill_task(UUID(uuid_));
+          log_->add("-" + label_);
+          return ret;
+        }
+
+        virtual bool is_running() const override { return false; }
+
+        virtual bool end() override { return true; }
+
+        virtual void cleanup() override {}
+
+        virtual std::unique_ptr<TaskStage> clone() const override {
+          return std::make_unique<KillingStage>(
+            label_, log_, scheduler_, uuid_
+          );
+        }
+
+      private:
+        std::shared_ptr<RunLog> log_;
+        TaskScheduler &scheduler_;
+        std::string uuid_;
+      };
+
+      // Emits a child per label in children, logging like LoggingStage. A
+      // child whose label starts with '~' is not joined, one that starts
+      // with '!' fails. With grandchildren, each child fans out in turn.
+      class FanningStage : public FanOutTaskStage {
+      public:
+        FanningStage(
+          const std::string &label, std::shared_ptr<RunLog> log,
+          const std::vector<std::string> &children,
+          const std::vector<std::string> &grandchildren =
+            std::vector<std::string>()
+        ) :
+          FanOutTaskStage(label), log_(log), children_(children),
+          grandchildren_(grandchildren) {}
+
+        virtual bool run() override {
+          bool ret = true;
+          log_->add("+" + label_);
+          for (const std::string &child : children_) {
+            std::vector<std::unique_ptr<TaskStage>> stages;
+            if (grandchildren_.empty()) {
+              stages.push_back(std::make_unique<LoggingStage>(
+                child, log_, std::chrono::milliseconds(20), child[0] != '!'
+              ));
+            } else {
+              std::vector<std::string> names;
+              for (const std::string &grandchild : grandchildren_) {
+                names.push_back(child + "." + grandchild);
+              }
+              stages.push_back(
+                std::make_unique<FanningStage>(child, log_, names)
+              );
+            }
+            ret = emit(std::make_unique<Task>(stages, child), child[0] != '~')
+                  && ret;
+          }
+          log_->add("-" + label_);
+          return ret;
+        }
+
+        virtual bool is_running() const override { return false; }
+
+        virtual bool end() override { return true; }
+
+        virtual void cleanup() override {}
+
+        virtual std::unique_ptr<TaskStage> clone() const override {
+          return std::make_unique<FanningStage>(
+            label_, log_, children_, grandchildren_
+          );
+        }
+
+      private:
+        std::shared_ptr<RunLog> log_;
+        std::vector<std::string> children_;
+        std::vector<std::string> grandchildren_;
+      };
+
+      // Runs plan on workers the way TaskScheduler dispatches, with a
+      // ConcurrentTaskQueue as the ready set, but in simulated time where
+      // vertex i takes costs[i]. Returns the makespan.
+      double simulate_makespan(
+        const FrozenDAG &plan, const std::vector<double> &costs,
+        const std::vector<double> &priorities, std::size_t workers
+      ) {
+        typedef std::pair<double, FrozenDAG::Index> Running_t;
+        ConcurrentTaskQueue ready;
+        std::vector<FrozenDAG::Index> remaining = plan.in_degrees();
+        auto make_ready = [&](FrozenDAG::Index i) {
+          std::vector<std::unique_ptr<TaskStage>> stages;
+          std::unique_ptr<Task> task =
+            std::make_unique<Task>(stages, std::to_string(i));
+          task->set_priority(priorities[static_cast<std::size_t>(i)]);
+          ready.push(std::move(task));
+        };
+        for (std::size_t i = 0; i < remaining.size(); ++i) {
+          if (remaining[i] == 0) {
+            make_ready(static_cast<FrozenDAG::Index>(i));
+          }
+        }
+
+        double now = 0.0;
+        std::priority_queue<
+          Running_t, std::vector<Running_t>, std::greater<Running_t>>
+          running;
+        while (!ready.empty() || !running.empty()) {
+          std::unique_ptr<Task> next;
+          while (running.size() < workers && ready.try_pop(next)) {
+            const FrozenDAG::Index i = std::stoi(next->label());
+            running.emplace(now + costs[static_cast<std::size_t>(i)], i);
+          }
+          const Running_t done = running.top();
+          running.pop();
+          now = done.first;
+          for (FrozenDAG::Index s : plan.successors(done.second)) {
+            if (--remaining[static_cast<std::size_t>(s)] == 0) {
+              make_ready(s);
+            }
+          }
+        }
+
+        return now;
+      }
+    } // namespace detail
+
+    class TestDAGExecution : public ::testing::Test {
+    public:
+      // Independent vertices are expected to run side by side, whatever
+      // the host's core count.
+      TestDAGExecution() : scheduler_(10) {}
+
+    protected:
+      virtual void SetUp() {
+        log_ = std::make_shared<detail::RunLog>();
+        scheduler_thread_ =
+          std::thread([this]() { ASSERT_TRUE(scheduler_.startup()); });
+        // startup() clears the kill flag, so a shutdown() issued before it
+        // runs would be lost and TearDown would never join.
+        while (scheduler_.is_shutdown()) {
+          std::this_thread::yield();
+        }
+      }
+
+      virtual void TearDown() {
+        scheduler_.shutdown();
+        scheduler_thread_.join();
+        get_dag().reset();
+      }
+
+      DAG &get_dag() { return d_; }
+
+      TaskScheduler &get_scheduler() { return scheduler_; }
+
+      detail::RunLog &get_log() { return *log_; }
+
+      // Adds a vertex whose task logs its one stage. Returns a clone to
+      // connect with.
+      DAGVertex add(
+        const std::string &label,
+        const std::chrono::milliseconds &run_time =
+          std::chrono::milliseconds(10),
+        bool succeed = true
+      ) {
+        std::vector<std::unique_ptr<TaskStage>> stages;
+        stages.push_back(std::make_unique<detail::LoggingStage>(
+          label, log_, run_time, succeed
+        ));
+        DAGVertex v(label, std::make_unique<Task>(stages, label));
+        DAGVertex ret = v.clone();
+        get_dag().add_vertex(std::move(v));
+        return ret;
+      }
+
+      // Adds a vertex whose task picks choice, see ChoosingStage.
+      DAGVertex
+      add_choosing(const std::string &label, const std::string &choice) {
+        std::vector<std::unique_ptr<TaskStage>> stages;
+        stages.push_back(
+          std::make_unique<detail::ChoosingStage>(label, log_, choice)
+        );
+        DAGVertex v(label, std::make_unique<Task>(stages, label));
+        DAGVertex ret = v.clone();
+        get_dag().add_vertex(std::move(v));
+        return ret;
+      }
+
+      // Adds a vertex whose task kills the one of target on scheduler,
+      // see KillingStage.
+      DAGVertex add_killing(
+        const std::string &label, TaskScheduler &scheduler,
+        const DAGVertex &target
+      ) {
+        std::vector<std::unique_ptr<TaskStage>> stages;
+        stages.push_back(std::make_unique<detail::KillingStage>(
+          label, log_, scheduler, target.task()->get_uuid().as_string()
+        ));
+        DAGVertex v(label, std::make_unique<Task>(stages, label));
+        DAGVertex ret = v.clone();
+        get_dag().add_vertex(std::move(v));
+        return ret;
+      }
+
+      // Connects from to to, taken only if from chose to's label.
+      bool connect_if_chosen(const DAGVertex &from, const DAGVertex &to) {
+        const std::string branch = to.label();
+        return get_dag().connect(from, to, [branch](const Task &upstream) {
+          return detail::ChoosingStage::chose(upstream, branch);
+        });
+      }
+
+      // Adds a vertex whose task fans out, see FanningStage.
+      DAGVertex add_fanning(
+        const std::string &label, const std::vector<std::string> &children,
+        const std::vector<std::string> &grandchildren =
+          std::vector<std::string>()
+      ) {
+        std::vector<std::unique_ptr<TaskStage>> stages;
+        stages.push_back(std::make_unique<detail::FanningStage>(
+          label, log_, children, grandchildren
+        ));
+        DAGVertex v(label, std::make_unique<Task>(stages, label));
+        DAGVertex ret = v.clone();
+        get_dag().add_vertex(std::move(v));
+        return ret;
+      }
+
+      DAGExecution::Status status_of(
+        const DAGExecution &execution, const std::string &label
+      ) {
+        const FrozenDAG &plan = execution.plan();
+        FrozenDAG::Index i = 0;
+        while (plan.vertex(i)->label() != label) {
+          ++i;
+        }
+        return execution.status(i);
+      }
+
+    private:
+      DAG d_;
+      TaskScheduler scheduler_;
+      std::thread scheduler_thread_;
+      std::shared_ptr<detail::RunLog> log_;
+    };
+
+    TEST_F(TestDAGExecution, runs_in_dependency_order) {
+      DAGVertex a = add("a");
+      DAGVertex b = add("b");
+      DAGVertex c = add("c");
+      DAGVertex d = add("d");
+      DAGVertex e = add("e");
+      ASSERT_TRUE(get_dag().connect(a, b));
+      ASSERT_TRUE(get_dag().connect(a, c));
+      ASSERT_TRUE(get_dag().connect(b, d));
+      ASSERT_TRUE(get_dag().connect(c, d));
+      ASSERT_TRUE(get_dag().connect(d, e));
+
+      std::shared_ptr<DAGExecution> execution =
+        execute_dag(get_dag(), get_scheduler());
+      ASSERT_NE(nullptr, execution);
+      ASSERT_TRUE(execution->wait());
+      EXPECT_TRUE(execution->is_finished());
+      EXPECT_EQ(5u, execution->finished_count());
+      EXPECT_EQ(10u, get_log().size());
+
+      const std::vector<std::pair<std::string, std::string>> edges{
+        {"a", "b"}, {"a", "c"}, {"b", "d"}, {"c", "d"}, {"d", "e"}
+      };
+      for (const auto &edge : edges) {
+        EXPECT_LT(
+          get_log().at("-" + edge.first), get_log().at("+" + edge.second)
+        ) << edge.first << " -> " << edge.second;
+      }
+      for (const std::string label : {"a", "b", "c", "d", "e"}) {
+        EXPECT_EQ(
+          DAGExecution::Status::succeeded, status_of(*execution, label)
+        );
+      }
+    }
+
+    TEST_F(TestDAGExecution, no_barrier_between_levels) {
+      DAGVertex slow = add("slow", std::chrono::milliseconds(500));
+      DAGVertex after_slow = add("after_slow");
+      DAGVertex fast = add("fast");
+      DAGVertex after_fast = add("after_fast");
+      ASSERT_TRUE(get_dag().connect(slow, after_slow));
+      ASSERT_TRUE(get_dag().connect(fast, after_fast));
+
+      std::shared_ptr<DAGExecution> execution =
+        execute_dag(get_dag(), get_scheduler());
+      ASSERT_NE(nullptr, execution);
+      ASSERT_TRUE(execution->wait_for(std::chrono::seconds(10)));
+      EXPECT_TRUE(execution->succeeded());
+      // after_fast only waits on fast, not on the rest of its level.
+      EXPECT_LT(get_log().at("-after_fast"), get_log().at("-slow"));
+      EXPECT_LT(get_log().at("-slow"), get_log().at("+after_slow"));
+    }
+
+    TEST_F(TestDAGExecution, failure_skips_downstream) {
+      DAGVertex a = add("a", std::chrono::milliseconds(10), false);
+      DAGVertex b = add("b");
+      DAGVertex c = add("c");
+      DAGVertex d = add("d");
+      DAGVertex no_task("no_task");
+      DAGVertex no_task_clone = no_task.clone();
+      get_dag().add_vertex(std::move(no_task));
+      ASSERT_TRUE(get_dag().connect(a, b));
+      ASSERT_TRUE(get_dag().connect(b, c));
+      ASSERT_TRUE(get_dag().connect(no_task_clone, d));
+
+      std::shared_ptr<DAGExecution> execution =
+        execute_dag(get_dag(), get_scheduler());
+      ASSERT_NE(nullptr, execution);
+      EXPECT_FALSE(execution->wait());
+      EXPECT_EQ(5u, execution->finished_count());
+      EXPECT_EQ(DAGExecution::Status::failed, status_of(*execution, "a"));
+      EXPECT_EQ(DAGExecution::Status::skipped, status_of(*execution, "b"));
+      EXPECT_EQ(DAGExecution::Status::skipped, status_of(*execution, "c"));
+      EXPECT_EQ(
+        DAGExecution::Status::succeeded, status_of(*execution, "no_task")
+      );
+      EXPECT_EQ(DAGExecution::Status::succeeded, status_of(*execution, "d"));
+      EXPECT_EQ(get_log().size(), get_log().at("+b"));
+    }
+
+    TEST_F(TestDAGExecution, killed_before_it_runs_fails) {
+      DAGVertex a = add("a");
+      DAGVertex b = add("b");
+      ASSERT_TRUE(get_dag().connect(a, b));
+
+      // Held on the queue, so the kill takes it off rather than
+      // interrupting it.
+      get_scheduler().pause();
+      std::shared_ptr<DAGExecution> execution =
+        execute_dag(get_dag(), get_scheduler());
+      ASSERT_NE(nullptr, execution);
+      EXPECT_TRUE(get_scheduler().kill_task(a.task()->get_uuid()));
+      get_scheduler().resume();
+
+      ASSERT_TRUE(execution->wait_for(std::chrono::seconds(10)));
+      EXPECT_FALSE(execution->wait());
+      EXPECT_EQ(DAGExecution::Status::failed, status_of(*execution, "a"));
+      EXPECT_EQ(DAGExecution::Status::skipped, status_of(*execution, "b"));
+      EXPECT_EQ(0u, get_log().size());
+    }
+
+    TEST_F(TestDAGExecution, killed_on_the_ring_fails) {
+      TaskScheduler scheduler(
+        2, TaskScheduler::Mode::central_queue,
+        TaskScheduler::Queue::lock_free
+      );
+      DAGVertex a = add("a");
+      DAGVertex b = add("b");
+      ASSERT_TRUE(get_dag().connect(a, b));
+
+      // Not started, so a waits on the ring, which can only be popped
+      // from. The kill is applied once the dispatcher pops it.
+      std::shared_ptr<DAGExecution> execution =
+        execute_dag(get_dag(), scheduler);
+      ASSERT_NE(nullptr, execution);
+      EXPECT_TRUE(scheduler.kill_task(a.task()->get_uuid()));
+      std::thread scheduler_thread([&]() {
+        ASSERT_TRUE(scheduler.startup());
+      });
+
+      EXPECT_TRUE(execution->wait_for(std::chrono::seconds(10)));
+      EXPECT_FALSE(execution->succeeded());
+      EXPECT_EQ(DAGExecution::Status::failed, status_of(*execution, "a"));
+      EXPECT_EQ(DAGExecution::Status::skipped, status_of(*execution, "b"));
+      EXPECT_EQ(0u, get_log().size());
+
+      // startup() clears the kill flag, so wait for it before shutting
+      // down.
+      while (scheduler.is_shutdown()) {
+        std::this_thread::yield();
+      }
+      scheduler.shutdown();
+      scheduler_thread.join();
+    }
+
+    TEST_F(TestDAGExecution, empty_and_cyclic) {
+      std::shared_ptr<DAGExecution> execution =
+        execute_dag(get_dag(), get_scheduler());
+      ASSERT_NE(nullptr, execution);
+      EXPECT_TRUE(execution->is_finished());
+      EXPECT_TRUE(execution->wait());
+
+      DAGVertex a = add("a");
+      DAGVertex b = add("b");
+      ASSERT_TRUE(get_dag().connect(a, b));
+      // b -> a, added behind the DAG's back, closes the cycle.
+      std::weak_ptr<DAGVertex> b_ptr = get_dag().find_vertex(b);
+      b_ptr.lock()->connect(get_dag().find_vertex(a).lock());
+      EXPECT_EQ(nullptr, execute_dag(get_dag(), get_scheduler()));
+    }
+
+    TEST_F(TestDAGExecution, incremental_reruns_only_affected) {
+      DAGVertex a = add("a");
+      DAGVertex b = add("b");
+      DAGVertex c = add("c");
+      DAGVertex d = add("d");
+      DAGVertex e = add("e");
+      ASSERT_TRUE(get_dag().connect(a, b));
+      ASSERT_TRUE(get_dag().connect(b, c));
+      ASSERT_TRUE(get_dag().connect(a, d));
+      get_dag().clear_dirty();
+
+      std::shared_ptr<DAGExecution> full =
+        execute_dag(get_dag(), get_scheduler());
+      ASSERT_NE(nullptr, full);
+      ASSERT_TRUE(full->wait());
+      EXPECT_EQ(10u, get_log().size());
+
+      ASSERT_TRUE(get_dag().mark_dirty(b.get_uuid()));
+      std::shared_ptr<DAGExecution> partial =
+        execute_dag_incremental(get_dag(), get_scheduler(), *full);
+      ASSERT_NE(nullptr, partial);
+      ASSERT_TRUE(partial->wait());
+      EXPECT_EQ(5u, partial->finished_count());
+      EXPECT_TRUE(get_dag().dirty_vertices().empty());
+      // Only b and c ran again.
+      EXPECT_EQ(14u, get_log().size());
+      EXPECT_EQ(DAGExecution::Status::reused, status_of(*partial, "a"));
+      EXPECT_EQ(DAGExecution::Status::succeeded, status_of(*partial, "b"));
+      EXPECT_EQ(DAGExecution::Status::succeeded, status_of(*partial, "c"));
+      EXPECT_EQ(DAGExecution::Status::reused, status_of(*partial, "d"));
+      EXPECT_EQ(DAGExecution::Status::reused, status_of(*partial, "e"));
+
+      // Nothing is dirty, so nothing runs.
+      std::shared_ptr<DAGExecution> none =
+        execute_dag_incremental(get_dag(), get_scheduler(), *partial);
+      ASSERT_NE(nullptr, none);
+      EXPECT_TRUE(none->is_finished());
+      EXPECT_TRUE(none->wait());
+      EXPECT_EQ(14u, get_log().size());
+
+      // A new vertex changes the shape, so everything runs.
+      add("f");
+      std::shared_ptr<DAGExecution> reshaped =
+        execute_dag_incremental(get_dag(), get_scheduler(), *none);
+      ASSERT_NE(nullptr, reshaped);
+      ASSERT_TRUE(reshaped->wait());
+      EXPECT_EQ(26u, get_log().size());
+    }
+
+    TEST_F(TestDAGExecution, incremental_retries_what_did_not_succeed) {
+      DAGVertex a = add("a");
+      DAGVertex b = add("b", std::chrono::milliseconds(10), false);
+      DAGVertex c = add("c");
+      ASSERT_TRUE(get_dag().connect(a, b));
+      ASSERT_TRUE(get_dag().connect(b, c));
+
+      std::shared_ptr<DAGExecution> full =
+        execute_dag(get_dag(), get_scheduler());
+      ASSERT_NE(nullptr, full);
+      EXPECT_FALSE(full->wait());
+      EXPECT_EQ(DAGExecution::Status::skipped, status_of(*full, "c"));
+      EXPECT_EQ(4u, get_log().size());
+
+      std::shared_ptr<DAGExecution> retry =
+        DAGExecution::restart(*full, {}, get_scheduler());
+      EXPECT_FALSE(retry->wait());
+      EXPECT_EQ(DAGExecution::Status::reused, status_of(*retry, "a"));
+      EXPECT_EQ(DAGExecution::Status::failed, status_of(*retry, "b"));
+      EXPECT_EQ(DAGExecution::Status::skipped, status_of(*retry, "c"));
+      // a ran once, b twice.
+      EXPECT_EQ(6u, get_log().size());
+    }
+
+    TEST_F(TestDAGExecution, cache_skips_what_already_succeeded) {
+      DAGVertex a = add("a");
+      DAGVertex b = add("b");
+      DAGVertex c = add("c", std::chrono::milliseconds(10), false);
+      ASSERT_TRUE(get_dag().connect(a, b));
+      std::shared_ptr<TaskResultCache> cache =
+        std::make_shared<TaskResultCache>();
+
+      std::shared_ptr<DAGExecution> first =
+        execute_dag(get_dag(), get_scheduler(), nullptr, cache);
+      ASSERT_NE(nullptr, first);
+      EXPECT_FALSE(first->wait());
+      EXPECT_EQ(6u, get_log().size());
+      EXPECT_EQ(3u, cache->stats().misses);
+
+      // Only c, which failed, runs again.
+      std::shared_ptr<DAGExecution> second =
+        execute_dag(get_dag(), get_scheduler(), nullptr, cache);
+      ASSERT_NE(nullptr, second);
+      EXPECT_FALSE(second->wait());
+      EXPECT_EQ(8u, get_log().size());
+      EXPECT_EQ(DAGExecution::Status::cached, status_of(*second, "a"));
+      EXPECT_EQ(DAGExecution::Status::cached, status_of(*second, "b"));
+      EXPECT_EQ(DAGExecution::Status::failed, status_of(*second, "c"));
+      EXPECT_EQ(2u, cache->stats().hits);
+
+      // Downstream of a cached vertex runs as usual.
+      DAGVertex d = add("d");
+      ASSERT_TRUE(get_dag().connect(b, d));
+      std::shared_ptr<DAGExecution> third =
+        execute_dag(get_dag(), get_scheduler(), nullptr, cache);
+      ASSERT_NE(nullptr, third);
+      EXPECT_FALSE(third->wait());
+      EXPECT_EQ(DAGExecution::Status::cached, status_of(*third, "b"));
+      EXPECT_EQ(DAGExecution::Status::succeeded, status_of(*third, "d"));
+      EXPECT_EQ(12u, get_log().size());
+    }
+
+    TEST_F(TestDAGExecution, fused_chain_runs_on_one_worker) {
+      DAGVertex a = add("a");
+      DAGVertex b = add("b");
+      DAGVertex c = add("c");
+      DAGVertex d = add("d");
+      DAGVertex e = add("e");
+      ASSERT_TRUE(get_dag().connect(a, b));
+      ASSERT_TRUE(get_dag().connect(b, c));
+      ASSERT_TRUE(get_dag().connect(c, d));
+      ASSERT_TRUE(get_dag().connect(c, e));
+
+      std::shared_ptr<DAGExecution> execution =
+        execute_dag(get_dag(), get_scheduler(), nullptr, nullptr, true);
+      ASSERT_NE(nullptr, execution);
+      ASSERT_TRUE(execution->wait());
+      EXPECT_EQ(10u, get_log().size());
+      for (const char *label : {"a", "b", "c", "d", "e"}) {
+        EXPECT_EQ(
+          DAGExecution::Status::succeeded, status_of(*execution, label)
+        );
+      }
+      EXPECT_LT(get_log().at("-a"), get_log().at("+b"));
+      EXPECT_LT(get_log().at("-b"), get_log().at("+c"));
+      EXPECT_LT(get_log().at("-c"), get_log().at("+d"));
+      EXPECT_LT(get_log().at("-c"), get_log().at("+e"));
+      // a, b and c are one chain.
+      EXPECT_EQ(get_log().thread_of("+a"), get_log().thread_of("+b"));
+      EXPECT_EQ(get_log().thread_of("+a"), get_log().thread_of("+c"));
+    }
+
+    TEST_F(TestDAGExecution, fused_chain_failure_skips_the_rest) {
+      DAGVertex a = add("a");
+      DAGVertex b = add("b", std::chrono::milliseconds(10), false);
+      DAGVertex c = add("c");
+      DAGVertex d = add("d");
+      ASSERT_TRUE(get_dag().connect(a, b));
+      ASSERT_TRUE(get_dag().connect(b, c));
+      ASSERT_TRUE(get_dag().connect(c, d));
+      std::shared_ptr<TaskResultCache> cache =
+        std::make_shared<TaskResultCache>();
+
+      std::shared_ptr<DAGExecution> execution =
+        execute_dag(get_dag(), get_scheduler(), nullptr, cache, true);
+      ASSERT_NE(nullptr, execution);
+      EXPECT_FALSE(execution->wait());
+      EXPECT_EQ(4u, execution->finished_count());
+      EXPECT_EQ(DAGExecution::Status::succeeded, status_of(*execution, "a"));
+      EXPECT_EQ(DAGExecution::Status::failed, status_of(*execution, "b"));
+      EXPECT_EQ(DAGExecution::Status::skipped, status_of(*execution, "c"));
+      EXPECT_EQ(DAGExecution::Status::skipped, status_of(*execution, "d"));
+      EXPECT_EQ(4u, get_log().size());
+
+      // A member past the head of a chain can still come from the cache.
+      std::shared_ptr<DAGExecution> retry =
+        execute_dag(get_dag(), get_scheduler(), nullptr, cache, true);
+      ASSERT_NE(nullptr, retry);
+      EXPECT_FALSE(retry->wait());
+      EXPECT_EQ(DAGExecution::Status::cached, status_of(*retry, "a"));
+      EXPECT_EQ(DAGExecution::Status::failed, status_of(*retry, "b"));
+      EXPECT_EQ(6u, get_log().size());
+    }
+
+    TEST_F(TestDAGExecution, fused_chain_benchmark) {
+      LogTag LOG_TAG(__FUNCTION__);
+      Logging::add_std_cout_logger(LOG_TAG);
+
+      const std::size_t depth = 200;
+      std::vector<DAGVertex> vertices;
+      for (std::size_t i = 0; i < depth; ++i) {
+        vertices.push_back(
+          add(std::to_string(i), std::chrono::milliseconds(0))
+        );
+        if (i > 0) {
+          ASSERT_TRUE(get_dag().connect(vertices[i - 1], vertices[i]));
+        }
+      }
+
+      double seconds[2] = {0.0, 0.0};
+      for (bool fuse : {false, true}) {
+        const std::chrono::steady_clock::time_point started =
+          std::chrono::steady_clock::now();
+        std::shared_ptr<DAGExecution> execution =
+          execute_dag(get_dag(), get_scheduler(), nullptr, nullptr, fuse);
+        ASSERT_NE(nullptr, execution);
+        ASSERT_TRUE(execution->wait());
+        const std::chrono::duration<double> took =
+          std::chrono::steady_clock::now() - started;
+        seconds[fuse ? 1 : 0] = took.count();
+      }
+      EXPECT_EQ(4 * depth, get_log().size());
+      Logging::info(
+        LOG_TAG, "chain of", depth, "unfused", seconds[0], "s fused",
+        seconds[1], "s saved per vertex",
+        (seconds[0] - seconds[1]) / static_cast<double>(depth), "s"
+      );
+      EXPECT_LT(seconds[1], seconds[0]);
+    }
+
+    TEST_F(TestDAGExecution, work_stealing_kill_on_a_deque_fails) {
+      // One thread, so what a releases stays on its deque until that
+      // thread takes it.
+      TaskScheduler scheduler(1, TaskScheduler::Mode::work_stealing);
+      std::thread scheduler_thread([&]() {
+        ASSERT_TRUE(scheduler.startup());
+      });
+      while (scheduler.is_shutdown()) {
+        std::this_thread::yield();
+      }
+
+      // warm_up makes the thread queue onto its deque from then on. The
+      // deque is last in first out, so killer runs while b waits there.
+      DAGVertex warm_up = add("warm_up", std::chrono::milliseconds(0));
+      DAGVertex a = add("a", std::chrono::milliseconds(0));
+      DAGVertex b = add("b", std::chrono::milliseconds(0));
+      DAGVertex d = add("d", std::chrono::milliseconds(0));
+      DAGVertex killer = add_killing("killer", scheduler, b);
+      ASSERT_TRUE(get_dag().connect(warm_up, a));
+      ASSERT_TRUE(get_dag().connect(a, b));
+      ASSERT_TRUE(get_dag().connect(a, killer));
+      ASSERT_TRUE(get_dag().connect(b, d));
+
+      std::shared_ptr<DAGExecution> execution =
+        execute_dag(get_dag(), scheduler);
+      ASSERT_NE(nullptr, execution);
+      EXPECT_TRUE(execution->wait_for(std::chrono::seconds(10)));
+      EXPECT_FALSE(execution->succeeded());
+      EXPECT_EQ(
+        DAGExecution::Status::succeeded, status_of(*execution, "killer")
+      );
+      EXPECT_EQ(DAGExecution::Status::failed, status_of(*execution, "b"));
+      EXPECT_EQ(DAGExecution::Status::skipped, status_of(*execution, "d"));
+      EXPECT_EQ(get_log().size(), get_log().at("+b"));
+
+      scheduler.shutdown();
+      scheduler_thread.join();
+    }
+
+    TEST_F(TestDAGExecution, work_stealing_benchmark) {
+      LogTag LOG_TAG(__FUNCTION__);
+      Logging::add_std_cout_logger(LOG_TAG);
+
+      // Runs get_dag() on a scheduler of its own, returns the seconds it
+      // took.
+      auto run = [&](TaskScheduler::Mode mode) {
+        TaskScheduler scheduler(4, mode);
+        std::thread scheduler_thread([&]() {
+          ASSERT_TRUE(scheduler.startup());
+        });
+        while (scheduler.is_shutdown()) {
+          std::this_thread::yield();
+        }
+        const std::chrono::steady_clock::time_point started =
+          std::chrono::steady_clock::now();
+        std::shared_ptr<DAGExecution> execution =
+          execute_dag(get_dag(), scheduler);
+        EXPECT_NE(nullptr, execution);
+        if (execution != nullptr) {
+          EXPECT_TRUE(execution->wait());
+        }
+        const std::chrono::duration<double> took =
+          std::chrono::steady_clock::now() - started;
+        scheduler.shutdown();
+        scheduler_thread.join();
+        return took.count();
+      };
+      const TaskScheduler::Mode modes[2] = {
+        TaskScheduler::Mode::central_queue,
+        TaskScheduler::Mode::work_stealing
+      };
+
+      const std::size_t size = 100;
+      const std::chrono::milliseconds no_time(0);
+      double wide[2] = {0.0, 0.0};
+      double deep[2] = {0.0, 0.0};
+      // A root releasing all of a level at once, joined by a sink.
+      DAGVertex root = add("root", no_time);
+      DAGVertex sink = add("sink", no_time);
+      for (std::size_t i = 0; i < size; ++i) {
+        DAGVertex leaf = add("leaf_" + std::to_string(i), no_time);
+        ASSERT_TRUE(get_dag().connect(root, leaf));
+        ASSERT_TRUE(get_dag().connect(leaf, sink));
+      }
+      for (std::size_t m = 0; m < 2; ++m) {
+        wide[m] = run(modes[m]);
+      }
+      get_dag().reset();
+
+      // A chain, each vertex releasing one.
+      std::vector<DAGVertex> chain;
+      for (std::size_t i = 0; i < size; ++i) {
+        chain.push_back(add("link_" + std::to_string(i), no_time));
+        if (i > 0) {
+          ASSERT_TRUE(get_dag().connect(chain[i - 1], chain[i]));
+        }
+      }
+      for (std::size_t m = 0; m < 2; ++m) {
+        deep[m] = run(modes[m]);
+      }
+
+      const double vertices = static_cast<double>(size + 2);
+      Logging::info(
+        LOG_TAG, "wide of", size, "central", vertices / wide[0],
+        "vertices/s work stealing", vertices / wide[1], "vertices/s"
+      );
+      Logging::info(
+        LOG_TAG, "deep of", size, "central", size / deep[0],
+        "vertices/s work stealing", size / deep[1], "vertices/s"
+      );
+      // Threads that finish take the next leaf themselves, rather than
+      // each leaf going through startup.
+      EXPECT_LT(wide[1], wide[0]);
+    }
+
+    TEST_F(TestDAGExecution, fan_out_children_hold_back_successors) {
+      DAGVertex a = add("a");
+      DAGVertex f = add_fanning("f", {"c0", "c1", "c2", "c3", "~loose"});
+      DAGVertex z = add("z");
+      ASSERT_TRUE(get_dag().connect(a, f));
+      ASSERT_TRUE(get_dag().connect(f, z));
+
+      std::shared_ptr<DAGExecution> execution =
+        execute_dag(get_dag(), get_scheduler());
+      ASSERT_NE(nullptr, execution);
+      ASSERT_TRUE(execution->wait());
+      EXPECT_EQ(5u, execution->expanded_count());
+      EXPECT_EQ(8u, execution->finished_count());
+      // Every vertex and child, loose or not, ran before wait returned.
+      EXPECT_EQ(16u, get_log().size());
+      for (const char *child : {"c0", "c1", "c2", "c3"}) {
+        EXPECT_LT(get_log().at("+f"), get_log().at(std::string("+") + child));
+        EXPECT_LT(get_log().at(std::string("-") + child), get_log().at("+z"))
+          << child;
+      }
+      EXPECT_EQ(DAGExecution::Status::succeeded, status_of(*execution, "f"));
+      EXPECT_EQ(DAGExecution::Status::succeeded, status_of(*execution, "z"));
+    }
+
+    TEST_F(TestDAGExecution, fan_out_child_failure_skips_successors) {
+      DAGVertex f = add_fanning("f", {"c0", "!c1"});
+      DAGVertex z = add("z");
+      DAGVertex other = add("other");
+      ASSERT_TRUE(get_dag().connect(f, z));
+      std::shared_ptr<TaskResultCache> cache =
+        std::make_shared<TaskResultCache>();
+
+      std::shared_ptr<DAGExecution> execution =
+        execute_dag(get_dag(), get_scheduler(), nullptr, cache);
+      ASSERT_NE(nullptr, execution);
+      EXPECT_FALSE(execution->wait());
+      EXPECT_EQ(5u, execution->finished_count());
+      EXPECT_EQ(DAGExecution::Status::succeeded, status_of(*execution, "f"));
+      EXPECT_EQ(DAGExecution::Status::skipped, status_of(*execution, "z"));
+      EXPECT_EQ(
+        DAGExecution::Status::succeeded, status_of(*execution, "other")
+      );
+
+      // f itself succeeded but what it fanned out to did not, so it is
+      // run again.
+      std::shared_ptr<DAGExecution> retry =
+        execute_dag(get_dag(), get_scheduler(), nullptr, cache);
+      ASSERT_NE(nullptr, retry);
+      EXPECT_FALSE(retry->wait());
+      EXPECT_EQ(DAGExecution::Status::succeeded, status_of(*retry, "f"));
+      EXPECT_EQ(DAGExecution::Status::cached, status_of(*retry, "other"));
+      EXPECT_EQ(2u, retry->expanded_count());
+    }
+
+    TEST_F(TestDAGExecution, fan_out_nests_and_is_not_fused) {
+      DAGVertex a = add("a");
+      DAGVertex f = add_fanning("f", {"c0", "c1"}, {"g0", "g1", "g2"});
+      DAGVertex z = add("z");
+      ASSERT_TRUE(get_dag().connect(a, f));
+      ASSERT_TRUE(get_dag().connect(f, z));
+
+      std::shared_ptr<DAGExecution> execution =
+        execute_dag(get_dag(), get_scheduler(), nullptr, nullptr, true);
+      ASSERT_NE(nullptr, execution);
+      ASSERT_TRUE(execution->wait());
+      EXPECT_EQ(8u, execution->expanded_count());
+      EXPECT_EQ(11u, execution->finished_count());
+      for (const char *child : {"c0", "c1"}) {
+        for (const char *grandchild : {"g0", "g1", "g2"}) {
+          const std::string name = std::string(child) + "." + grandchild;
+          EXPECT_LT(get_log().at("-" + name), get_log().at("+z")) << name;
+        }
+      }
+      EXPECT_EQ(22u, get_log().size());
+    }
+
+    TEST_F(TestDAGExecution, conditional_edges_prune_untaken_branches) {
+      DAGVertex a = add_choosing("a", "left");
+      DAGVertex left = add("left");
+      DAGVertex right = add("right");
+      DAGVertex right_only = add("right_only");
+      DAGVertex join = add("join");
+      ASSERT_TRUE(connect_if_chosen(a, left));
+      ASSERT_TRUE(connect_if_chosen(a, right));
+      ASSERT_TRUE(get_dag().connect(right, right_only));
+      ASSERT_TRUE(get_dag().connect(left, join));
+      ASSERT_TRUE(get_dag().connect(right_only, join));
+
+      std::shared_ptr<DAGExecution> execution =
+        execute_dag(get_dag(), get_scheduler(), nullptr, nullptr, true);
+      ASSERT_NE(nullptr, execution);
+      ASSERT_TRUE(execution->wait());
+      EXPECT_EQ(5u, execution->finished_count());
+      // Nothing was run for the branch not taken.
+      EXPECT_EQ(6u, get_log().size());
+      EXPECT_EQ(
+        DAGExecution::Status::succeeded, status_of(*execution, "left")
+      );
+      EXPECT_EQ(DAGExecution::Status::pruned, status_of(*execution, "right"));
+      EXPECT_EQ(
+        DAGExecution::Status::pruned, status_of(*execution, "right_only")
+      );
+      // join still has a live path through left.
+      EXPECT_EQ(
+        DAGExecution::Status::succeeded, status_of(*execution, "join")
+      );
+
+      const FrozenDAG &plan = execution->plan();
+      auto index = [&](const DAGVertex &v) {
+        return plan.index_of(v.get_uuid());
+      };
+      EXPECT_EQ(
+        DAGEdge::Status::traversed,
+        execution->edge_status(index(a), index(left))
+      );
+      EXPECT_EQ(
+        DAGEdge::Status::non_traverable,
+        execution->edge_status(index(a), index(right))
+      );
+      EXPECT_EQ(
+        DAGEdge::Status::non_traverable,
+        execution->edge_status(index(right_only), index(join))
+      );
+      EXPECT_EQ(
+        DAGEdge::Status::traversed,
+        execution->edge_status(index(left), index(join))
+      );
+    }
+
+    TEST_F(TestDAGExecution, conditional_edges_on_restart_and_cache) {
+      DAGVertex a = add_choosing("a", "right");
+      DAGVertex left = add("left");
+      DAGVertex right = add("right");
+      DAGVertex join = add("join");
+      ASSERT_TRUE(connect_if_chosen(a, left));
+      ASSERT_TRUE(connect_if_chosen(a, right));
+      ASSERT_TRUE(get_dag().connect(left, join));
+      std::shared_ptr<TaskResultCache> cache =
+        std::make_shared<TaskResultCache>();
+
+      std::shared_ptr<DAGExecution> execution =
+        execute_dag(get_dag(), get_scheduler(), nullptr, cache);
+      ASSERT_NE(nullptr, execution);
+      ASSERT_TRUE(execution->wait());
+      EXPECT_EQ(DAGExecution::Status::pruned, status_of(*execution, "left"));
+      EXPECT_EQ(DAGExecution::Status::pruned, status_of(*execution, "join"));
+      EXPECT_EQ(4u, get_log().size());
+
+      // Pruned vertices are settled, so they stay pruned when nothing
+      // upstream of them changed.
+      const FrozenDAG &plan = execution->plan();
+      std::shared_ptr<DAGExecution> again = DAGExecution::restart(
+        *execution, {plan.index_of(join.get_uuid())}, get_scheduler()
+      );
+      ASSERT_TRUE(again->wait());
+      EXPECT_EQ(DAGExecution::Status::reused, status_of(*again, "a"));
+      EXPECT_EQ(DAGExecution::Status::pruned, status_of(*again, "left"));
+      EXPECT_EQ(DAGExecution::Status::pruned, status_of(*again, "join"));
+      EXPECT_EQ(4u, get_log().size());
+
+      // a is run again for its choice, what it chose comes from the cache.
+      std::shared_ptr<DAGExecution> cached =
+        execute_dag(get_dag(), get_scheduler(), nullptr, cache);
+      ASSERT_NE(nullptr, cached);
+      ASSERT_TRUE(cached->wait());
+      EXPECT_EQ(DAGExecution::Status::succeeded, status_of(*cached, "a"));
+      EXPECT_EQ(DAGExecution::Status::cached, status_of(*cached, "right"));
+      EXPECT_EQ(DAGExecution::Status::pruned, status_of(*cached, "left"));
+      EXPECT_EQ(6u, get_log().size());
+    }
+
+    TEST_F(TestDAGExecution, cost_model_ranks_and_learns) {
+      DAGVertex a = add("a");
+      DAGVertex b = add("b");
+      DAGVertex c = add("c");
+      ASSERT_TRUE(get_dag().connect(a, b));
+      ASSERT_TRUE(get_dag().connect(a, c));
+      std::shared_ptr<DAGVertex> b_ptr = get_dag().find_vertex(b).lock();
+      b_ptr->get_task()->set_cost_estimate(5.0);
+
+      std::shared_ptr<TaskCostModel> costs =
+        std::make_shared<TaskCostModel>(1.0);
+      std::shared_ptr<DAGExecution> execution =
+        execute_dag(get_dag(), get_scheduler(), costs);
+      ASSERT_NE(nullptr, execution);
+      const FrozenDAG &plan = execution->plan();
+      EXPECT_DOUBLE_EQ(6.0, execution->rank(plan.index_of(a.get_uuid())));
+      EXPECT_DOUBLE_EQ(5.0, execution->rank(plan.index_of(b.get_uuid())));
+      EXPECT_DOUBLE_EQ(1.0, execution->rank(plan.index_of(c.get_uuid())));
+      ASSERT_TRUE(execution->wait());
+
+      // Every task ran, so the next run is ranked by what was measured.
+      for (const std::string label : {"a", "b", "c"}) {
+        EXPECT_TRUE(costs->has_history(label)) << label;
+      }
+      EXPECT_LT(costs->estimate(*b_ptr->task()), 1.0);
+    }
+
+    TEST_F(TestDAGExecution, critical_path_first_beats_fifo) {
+      // Two workers. Four independent 10s tasks become ready before a
+      // 1s task that heads a chain of five more 10s tasks. In FIFO order
+      // the chain only starts once the first four are out of the way.
+      std::vector<DAGVertex> vertices;
+      std::vector<std::pair<UUID, UUID>> edges;
+      std::vector<double> costs;
+      for (std::size_t i = 0; i < 4; ++i) {
+        vertices.emplace_back("independent_" + std::to_string(i));
+        costs.push_back(10.0);
+      }
+      vertices.emplace_back("head");
+      costs.push_back(1.0);
+      for (std::size_t i = 0; i < 5; ++i) {
+        vertices.emplace_back("chain_" + std::to_string(i));
+        costs.push_back(10.0);
+        edges.emplace_back(
+          UUID(vertices[vertices.size() - 2].get_uuid().as_string()),
+          UUID(vertices.back().get_uuid().as_string())
+        );
+      }
+      ASSERT_TRUE(get_dag().bulk_load(std::move(vertices), edges));
+
+      FrozenDAG plan(get_dag());
+      std::vector<double> ranks;
+      ASSERT_TRUE(upward_ranks(plan, costs, ranks));
+      EXPECT_DOUBLE_EQ(51.0, ranks[4]);
+      const std::vector<double> fifo(costs.size(), 0.0);
+      EXPECT_DOUBLE_EQ(71.0, detail::simulate_makespan(plan, costs, fifo, 2));
+      EXPECT_DOUBLE_EQ(
+        51.0, detail::simulate_makespan(plan, costs, ranks, 2)
+      );
+    }
+
+    TEST_F(TestDAGExecution, critical_path_first_benchmark) {
+      LogTag LOG_TAG(__FUNCTION__);
+      Logging::add_std_cout_logger(LOG_TAG);
+
+      // Random DAGs where each vertex depends on up to two of the 20
+      // before it, and one task in ten takes 20 to 60 times longer than
+      // the rest.
+      const std::size_t size = 300;
+      const std::size_t workers = 4;
+      double fifo_total = 0.0;
+      double ranked_total = 0.0;
+      for (unsigned seed = 1; seed <= 5; ++seed) {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<double> light(1.0, 2.0);
+        std::uniform_real_distribution<double> heavy(20.0, 60.0);
+        std::bernoulli_distribution is_heavy(0.1);
+        std::vector<DAGVertex> vertices;
+        std::vector<std::pair<UUID, UUID>> edges;
+        std::vector<double> costs;
+        for (std::size_t i = 0; i < size; ++i) {
+          vertices.emplace_back(std::to_string(i));
+          costs.push_back(is_heavy(gen) ? heavy(gen) : light(gen));
+          std::size_t picked = i;
+          for (std::size_t e = 0; i > 0 && e < 2; ++e) {
+            std::uniform_int_distribution<std::size_t> pick(
+              (i > 20) ? i - 20 : 0, i - 1
+            );
+            const std::size_t from = pick(gen);
+            // The same one twice would be a duplicate edge.
+            if (from % 3 != 0 && from != picked) {
+              picked = from;
+              edges.emplace_back(
+                UUID(vertices[from].get_uuid().as_string()),
+                UUID(vertices[i].get_uuid().as_string())
+              );
+            }
+          }
+        }
+        DAG g;
+        ASSERT_TRUE(g.bulk_load(std::move(vertices), edges));
+
+        FrozenDAG plan(g);
+        std::vector<double> ranks;
+        ASSERT_TRUE(upward_ranks(plan, costs, ranks));
+        const double fifo = detail::simulate_makespan(
+          plan, costs, std::vector<double>(size, 0.0), workers
+        );
+        const double ranked =
+          detail::simulate_makespan(plan, costs, ranks, workers);
+        Logging::info(
+          LOG_TAG, "seed", seed, "fifo makespan", fifo,
+          "critical path first makespan", ranked
+        );
+        // Neither order can beat the longest path.
+        const double critical_path =
+          *std::max_element(ranks.begin(), ranks.end());
+        EXPECT_GE(fifo, critical_path);
+        EXPECT_GE(ranked, critical_path);
+        fifo_total += fifo;
+        ranked_total += ranked;
+      }
+      Logging::info(
+        LOG_TAG, "total fifo makespan", fifo_total,
+        "total critical path first makespan", ranked_total
+      );
+      EXPECT_LT(ranked_total, fifo_total);
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include "dag_scheduler/dag_memory_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace com {
+  namespace dag_scheduler {
+    class TestDagMemoryPool : public ::testing::Test {
+    protected:
+      virtual void SetUp() {}
+
+      virtual void TearDown() {}
+    };
+
+    TEST_F(TestDagMemoryPool, allocate_and_deallocate) {
+      DAGMemoryPool pool(1024);
+      DAGMemoryPool::Stats stats = pool.stats();
+      EXPECT_EQ(0u, stats.slab_count);
+      EXPECT_EQ(0u, stats.bytes_reserved);
+
+      std::vector<void *> blocks;
+      for (std::size_t i = 0; i < 32; ++i) {
+        void *block = pool.allocate(24);
+        EXPECT_EQ(
+          0u, reinterpret_cast<std::uintptr_t>(block) %
+                alignof(std::max_align_t)
+        );
+        blocks.push_back(block);
+      }
+      EXPECT_EQ(
+        blocks.size(), std::set<void *>(blocks.begin(), blocks.end()).size()
+      );
+
+      stats = pool.stats();
+      EXPECT_EQ(32u, stats.blocks_in_use);
+      EXPECT_EQ(32u * 32u, stats.bytes_in_use);
+      EXPECT_EQ(1u, stats.slab_count);
+      EXPECT_EQ(1024u, stats.bytes_reserved);
+
+      for (void *block : blocks) {
+        pool.deallocate(block, 24);
+      }
+      stats = pool.stats();
+      EXPECT_EQ(0u, stats.blocks_in_use);
+      EXPECT_EQ(0u, stats.bytes_in_use);
+      EXPECT_EQ(1u, stats.slab_count);
+    }
+
+    TEST_F(TestDagMemoryPool, freed_blocks_are_reused) {
+      DAGMemoryPool pool(1024);
+      void *a = pool.allocate(64);
+      pool.deallocate(a, 64);
+      void *b = pool.allocate(64);
+      EXPECT_EQ(a, b);
+
+      // A different size never gets a block freed by another size.
+      pool.deallocate(b, 64);
+      void *c = pool.allocate(128);
+      EXPECT_NE(a, c);
+      pool.deallocate(c, 128);
+      EXPECT_EQ(2u, pool.stats().slab_count);
+    }
+
+    TEST_F(TestDagMemoryPool, large_blocks_bypass_slabs) {
+      DAGMemoryPool pool(1024);
+      void *block = pool.allocate(512);
+      ASSERT_NE(nullptr, block);
+      DAGMemoryPool::Stats stats = pool.stats();
+      EXPECT_EQ(0u, stats.slab_count);
+      EXPECT_EQ(1u, stats.blocks_in_use);
+      pool.deallocate(block, 512);
+      EXPECT_EQ(0u, pool.stats().blocks_in_use);
+    }
+
+    TEST_F(TestDagMemoryPool, allocate_shared_keeps_pool_alive) {
+      std::weak_ptr<DAGMemoryPool> weak_pool;
+      std::shared_ptr<std::size_t> value;
+      {
+        std::shared_ptr<DAGMemoryPool> pool =
+          std::make_shared<DAGMemoryPool>();
+        weak_pool = pool;
+        value = std::allocate_shared<std::size_t>(
+          DAGPoolAllocator<std::size_t>(pool), 42u
+        );
+        EXPECT_EQ(1u, pool->stats().blocks_in_use);
+      }
+      EXPECT_FALSE(weak_pool.expired());
+      EXPECT_EQ(42u, *value);
+      value.reset();
+      EXPECT_TRUE(weak_pool.expired());
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -166,6 +166,7 @@ namespace com {
         std::string("      UUID: <valid uuid4 string>\n") +
         std::string("      Task:\n") +
         std::string("        Name: <optional string>\n") +
+        std::string("        Cost: <optional seconds>\n") +
         std::string("        InitialInputs: <optional YAML>\n") +
         std::string("          <valid YAML>\n") +
         std::string("        Configuration: <optional YAML>\n") +
@@ -191,6 +192,7 @@ namespace com {
         std::string("      UUID: <valid uuid4 string>\n") +
         std::string("      Task:\n") +
         std::string("        Name: <optional string>\n") +
+        std::string("        Cost: <optional seconds>\n") +
         std::string("        InitialInputs: <optional YAML>\n") +
         std::string("          <valid YAML>\n") +
         std::string("        Configuration: <optional YAML>\n") +
@@ -216,6 +218,7 @@ namespace com {
         std::string("      UUID: <valid uuid4 string>\n") +
         std::string("      Task:\n") +
         std::string("        Name: <optional string>\n") +
+        std::string("        Cost: <optional seconds>\n") +
         std::string("        InitialInputs: <optional YAML>\n") +
         std::string("          <valid YAML>\n") +
         std::string("        Configuration: <optional YAML>\n") +
@@ -257,6 +260,7 @@ namespace com {
         std::string("      UUID: <valid uuid4 string>\n") +
         std::string("      Task:\n") +
         std::string("        Name: <optional string>\n") +
+        std::string("        Cost: <optional seconds>\n") +
         std::string("        InitialInputs: <optional YAML>\n") +
         std::string("          <valid YAML>\n") +
         std::string("        Configuration: <optional YAML>\n") +
@@ -520,6 +524,40 @@ namespace com {
       EXPECT_EQ(uuid1_task_label, uuid1_vertex->get_task()->label());
     }
 
+    TEST(TestYAMLDagDeserializer, make_dag_vertices_task_cost) {
+      YAML::Node yaml_node;
+      yaml_node[YAMLDagDeserializer::DAG_KEY] =
+        std::map<std::string, YAML::Node>(
+          {{YAMLDagDeserializer::TITLE_KEY, YAML::Node("Test YAML DAG")}}
+        );
+      YAML::Node first_vertex;
+      first_vertex[YAMLDagDeserializer::UUID_KEY] = TEST_UUID_1;
+      first_vertex[YAMLDagDeserializer::TASK_KEY] = YAML::Node();
+      first_vertex[YAMLDagDeserializer::TASK_KEY]
+                  [YAMLDagDeserializer::COST_KEY] = YAML::Node(2.5);
+      std::vector<YAML::Node> vertices = {first_vertex};
+      yaml_node[YAMLDagDeserializer::DAG_KEY]
+               [YAMLDagDeserializer::VERTICES_KEY] = vertices;
+      auto test_dag =
+        yaml_node.as<std::unique_ptr<com::dag_scheduler::DAG>>();
+      ASSERT_NE(nullptr, test_dag);
+      UUID uuid_1(TEST_UUID_1);
+      std::shared_ptr<DAGVertex> uuid1_vertex =
+        test_dag->find_vertex_by_uuid(std::move(uuid_1)).lock();
+      ASSERT_TRUE(uuid1_vertex != nullptr);
+      EXPECT_DOUBLE_EQ(2.5, uuid1_vertex->task()->cost_estimate());
+
+      first_vertex[YAMLDagDeserializer::TASK_KEY]
+                  [YAMLDagDeserializer::COST_KEY] = YAML::Node(-1.0);
+      vertices = {first_vertex};
+      yaml_node[YAMLDagDeserializer::DAG_KEY]
+               [YAMLDagDeserializer::VERTICES_KEY] = vertices;
+      EXPECT_THROW(
+        yaml_node.as<std::unique_ptr<com::dag_scheduler::DAG>>(),
+        YAMLDagDeserializerError
+      );
+    }
+
     TEST(TestYAMLDagDeserializer, make_dag_vertices_named_task_task_config) {
       YAML::Node yaml_node;
       yaml_node[YAMLDagDeserializer::DAG_KEY] =
@@ -309,6 +309,31 @@ namespace com {
       EXPECT_EQ(v_copied, v);
     }
 
+    TEST_F(TestDagVertex, copies_share_task_until_get_task) {
+      std::vector<std::unique_ptr<TaskStage>> stages{};
+      auto task = std::make_unique<Task>(stages, "1 Task");
+      const Task *task_ptr = task.get();
+      DAGVertex v("1", std::move(task));
+      DAGVertex v_copied(v);
+      DAGVertex v_assigned;
+      v_assigned = v;
+
+      EXPECT_EQ(task_ptr, v.task());
+      EXPECT_EQ(task_ptr, v_copied.task());
+      EXPECT_EQ(task_ptr, v_assigned.task());
+
+      ASSERT_NE(nullptr, v_copied.get_task());
+      EXPECT_NE(task_ptr, v_copied.task());
+      EXPECT_EQ("1 Task", v_copied.task()->label());
+      EXPECT_EQ(task_ptr, v.task());
+      EXPECT_EQ(task_ptr, v_assigned.task());
+
+      // Once nothing else shares it the Task is handed out as is.
+      v_assigned = DAGVertex();
+      EXPECT_EQ(task_ptr, v.get_task().get());
+      EXPECT_EQ(nullptr, DAGVertex().task());
+    }
+
     TEST_F(TestDagVertex, assignment_operator_no_edges_with_task) {
       std::vector<std::unique_ptr<TaskStage>> stages{};
       auto task = std::make_unique<Task>(stages, "1 Task");
@@ -669,6 +694,167 @@ namespace com {
       EXPECT_EQ(0, v.edge_count());
     }
 
+    TEST_F(TestDagVertex, successors_and_predecessors) {
+      std::shared_ptr<DAGVertex> a = std::make_shared<DAGVertex>("a");
+      std::shared_ptr<DAGVertex> b = std::make_shared<DAGVertex>("b");
+      std::shared_ptr<DAGVertex> c = std::make_shared<DAGVertex>("c");
+      a->connect(b);
+      a->connect(c);
+      b->connect(c);
+
+      EXPECT_EQ(
+        (std::vector<DAGVertex *>{b.get(), c.get()}), a->successors()
+      );
+      EXPECT_TRUE(a->predecessors().empty());
+      EXPECT_EQ(std::vector<DAGVertex *>{a.get()}, b->predecessors());
+      EXPECT_EQ(
+        (std::vector<DAGVertex *>{a.get(), b.get()}), c->predecessors()
+      );
+
+      // Moving a vertex hands its place on both sides to the new object.
+      DAGVertex moved(std::move(*b));
+      EXPECT_TRUE(b->successors().empty());
+      EXPECT_TRUE(b->predecessors().empty());
+      EXPECT_EQ(std::vector<DAGVertex *>{a.get()}, moved.predecessors());
+      EXPECT_EQ(std::vector<DAGVertex *>{c.get()}, moved.successors());
+      EXPECT_EQ(
+        (std::vector<DAGVertex *>{&moved, c.get()}), a->successors()
+      );
+      EXPECT_EQ(
+        (std::vector<DAGVertex *>{a.get(), &moved}), c->predecessors()
+      );
+
+      moved.clear_edges();
+      EXPECT_EQ(std::vector<DAGVertex *>{a.get()}, c->predecessors());
+
+      // A destroyed target is no longer reported by its predecessor, even
+      // though the expired edge itself is kept.
+      c.reset();
+      EXPECT_EQ(std::vector<DAGVertex *>{&moved}, a->successors());
+      EXPECT_EQ(2ul, a->edge_count());
+    }
+
+    TEST_F(TestDagVertex, structural_hash) {
+      std::shared_ptr<DAGVertex> a = std::make_shared<DAGVertex>("a");
+      std::shared_ptr<DAGVertex> b = std::make_shared<DAGVertex>("b");
+      std::shared_ptr<DAGVertex> c = std::make_shared<DAGVertex>("c");
+      a->connect(b);
+      a->connect(c);
+
+      // Built separately, connected in the other order.
+      std::shared_ptr<DAGVertex> other_a = std::make_shared<DAGVertex>("a");
+      std::shared_ptr<DAGVertex> other_b = std::make_shared<DAGVertex>("b");
+      std::shared_ptr<DAGVertex> other_c = std::make_shared<DAGVertex>("c");
+      other_a->connect(other_c);
+      other_a->connect(other_b);
+      EXPECT_EQ(a->structural_hash(), other_a->structural_hash());
+      EXPECT_NE(a->structural_hash(), b->structural_hash());
+
+      // A change below a vertex changes its hash.
+      const std::uint64_t before = a->structural_hash();
+      b->connect(c);
+      EXPECT_NE(before, a->structural_hash());
+      other_b->connect(other_c);
+      EXPECT_EQ(a->structural_hash(), other_a->structural_hash());
+
+      std::shared_ptr<DAGVertex> with_task = std::make_shared<DAGVertex>(
+        "a", std::make_unique<Task>()
+      );
+      EXPECT_NE(
+        DAGVertex("a").structural_hash(), with_task->structural_hash()
+      );
+    }
+
+    TEST_F(TestDagVertex, structural_hash_is_invalidated_upstream) {
+      std::shared_ptr<DAGVertex> a = std::make_shared<DAGVertex>("a");
+      std::shared_ptr<DAGVertex> b = std::make_shared<DAGVertex>("b");
+      std::shared_ptr<DAGVertex> c = std::make_shared<DAGVertex>("c");
+      std::shared_ptr<DAGVertex> d = std::make_shared<DAGVertex>("d");
+      a->connect(b);
+      b->connect(c);
+      d->connect(c);
+      a->structural_hash();
+      d->structural_hash();
+      EXPECT_TRUE(a->structural_hash_valid_);
+      EXPECT_TRUE(b->structural_hash_valid_);
+      EXPECT_TRUE(c->structural_hash_valid_);
+      EXPECT_TRUE(d->structural_hash_valid_);
+
+      c->get_task();
+      EXPECT_FALSE(a->structural_hash_valid_);
+      EXPECT_FALSE(b->structural_hash_valid_);
+      EXPECT_FALSE(c->structural_hash_valid_);
+      EXPECT_FALSE(d->structural_hash_valid_);
+
+      // Only what is below a is hashed again.
+      a->structural_hash();
+      EXPECT_TRUE(c->structural_hash_valid_);
+      EXPECT_FALSE(d->structural_hash_valid_);
+
+      // Only what is above b goes stale.
+      std::shared_ptr<DAGVertex> e = std::make_shared<DAGVertex>("e");
+      b->connect(e);
+      EXPECT_FALSE(a->structural_hash_valid_);
+      EXPECT_FALSE(b->structural_hash_valid_);
+      EXPECT_TRUE(c->structural_hash_valid_);
+    }
+
+    TEST_F(TestDagVertex, connect_many_successors) {
+      const std::size_t size = 4 * DAGVertex::successor_scan_limit;
+      std::shared_ptr<DAGVertex> hub = std::make_shared<DAGVertex>("hub");
+      std::vector<std::shared_ptr<DAGVertex>> targets;
+      for (std::size_t i = 0; i < size; ++i) {
+        targets.push_back(std::make_shared<DAGVertex>(std::to_string(i)));
+        EXPECT_TRUE(hub->connect(targets.back()));
+        EXPECT_EQ(
+          i >= DAGVertex::successor_scan_limit, hub->successor_set_ != nullptr
+        );
+      }
+      for (const std::shared_ptr<DAGVertex> &t : targets) {
+        EXPECT_FALSE(hub->connect(t));
+        EXPECT_TRUE(hub->contains_connection_to(*t));
+      }
+      EXPECT_EQ(size, hub->edge_count());
+
+      // Only the vertex an edge points at counts, not a copy of it.
+      DAGVertex copy = targets[0]->clone();
+      EXPECT_FALSE(hub->contains_connection_to(copy));
+
+      // The set follows targets that are destroyed or moved.
+      DAGVertex *first = targets[0].get();
+      targets[0].reset();
+      EXPECT_FALSE(hub->contains_connection_to(*first));
+      DAGVertex moved(std::move(*targets[1]));
+      EXPECT_TRUE(hub->contains_connection_to(moved));
+      EXPECT_FALSE(hub->contains_connection_to(*targets[1]));
+
+      // And the hub itself can move without losing it.
+      DAGVertex moved_hub(std::move(*hub));
+      EXPECT_TRUE(moved_hub.contains_connection_to(*targets[2]));
+      EXPECT_FALSE(moved_hub.connect(targets[2]));
+      EXPECT_EQ(size - 1, moved_hub.successors().size());
+      EXPECT_TRUE(hub->successors().empty());
+      EXPECT_EQ(nullptr, hub->successor_set_);
+    }
+
+    TEST_F(TestDagVertex, clear_incomming_edges) {
+      std::shared_ptr<DAGVertex> a = std::make_shared<DAGVertex>("a");
+      std::shared_ptr<DAGVertex> b = std::make_shared<DAGVertex>("b");
+      std::shared_ptr<DAGVertex> c = std::make_shared<DAGVertex>("c");
+      a->connect(b);
+      a->connect(c);
+      b->connect(c);
+
+      c->clear_incomming_edges();
+      EXPECT_EQ(0ul, c->incomming_edge_count());
+      EXPECT_TRUE(c->predecessors().empty());
+      EXPECT_EQ(1ul, a->edge_count());
+      EXPECT_TRUE(a->contains_connection_to(*b));
+      EXPECT_EQ(std::vector<DAGVertex *>{b.get()}, a->successors());
+      EXPECT_EQ(0ul, b->edge_count());
+      EXPECT_TRUE(b->successors().empty());
+    }
+
     TEST_F(TestDagVertex, reset_incomming_edge_count) {
       DAGVertex v("orig");
       v.add_incomming_edge();
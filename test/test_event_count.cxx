@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include "dag_scheduler/event_count.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace com {
+  namespace dag_scheduler {
+    TEST(TestEventCount, times_out_without_notify) {
+      EventCount event_count;
+      // A notify before the wait was announced is not for it.
+      event_count.notify_all();
+      const EventCount::Key_t key = event_count.prepare_wait();
+      EXPECT_FALSE(event_count.wait_until(
+        key, std::chrono::steady_clock::now() + std::chrono::milliseconds(10)
+      ));
+    }
+
+    TEST(TestEventCount, notify_between_prepare_and_wait_is_not_missed) {
+      EventCount event_count;
+      const EventCount::Key_t key = event_count.prepare_wait();
+      event_count.notify_one();
+      EXPECT_TRUE(event_count.wait_until(
+        key, std::chrono::steady_clock::now() + std::chrono::seconds(10)
+      ));
+    }
+
+    TEST(TestEventCount, wakes_every_waiter) {
+      EventCount event_count;
+      std::atomic_bool ready(false);
+      std::atomic<std::size_t> woken(0);
+      std::vector<std::thread> threads;
+      for (std::size_t i = 0; i < 4; ++i) {
+        threads.emplace_back([&]() {
+          while (!ready.load()) {
+            const EventCount::Key_t key = event_count.prepare_wait();
+            if (ready.load()) {
+              event_count.cancel_wait();
+            } else {
+              event_count.wait(key);
+            }
+          }
+          ++woken;
+        });
+      }
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      ready.store(true);
+      event_count.notify_all();
+      for (std::thread &thread : threads) {
+        thread.join();
+      }
+      EXPECT_EQ(4u, woken.load());
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include "dag_scheduler/fan_out_task_stage.h"
+#include "dag_scheduler/task.h"
+
+#include "utils/test_task_stage.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace com {
+  namespace dag_scheduler {
+    namespace detail {
+      // Emits a Task per label it was given when run.
+      class EmittingStage : public FanOutTaskStage {
+      public:
+        EmittingStage(
+          const std::string &label, const std::vector<std::string> &children
+        ) :
+          FanOutTaskStage(label), children_(children), emitted_(0) {}
+
+        virtual bool run() override {
+          for (const std::string &child : children_) {
+            std::vector<std::unique_ptr<TaskStage>> stages;
+            emitted_ += emit(std::make_unique<Task>(stages, child)) ? 1 : 0;
+          }
+          return true;
+        }
+
+        virtual bool is_running() const override { return false; }
+
+        virtual bool end() override { return true; }
+
+        virtual void cleanup() override {}
+
+        virtual std::unique_ptr<TaskStage> clone() const override {
+          return std::make_unique<EmittingStage>(label_, children_);
+        }
+
+        std::size_t emitted() const { return emitted_; }
+
+      private:
+        std::vector<std::string> children_;
+        std::size_t emitted_;
+      };
+    } // namespace detail
+
+    class TestFanOutTaskStage : public ::testing::Test {
+    protected:
+      virtual void SetUp() {}
+
+      virtual void TearDown() {}
+    };
+
+    TEST_F(TestFanOutTaskStage, emit_without_a_dag_drops_children) {
+      detail::EmittingStage stage("stage", {"a", "b"});
+      EXPECT_FALSE(stage.can_emit());
+      EXPECT_TRUE(stage.run());
+      EXPECT_EQ(0u, stage.emitted());
+    }
+
+    TEST_F(TestFanOutTaskStage, task_sets_emit_on_its_fan_out_stages) {
+      std::vector<std::unique_ptr<TaskStage>> stages;
+      stages.push_back(std::make_unique<TestTaskStageImpl>(
+        "plain", std::chrono::nanoseconds(0)
+      ));
+      stages.push_back(std::make_unique<detail::EmittingStage>(
+        "fan_out", std::vector<std::string>{"a", "b", "c"}
+      ));
+      Task task(stages, "task");
+      EXPECT_TRUE(task.fans_out());
+
+      std::vector<std::unique_ptr<Task>> emitted;
+      std::vector<bool> joins;
+      task.set_fan_out_callback(
+        [&](std::unique_ptr<Task> &&child, bool join) {
+          emitted.push_back(std::move(child));
+          joins.push_back(join);
+          return true;
+        }
+      );
+      ASSERT_TRUE(task.iterate_stages([](TaskStage &stage) {
+        return stage.run();
+      }));
+      ASSERT_EQ(3u, emitted.size());
+      EXPECT_EQ("a", emitted[0]->label());
+      EXPECT_EQ("c", emitted[2]->label());
+      EXPECT_EQ(std::vector<bool>(3, true), joins);
+
+      // The callback is not cloned.
+      std::unique_ptr<Task> clone = task.clone();
+      EXPECT_TRUE(clone->fans_out());
+      EXPECT_TRUE(clone->iterate_stages([](TaskStage &stage) {
+        return stage.run();
+      }));
+      EXPECT_EQ(3u, emitted.size());
+
+      std::vector<std::unique_ptr<TaskStage>> plain_stages;
+      plain_stages.push_back(std::make_unique<TestTaskStageImpl>(
+        "plain", std::chrono::nanoseconds(0)
+      ));
+      EXPECT_FALSE(Task(plain_stages, "plain").fans_out());
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include "dag_scheduler/dag.h"
+#include "dag_scheduler/frozen_dag.h"
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace com {
+  namespace dag_scheduler {
+    class TestFrozenDag : public ::testing::Test {
+    protected:
+      virtual void SetUp() {
+        // a -> b, a -> c, b -> d, c -> d
+        std::vector<DAGVertex> vertices;
+        for (const char *label : {"a", "b", "c", "d"}) {
+          vertices.emplace_back(label);
+          uuids_.push_back(vertices.back().get_uuid().as_string());
+        }
+        std::vector<std::pair<UUID, UUID>> edges;
+        edges.emplace_back(UUID(uuids_[0]), UUID(uuids_[1]));
+        edges.emplace_back(UUID(uuids_[0]), UUID(uuids_[2]));
+        edges.emplace_back(UUID(uuids_[1]), UUID(uuids_[3]));
+        edges.emplace_back(UUID(uuids_[2]), UUID(uuids_[3]));
+        ASSERT_TRUE(get_dag().bulk_load(std::move(vertices), edges));
+      }
+
+      virtual void TearDown() { get_dag().reset(); }
+
+      DAG &get_dag() { return d_; }
+
+      UUID uuid(std::size_t i) const { return UUID(uuids_[i]); }
+
+    private:
+      DAG d_;
+      std::vector<std::string> uuids_;
+    };
+
+    TEST_F(TestFrozenDag, layout) {
+      FrozenDAG frozen(get_dag());
+      ASSERT_EQ(4u, frozen.vertex_count());
+      ASSERT_EQ(4u, frozen.edge_count());
+
+      for (FrozenDAG::Index i = 0; i < 4; ++i) {
+        EXPECT_EQ(i, frozen.index_of(uuid(static_cast<std::size_t>(i))));
+        EXPECT_EQ(
+          get_dag()
+            .find_vertex_by_uuid(uuid(static_cast<std::size_t>(i)))
+            .lock(),
+          frozen.vertex(i)
+        );
+      }
+      EXPECT_EQ(FrozenDAG::npos, frozen.index_of(UUID()));
+
+      std::vector<FrozenDAG::Index> a_out(
+        frozen.successors(0).begin(), frozen.successors(0).end()
+      );
+      EXPECT_EQ((std::vector<FrozenDAG::Index>{1, 2}), a_out);
+      std::vector<FrozenDAG::Index> d_in(
+        frozen.predecessors(3).begin(), frozen.predecessors(3).end()
+      );
+      EXPECT_EQ((std::vector<FrozenDAG::Index>{1, 2}), d_in);
+      EXPECT_TRUE(frozen.successors(3).empty());
+      EXPECT_TRUE(frozen.predecessors(0).empty());
+      EXPECT_EQ(1u, frozen.successors(1).size());
+      EXPECT_EQ(3, frozen.successors(1)[0]);
+
+      EXPECT_EQ(
+        (std::vector<FrozenDAG::Index>{0, 1, 1, 2}), frozen.in_degrees()
+      );
+      EXPECT_EQ(2, frozen.in_degree(3));
+    }
+
+    TEST_F(TestFrozenDag, snapshot_is_independent_of_later_edits) {
+      FrozenDAG frozen(get_dag());
+      std::weak_ptr<DAGVertex> b = frozen.vertex(1);
+
+      ASSERT_TRUE(get_dag().remove_vertex_by_uuid(uuid(1)));
+      EXPECT_EQ(4u, frozen.vertex_count());
+      EXPECT_EQ(4u, frozen.edge_count());
+      EXPECT_FALSE(b.expired());
+
+      // Removing b also drops the edge from a, so a new snapshot only sees
+      // a->c and c->d.
+      std::shared_ptr<DAGVertex> a =
+        get_dag().find_vertex_by_uuid(uuid(0)).lock();
+      EXPECT_EQ(1u, a->edge_count());
+      FrozenDAG refrozen(get_dag());
+      EXPECT_EQ(3u, refrozen.vertex_count());
+      EXPECT_EQ(2u, refrozen.edge_count());
+      EXPECT_EQ(FrozenDAG::npos, refrozen.index_of(uuid(1)));
+      EXPECT_EQ(1, refrozen.in_degree(refrozen.index_of(uuid(3))));
+    }
+
+    TEST_F(TestFrozenDag, conditions_by_edge_index) {
+      DAGVertex e("e");
+      DAGVertex e_clone = e.clone();
+      ASSERT_TRUE(get_dag().add_vertex(std::move(e)));
+      std::shared_ptr<DAGVertex> d =
+        get_dag().find_vertex_by_uuid(uuid(3)).lock();
+      ASSERT_TRUE(get_dag().connect(*d, e_clone, [](const Task &) {
+        return false;
+      }));
+
+      FrozenDAG frozen(get_dag());
+      ASSERT_EQ(5u, frozen.edge_count());
+      EXPECT_EQ(1u, frozen.condition_count());
+      EXPECT_EQ(0, frozen.edge_index(0, 0));
+      EXPECT_EQ(1, frozen.edge_index(0, 1));
+      EXPECT_EQ(4, frozen.edge_index(3, 0));
+      for (FrozenDAG::Index edge = 0; edge < 4; ++edge) {
+        EXPECT_EQ(nullptr, frozen.condition(edge));
+      }
+      const DAGEdge::Condition_t *condition =
+        frozen.condition(frozen.edge_index(3, 0));
+      ASSERT_NE(nullptr, condition);
+      EXPECT_FALSE((*condition)(Task()));
+
+      // Copies of the DAG share the condition.
+      DAG copy = get_dag().clone();
+      FrozenDAG frozen_copy(copy);
+      EXPECT_EQ(1u, frozen_copy.condition_count());
+      EXPECT_EQ(
+        condition,
+        frozen_copy.condition(
+          frozen_copy.edge_index(frozen_copy.index_of(uuid(3)), 0)
+        )
+      );
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -6,7 +6,11 @@
 
 #include "utils/test_task.h"
 
+#include <chrono>
 #include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace com {
   namespace dag_scheduler {
@@ -91,5 +95,81 @@ namespace com {
       ts_.set_interrupt();
       ts_.shutdown();
     }
+
+    TEST_F(TestInterruptibleTaskThread, runs_tasks_back_to_back) {
+      std::mutex done_mutex;
+      std::condition_variable done_cond;
+      std::size_t done = 0;
+      auto complete_callback = [&](bool status) {
+        EXPECT_TRUE(status);
+        std::lock_guard<std::mutex> lock(done_mutex);
+        ++done;
+        done_cond.notify_one();
+      };
+
+      for (std::size_t i = 0; i < 3; ++i) {
+        std::unique_ptr<TestTaskImpl> test_task(
+          new TestTaskImpl("test_task", complete_callback)
+        );
+        ASSERT_TRUE(ts_.set_task_and_run(std::move(test_task)));
+        // The slot is taken until the task ran.
+        std::unique_ptr<Task> refused(
+          new TestTaskImpl("refused", complete_callback)
+        );
+        EXPECT_FALSE(ts_.set_task_and_run(std::move(refused)));
+        EXPECT_NE(nullptr, refused);
+
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done_cond.wait(lock, [&]() { return done == i + 1; });
+      }
+      ts_.shutdown();
+      EXPECT_EQ(3, done);
+      EXPECT_FALSE(ts_.was_interrupted());
+
+      // A shut down thread takes tasks again.
+      std::unique_ptr<TestTaskImpl> test_task(
+        new TestTaskImpl("test_task", complete_callback)
+      );
+      ASSERT_TRUE(ts_.set_task_and_run(std::move(test_task)));
+      {
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done_cond.wait(lock, [&]() { return done == 4; });
+      }
+      ts_.shutdown();
+    }
+
+    TEST_F(TestInterruptibleTaskThread, dispatch_rate_benchmark) {
+      const std::size_t count = 2000;
+      std::mutex done_mutex;
+      std::condition_variable done_cond;
+      std::size_t done = 0;
+      auto complete_callback = [&](bool status) {
+        EXPECT_TRUE(status);
+        std::lock_guard<std::mutex> lock(done_mutex);
+        ++done;
+        done_cond.notify_one();
+      };
+
+      const std::chrono::steady_clock::time_point started =
+        std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i < count; ++i) {
+        std::vector<std::unique_ptr<TaskStage>> stages;
+        std::unique_ptr<Task> task(
+          new Task(stages, "empty", complete_callback)
+        );
+        ASSERT_TRUE(ts_.set_task_and_run(std::move(task)));
+        std::unique_lock<std::mutex> lock(done_mutex);
+        done_cond.wait(lock, [&]() { return done == i + 1; });
+      }
+      const std::chrono::duration<double> took =
+        std::chrono::steady_clock::now() - started;
+      ts_.shutdown();
+
+      Logging::info(
+        LOG_TAG, count, "empty tasks in", took.count(), "s,",
+        static_cast<double>(count) / took.count(), "tasks/s"
+      );
+      EXPECT_EQ(count, done);
+    }
   } // namespace dag_scheduler
 } // namespace com
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include "dag_scheduler/label_pool.h"
+
+#include <string>
+#include <utility>
+
+namespace com {
+  namespace dag_scheduler {
+    class TestLabelPool : public ::testing::Test {
+    protected:
+      virtual void SetUp() {}
+
+      virtual void TearDown() {}
+    };
+
+    TEST_F(TestLabelPool, intern_and_find) {
+      LabelPool pool;
+      EXPECT_EQ(0u, pool.size());
+      EXPECT_EQ(LabelPool::npos, pool.find("a"));
+
+      LabelPool::Id a = pool.intern("a");
+      LabelPool::Id b = pool.intern("b");
+      EXPECT_NE(a, b);
+      EXPECT_EQ(a, pool.intern("a"));
+      EXPECT_EQ(a, pool.find("a"));
+      EXPECT_EQ(b, pool.find(std::string("b")));
+      EXPECT_EQ(2u, pool.size());
+      EXPECT_EQ("a", pool.label(a));
+      EXPECT_EQ("b", pool.label(b));
+    }
+
+    TEST_F(TestLabelPool, labels_survive_growth_and_move) {
+      LabelPool pool;
+      LabelPool::Id first = pool.intern("first");
+      const std::string *first_label = &pool.label(first);
+      for (std::size_t i = 0; i < 1000; ++i) {
+        pool.intern(std::to_string(i));
+      }
+      EXPECT_EQ(first_label, &pool.label(first));
+      EXPECT_EQ(first, pool.find("first"));
+
+      LabelPool moved(std::move(pool));
+      EXPECT_EQ(1001u, moved.size());
+      EXPECT_EQ(first, moved.find("first"));
+      EXPECT_EQ("999", moved.label(moved.find("999")));
+    }
+
+    TEST_F(TestLabelPool, clear) {
+      LabelPool pool;
+      pool.intern("a");
+      pool.clear();
+      EXPECT_EQ(0u, pool.size());
+      EXPECT_EQ(LabelPool::npos, pool.find("a"));
+      EXPECT_EQ(0u, pool.intern("b"));
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -37,6 +37,18 @@ namespace com {
       Logging::clear_all();
     }
 
+    TEST_F(TestLogging, remove_logger) {
+      LogTag tag1("tag1");
+
+      Logging::clear_all();
+      EXPECT_FALSE(Logging::remove_logger(tag1));
+      EXPECT_TRUE(Logging::add_std_cout_logger(tag1));
+      EXPECT_TRUE(Logging::remove_logger(tag1));
+      EXPECT_FALSE(Logging::remove_logger(tag1));
+      EXPECT_TRUE(Logging::add_std_cout_logger(tag1));
+      Logging::clear_all();
+    }
+
     TEST_F(TestLogging, does_tag_sink_filtering_work) {
       Logging::add_std_log_logger(LogTag("TAGA"), DAG_SCHEDULER_INFO);
       Logging::debug(LogTag("TAGA"), "Hello World");
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include "dag_scheduler/dag.h"
+#include "dag_scheduler/frozen_dag.h"
+#include "dag_scheduler/reachability_index.h"
+
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace com {
+  namespace dag_scheduler {
+    class TestReachabilityIndex : public ::testing::Test {
+    protected:
+      virtual void SetUp() {}
+
+      virtual void TearDown() { get_dag().reset(); }
+
+      DAG &get_dag() { return d_; }
+
+      // Loads size vertices where each one after the first gets up to
+      // three edges from distinct random earlier vertices.
+      void load_random_dag(std::size_t size) {
+        std::mt19937 gen(7);
+        std::vector<DAGVertex> vertices;
+        std::vector<std::string> uuids;
+        std::vector<std::pair<UUID, UUID>> edges;
+        for (std::size_t i = 0; i < size; ++i) {
+          vertices.emplace_back(std::to_string(i));
+          uuids.push_back(vertices.back().get_uuid().as_string());
+          std::set<std::size_t> picked;
+          for (std::size_t e = 0; i > 0 && e < 3; ++e) {
+            std::uniform_int_distribution<std::size_t> pick(0, i - 1);
+            const std::size_t from = pick(gen);
+            if (picked.insert(from).second) {
+              edges.emplace_back(UUID(uuids[from]), UUID(uuids[i]));
+            }
+          }
+        }
+        ASSERT_TRUE(get_dag().bulk_load(std::move(vertices), edges));
+      }
+
+      // Everything reachable from i by a plain walk, for comparison.
+      static std::vector<bool>
+      walk_from(const FrozenDAG &frozen, FrozenDAG::Index i) {
+        std::vector<bool> ret(frozen.vertex_count(), false);
+        std::vector<FrozenDAG::Index> pending{i};
+        while (!pending.empty()) {
+          FrozenDAG::Index curr = pending.back();
+          pending.pop_back();
+          for (FrozenDAG::Index s : frozen.successors(curr)) {
+            if (!ret[static_cast<std::size_t>(s)]) {
+              ret[static_cast<std::size_t>(s)] = true;
+              pending.push_back(s);
+            }
+          }
+        }
+        return ret;
+      }
+
+    private:
+      DAG d_;
+    };
+
+    TEST_F(TestReachabilityIndex, dense_and_sparse_agree_with_a_walk) {
+      load_random_dag(300);
+      FrozenDAG frozen(get_dag());
+      ReachabilityIndex dense(frozen);
+      ReachabilityIndex sparse(frozen, 0);
+      ASSERT_TRUE(dense.is_dense());
+      ASSERT_FALSE(sparse.is_dense());
+      ASSERT_EQ(frozen.vertex_count(), sparse.vertex_count());
+
+      const FrozenDAG::Index n =
+        static_cast<FrozenDAG::Index>(frozen.vertex_count());
+      std::vector<std::vector<FrozenDAG::Index>> upstream(
+        frozen.vertex_count()
+      );
+      for (FrozenDAG::Index u = 0; u < n; ++u) {
+        std::vector<bool> expected = walk_from(frozen, u);
+        std::vector<FrozenDAG::Index> downstream;
+        for (FrozenDAG::Index v = 0; v < n; ++v) {
+          const bool reachable = expected[static_cast<std::size_t>(v)];
+          ASSERT_EQ(reachable, dense.is_reachable(u, v)) << u << "->" << v;
+          ASSERT_EQ(reachable, sparse.is_reachable(u, v)) << u << "->" << v;
+          if (reachable) {
+            downstream.push_back(v);
+            upstream[static_cast<std::size_t>(v)].push_back(u);
+          }
+        }
+        EXPECT_EQ(downstream, dense.downstream_of(u));
+        EXPECT_EQ(downstream, sparse.downstream_of(u));
+      }
+      for (FrozenDAG::Index v = 0; v < n; ++v) {
+        const std::vector<FrozenDAG::Index> &expected =
+          upstream[static_cast<std::size_t>(v)];
+        EXPECT_EQ(expected, dense.upstream_of(v));
+        EXPECT_EQ(expected, sparse.upstream_of(v));
+      }
+    }
+
+    TEST_F(TestReachabilityIndex, dag_queries_follow_edits) {
+      DAGVertex a("a");
+      DAGVertex b("b");
+      DAGVertex c("c");
+      DAGVertex d("d");
+      DAGVertex a_clone = a.clone();
+      DAGVertex b_clone = b.clone();
+      DAGVertex c_clone = c.clone();
+      DAGVertex d_clone = d.clone();
+      get_dag().add_vertex(std::move(a));
+      get_dag().add_vertex(std::move(b));
+      get_dag().add_vertex(std::move(c));
+      get_dag().add_vertex(std::move(d));
+      ASSERT_TRUE(get_dag().connect(a_clone, b_clone));
+      ASSERT_TRUE(get_dag().connect(b_clone, c_clone));
+
+      EXPECT_TRUE(get_dag().is_reachable(a_clone, c_clone));
+      EXPECT_FALSE(get_dag().is_reachable(c_clone, a_clone));
+      EXPECT_FALSE(get_dag().is_reachable(a_clone, d_clone));
+      EXPECT_FALSE(get_dag().is_reachable(a_clone, a_clone));
+      EXPECT_FALSE(get_dag().is_reachable(a_clone, DAGVertex("x")));
+      std::vector<std::weak_ptr<DAGVertex>> down =
+        get_dag().downstream_of(a_clone);
+      ASSERT_EQ(2u, down.size());
+      EXPECT_EQ("b", down[0].lock()->label());
+      EXPECT_EQ("c", down[1].lock()->label());
+      std::vector<std::weak_ptr<DAGVertex>> up =
+        get_dag().upstream_of(c_clone);
+      ASSERT_EQ(2u, up.size());
+      EXPECT_EQ("a", up[0].lock()->label());
+      EXPECT_TRUE(get_dag().upstream_of(a_clone).empty());
+      EXPECT_TRUE(get_dag().connection_would_make_cyclic(c_clone, a_clone));
+      EXPECT_FALSE(get_dag().connection_would_make_cyclic(a_clone, c_clone));
+
+      // A new edge drops the index, so the next query sees it.
+      ASSERT_TRUE(get_dag().connect(c_clone, d_clone));
+      EXPECT_TRUE(get_dag().is_reachable(a_clone, d_clone));
+      EXPECT_EQ(3u, get_dag().downstream_of(a_clone).size());
+      EXPECT_TRUE(get_dag().connection_would_make_cyclic(d_clone, b_clone));
+
+      ASSERT_TRUE(get_dag().remove_vertex_by_uuid(b_clone.get_uuid()));
+      EXPECT_FALSE(get_dag().is_reachable(a_clone, d_clone));
+      EXPECT_TRUE(get_dag().is_reachable(c_clone, d_clone));
+    }
+
+    TEST_F(TestReachabilityIndex, large_dag_uses_labels) {
+      const std::size_t size = ReachabilityIndex::default_dense_limit + 1;
+      load_random_dag(size);
+      FrozenDAG frozen(get_dag());
+      ReachabilityIndex index(frozen);
+      EXPECT_FALSE(index.is_dense());
+
+      std::mt19937 gen(11);
+      std::uniform_int_distribution<FrozenDAG::Index> pick(
+        0, static_cast<FrozenDAG::Index>(size - 1)
+      );
+      for (std::size_t round = 0; round < 20; ++round) {
+        const FrozenDAG::Index u = pick(gen);
+        std::vector<bool> expected = walk_from(frozen, u);
+        for (std::size_t probe = 0; probe < 50; ++probe) {
+          const FrozenDAG::Index v = pick(gen);
+          ASSERT_EQ(
+            expected[static_cast<std::size_t>(v)], index.is_reachable(u, v)
+          );
+        }
+      }
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include "dag_scheduler/task.h"
+#include "dag_scheduler/task_cost_model.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace com {
+  namespace dag_scheduler {
+    class TestTaskCostModel : public ::testing::Test {
+    protected:
+      virtual void SetUp() {}
+
+      virtual void TearDown() {}
+
+      static std::unique_ptr<Task> make_task(const std::string &label) {
+        std::vector<std::unique_ptr<TaskStage>> stages;
+        return std::make_unique<Task>(stages, label);
+      }
+    };
+
+    TEST_F(TestTaskCostModel, estimate_falls_back) {
+      TaskCostModel model(2.0);
+      std::unique_ptr<Task> task = make_task("a");
+      EXPECT_DOUBLE_EQ(2.0, model.estimate(*task));
+
+      task->set_cost_estimate(5.0);
+      EXPECT_DOUBLE_EQ(5.0, model.estimate(*task));
+      EXPECT_DOUBLE_EQ(5.0, task->clone()->cost_estimate());
+
+      EXPECT_FALSE(model.has_history("a"));
+      model.record(*task, std::chrono::seconds(3));
+      EXPECT_TRUE(model.has_history("a"));
+      EXPECT_DOUBLE_EQ(3.0, model.estimate(*task));
+      // History is by label, so it covers clones and other runs.
+      EXPECT_DOUBLE_EQ(3.0, model.estimate(*make_task("a")));
+      EXPECT_DOUBLE_EQ(2.0, model.estimate(*make_task("b")));
+    }
+
+    TEST_F(TestTaskCostModel, record_smooths) {
+      TaskCostModel model(1.0, 0.5);
+      std::unique_ptr<Task> task = make_task("a");
+      model.record(*task, std::chrono::seconds(4));
+      model.record(*task, std::chrono::seconds(2));
+      EXPECT_DOUBLE_EQ(3.0, model.estimate(*task));
+      model.record(*task, std::chrono::seconds(3));
+      EXPECT_DOUBLE_EQ(3.0, model.estimate(*task));
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include "dag_scheduler/logging.h"
+#include "dag_scheduler/task.h"
+#include "dag_scheduler/task_result_cache.h"
+#include "utils/test_task_stage.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/operations.hpp>
+#include <rapidjson/document.h>
+
+namespace com {
+  namespace dag_scheduler {
+    class TestTaskResultCache : public ::testing::Test {
+    protected:
+      virtual void SetUp() {}
+
+      virtual void TearDown() {}
+
+      static std::unique_ptr<Task> make_task(
+        const std::string &label, const std::vector<std::string> &stages,
+        const std::string &config = "{}"
+      ) {
+        std::vector<std::unique_ptr<TaskStage>> task_stages;
+        for (const std::string &stage : stages) {
+          task_stages.push_back(std::make_unique<TestTaskStageImpl>(stage));
+        }
+        rapidjson::Document json_config;
+        json_config.Parse(config.c_str());
+        rapidjson::Document json_initial_inputs;
+        json_initial_inputs.Parse("{}");
+        return std::make_unique<Task>(
+          task_stages, label, json_config, json_initial_inputs
+        );
+      }
+    };
+
+    TEST_F(TestTaskResultCache, key_is_content) {
+      const std::vector<TaskResultCache::Key> none;
+      std::unique_ptr<Task> a = make_task("a", {"s1", "s2"});
+      const TaskResultCache::Key key = TaskResultCache::key(*a, none);
+      EXPECT_EQ(key, TaskResultCache::key(*a, none));
+      EXPECT_EQ(key, TaskResultCache::key(*a->clone(), none));
+      // The label of the task is only a name.
+      EXPECT_EQ(
+        key, TaskResultCache::key(*make_task("b", {"s1", "s2"}), none)
+      );
+
+      EXPECT_NE(key, TaskResultCache::key(*make_task("a", {"s1"}), none));
+      EXPECT_NE(
+        key, TaskResultCache::key(*make_task("a", {"s2", "s1"}), none)
+      );
+      EXPECT_NE(
+        key,
+        TaskResultCache::key(*make_task("a", {"s1", "s2"}, "{\"x\":1}"), none)
+      );
+
+      const std::vector<TaskResultCache::Key> upstream = {1, 2};
+      EXPECT_NE(key, TaskResultCache::key(*a, upstream));
+      EXPECT_NE(
+        TaskResultCache::key(upstream), TaskResultCache::key({2, 1})
+      );
+      EXPECT_NE(TaskResultCache::key(none), TaskResultCache::key({0}));
+    }
+
+    TEST_F(TestTaskResultCache, config_member_order_does_not_matter) {
+      const std::vector<TaskResultCache::Key> none;
+      EXPECT_EQ(
+        TaskResultCache::key(
+          *make_task("a", {"s"}, "{\"x\":1,\"y\":{\"b\":2,\"a\":3}}"), none
+        ),
+        TaskResultCache::key(
+          *make_task("a", {"s"}, "{\"y\":{\"a\":3,\"b\":2},\"x\":1}"), none
+        )
+      );
+    }
+
+    TEST_F(TestTaskResultCache, memory_evicts_least_recently_used) {
+      TaskResultCache cache(2);
+      EXPECT_FALSE(cache.contains(1));
+      cache.insert(1);
+      cache.insert(2);
+      EXPECT_TRUE(cache.contains(1));
+      // 2 is now the least recently used.
+      cache.insert(3);
+      EXPECT_TRUE(cache.contains(1));
+      EXPECT_FALSE(cache.contains(2));
+      EXPECT_TRUE(cache.contains(3));
+
+      TaskResultCache::Stats stats = cache.stats();
+      EXPECT_EQ(3u, stats.hits);
+      EXPECT_EQ(2u, stats.misses);
+      EXPECT_EQ(0u, stats.disk_hits);
+      EXPECT_EQ(2u, stats.memory_entries);
+
+      cache.clear_memory();
+      EXPECT_FALSE(cache.contains(1));
+      EXPECT_EQ(0u, cache.stats().memory_entries);
+    }
+
+    TEST_F(TestTaskResultCache, disk_outlives_memory) {
+      const boost::filesystem::path directory =
+        Logging::mktmpdir() / "task_result_cache";
+      {
+        TaskResultCache cache(1, directory);
+        cache.insert(1);
+        cache.insert(2);
+        EXPECT_EQ(1u, cache.stats().memory_entries);
+        EXPECT_TRUE(cache.contains(1));
+        EXPECT_EQ(1u, cache.stats().disk_hits);
+      }
+
+      TaskResultCache cache(4, directory);
+      EXPECT_TRUE(cache.contains(1));
+      EXPECT_TRUE(cache.contains(2));
+      EXPECT_FALSE(cache.contains(3));
+      EXPECT_EQ(2u, cache.stats().disk_hits);
+      EXPECT_EQ(2u, cache.stats().memory_entries);
+      // Kept in memory after the first disk hit.
+      EXPECT_TRUE(cache.contains(1));
+      EXPECT_EQ(2u, cache.stats().disk_hits);
+
+      boost::filesystem::remove_all(directory.parent_path());
+    }
+
+    TEST_F(TestTaskResultCache, insert_writes_each_key_once) {
+      const boost::filesystem::path directory =
+        Logging::mktmpdir() / "task_result_cache";
+      const boost::filesystem::path path = directory / "0000000000000001";
+      auto read = [&]() {
+        std::ifstream in(path.string());
+        std::string ret;
+        std::getline(in, ret);
+        return ret;
+      };
+      auto overwrite = [&]() {
+        std::ofstream out(path.string(), std::ios::trunc);
+        out << "kept" << std::endl;
+      };
+
+      // Once in memory, and with nothing kept in memory.
+      for (std::size_t memory_capacity : {4u, 0u}) {
+        TaskResultCache cache(memory_capacity, directory);
+        cache.insert(1);
+        ASSERT_TRUE(boost::filesystem::exists(path));
+        overwrite();
+        cache.insert(1);
+        EXPECT_EQ("kept", read());
+        boost::filesystem::remove(path);
+      }
+
+      boost::filesystem::remove_all(directory.parent_path());
+    }
+  } // namespace dag_scheduler
+} // namespace com
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include "dag_scheduler/work_stealing_deque.h"
+
+#include "utils/test_task.h"
+
+#include <atomic>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace com {
+  namespace dag_scheduler {
+    namespace detail {
+      std::unique_ptr<Task> labeled(std::size_t i) {
+        return std::unique_ptr<Task>(new TestTaskImpl(std::to_string(i)));
+      }
+    } // namespace detail
+
+    TEST(TestWorkStealingDeque, empty) {
+      WorkStealingDeque deque;
+      std::unique_ptr<Task> task;
+      EXPECT_TRUE(deque.empty());
+      EXPECT_FALSE(deque.pop(task));
+      EXPECT_FALSE(deque.steal(task));
+      EXPECT_EQ(nullptr, task);
+    }
+
+    TEST(TestWorkStealingDeque, pop_is_lifo_and_steal_is_fifo) {
+      WorkStealingDeque deque;
+      for (std::size_t i = 0; i < 4; ++i) {
+        deque.push(detail::labeled(i));
+      }
+      EXPECT_FALSE(deque.empty());
+
+      std::unique_ptr<Task> task;
+      ASSERT_TRUE(deque.pop(task));
+      EXPECT_EQ("3", task->label());
+      ASSERT_TRUE(deque.steal(task));
+      EXPECT_EQ("0", task->label());
+      ASSERT_TRUE(deque.pop(task));
+      EXPECT_EQ("2", task->label());
+      ASSERT_TRUE(deque.steal(task));
+      EXPECT_EQ("1", task->label());
+      EXPECT_TRUE(deque.empty());
+      EXPECT_FALSE(deque.pop(task));
+    }
+
+    TEST(TestWorkStealingDeque, grows_past_its_capacity) {
+      const std::size_t count = 100;
+      WorkStealingDeque deque(2);
+      for (std::size_t i = 0; i < count; ++i) {
+        deque.push(detail::labeled(i));
+      }
+      std::unique_ptr<Task> task;
+      for (std::size_t i = 0; i < count; ++i) {
+        ASSERT_TRUE(deque.steal(task));
+        EXPECT_EQ(std::to_string(i), task->label());
+      }
+      EXPECT_TRUE(deque.empty());
+    }
+
+    TEST(TestWorkStealingDeque, each_task_is_taken_once) {
+      const std::size_t count = 2000;
+      const std::size_t thieves = 3;
+      WorkStealingDeque deque(4);
+      std::atomic_bool done(false);
+      std::vector<std::vector<std::string>> stolen(thieves);
+      std::vector<std::thread> threads;
+      for (std::size_t t = 0; t < thieves; ++t) {
+        threads.emplace_back([&, t]() {
+          std::unique_ptr<Task> task;
+          while (!done.load() || !deque.empty()) {
+            if (deque.steal(task)) {
+              stolen[t].push_back(task->label());
+            } else {
+              std::this_thread::yield();
+            }
+          }
+        });
+      }
+
+      // The owner pops every other push, so it races thieves for the last.
+      std::vector<std::string> popped;
+      std::unique_ptr<Task> task;
+      for (std::size_t i = 0; i < count; ++i) {
+        deque.push(detail::labeled(i));
+        if (i % 2 == 0 && deque.pop(task)) {
+          popped.push_back(task->label());
+        }
+      }
+      done.store(true);
+      for (std::thread &thread : threads) {
+        thread.join();
+      }
+
+      std::set<std::string> taken(popped.begin(), popped.end());
+      std::size_t total = popped.size();
+      for (const std::vector<std::string> &labels : stolen) {
+        taken.insert(labels.begin(), labels.end());
+        total += labels.size();
+      }
+      EXPECT_EQ(count, total);
+      EXPECT_EQ(count, taken.size());
+    }
+  } // namespace dag_scheduler
+} // namespace com